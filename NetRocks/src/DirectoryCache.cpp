@@ -0,0 +1,366 @@
+#include <utils.h>
+#include <crc64.h>
+#include <Threaded.h>
+#include "DirectoryCache.h"
+#include "PooledStrings.h"
+#include "Host/IPC.h"
+#include "Op/OpBase.h"
+#include "Op/OpEnumDirectory.h"
+
+#define DIRECTORY_CACHE_MAGIC        0x4e524301
+#define DIRECTORY_CACHE_EXPIRATION   (60 * 60 * 24 * 30)
+
+static bool IsSameIdentity(IHost *a, IHost *b)
+{
+	IHost::Identity ia, ib;
+	a->GetIdentity(ia);
+	b->GetIdentity(ib);
+	return ia.protocol == ib.protocol && ia.host == ib.host
+		&& ia.port == ib.port && ia.username == ib.username;
+}
+
+static std::string SiteCacheSubpath(IHost *host)
+{
+	IHost::Identity identity;
+	host->GetIdentity(identity);
+	const std::string &str = StrPrintf("%s://%s@%s:%u",
+		identity.protocol.c_str(), identity.username.c_str(), identity.host.c_str(), identity.port);
+	return StrPrintf("NetRocks/dircache/%llx",
+		(unsigned long long)crc64(0, (const unsigned char *)str.data(), str.size()));
+}
+
+static std::string CacheFilePath(IHost *host, const std::string &dir, bool create_path)
+{
+	std::string subpath = SiteCacheSubpath(host);
+	subpath+= StrPrintf("/%llx",
+		(unsigned long long)crc64(0, (const unsigned char *)dir.data(), dir.size()));
+	return InMyCache(subpath.c_str(), create_path);
+}
+
+static bool IsSameTime(const timespec &a, const timespec &b)
+{
+	return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+static bool IsZeroTime(const timespec &t)
+{
+	return t.tv_sec == 0 && t.tv_nsec == 0;
+}
+
+static void SerializeListing(std::vector<char> &listing, const PluginPanelItem *items, int count)
+{
+	IPCFrameWriter w(listing);
+	w.PutPOD((uint32_t)count);
+	std::string str;
+	for (int i = 0; i < count; ++i) {
+		const auto &fd = items[i].FindData;
+		Wide2MB(fd.lpwszFileName, str);
+		w.PutString(str);
+		str.clear();
+		if (items[i].Owner) {
+			Wide2MB(items[i].Owner, str);
+		}
+		w.PutString(str);
+		str.clear();
+		if (items[i].Group) {
+			Wide2MB(items[i].Group, str);
+		}
+		w.PutString(str);
+		w.PutPOD((uint64_t)fd.nFileSize);
+		w.PutPOD((uint32_t)fd.dwUnixMode);
+		w.PutPOD((uint32_t)fd.dwFileAttributes);
+		w.PutPOD(fd.ftCreationTime);
+		w.PutPOD(fd.ftLastAccessTime);
+		w.PutPOD(fd.ftLastWriteTime);
+	}
+}
+
+static void DeserializeListing(const std::vector<char> &listing, PluginPanelItems &result)
+{
+	IPCFrameReader r(listing);
+	uint32_t count;
+	r.GetPOD(count);
+	std::string name, owner, group;
+	for (uint32_t i = 0; i < count; ++i) {
+		r.GetString(name);
+		r.GetString(owner);
+		r.GetString(group);
+		uint64_t size;
+		uint32_t mode, attributes;
+		r.GetPOD(size);
+		r.GetPOD(mode);
+		r.GetPOD(attributes);
+		auto *ppi = result.Add(name.c_str());
+		ppi->FindData.nFileSize = size;
+		ppi->FindData.dwUnixMode = mode;
+		ppi->FindData.dwFileAttributes = attributes;
+		ppi->Owner = (wchar_t *)MB2WidePooled(owner);
+		ppi->Group = (wchar_t *)MB2WidePooled(group);
+		r.GetPOD(ppi->FindData.ftCreationTime);
+		r.GetPOD(ppi->FindData.ftLastAccessTime);
+		r.GetPOD(ppi->FindData.ftLastWriteTime);
+	}
+}
+
+// File layout: magic, directory path (to detect hash collisions), its modification time, listing
+static bool LoadCacheFile(const std::string &path, const std::string &dir, timespec &dir_mtime, std::vector<char> &listing)
+{
+	std::string content;
+	if (!CachedFileLoad(path, content)) {
+		return false;
+	}
+
+	try {
+		std::vector<char> frame(content.begin(), content.end());
+		IPCFrameReader r(frame);
+		uint32_t magic;
+		r.GetPOD(magic);
+		if (magic != DIRECTORY_CACHE_MAGIC) {
+			return false;
+		}
+		std::string cached_dir;
+		r.GetString(cached_dir);
+		if (cached_dir != dir) {
+			return false;
+		}
+		int64_t sec, nsec;
+		r.GetPOD(sec);
+		r.GetPOD(nsec);
+		dir_mtime.tv_sec = (time_t)sec;
+		dir_mtime.tv_nsec = (long)nsec;
+		listing.assign(frame.begin() + r.pos, frame.end());
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "DirectoryCache: '%s' - %s\n", path.c_str(), e.what());
+		return false;
+	}
+
+	return true;
+}
+
+static void SaveCacheFile(const std::string &path, const std::string &dir, const timespec &dir_mtime, const std::vector<char> &listing)
+{
+	std::vector<char> frame;
+	IPCFrameWriter w(frame);
+	w.PutPOD((uint32_t)DIRECTORY_CACHE_MAGIC);
+	w.PutString(dir);
+	w.PutPOD((int64_t)dir_mtime.tv_sec);
+	w.PutPOD((int64_t)dir_mtime.tv_nsec);
+	w.Put(listing.data(), listing.size());
+
+	CachedFileSave(path, frame.data(), frame.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class DirectoryCache::Revalidation : protected Threaded
+{
+	std::shared_ptr<IHost> _host;
+	std::string _dir, _path;
+	timespec _cached_mtime;
+	std::vector<char> _cached_listing;
+	bool _changed = false, _aborted = false;
+
+	void Revalidate()
+	{
+		FileInformation file_info{};
+		_host->GetInformation(file_info, _dir);
+		if (!IsZeroTime(_cached_mtime) && IsSameTime(_cached_mtime, file_info.modification_time)) {
+			return;
+		}
+
+		PluginPanelItems ppis;
+		{
+			std::shared_ptr<IDirectoryEnumer> enumer = _host->DirectoryEnum(_dir);
+			std::string name, owner, group;
+			FileInformation entry_info;
+			while (enumer->Enum(name, owner, group, entry_info)) {
+				EnumDirectoryAddItem(ppis, name, owner, group, entry_info);
+			}
+		}
+		EnumDirectoryResolveSymlinks(_host.get(), _dir, ppis, 0, [] () {});
+
+		std::vector<char> listing;
+		SerializeListing(listing, ppis.items, ppis.count);
+		_changed = (listing != _cached_listing);
+		if (_changed || !IsSameTime(_cached_mtime, file_info.modification_time)) {
+			SaveCacheFile(_path, _dir, file_info.modification_time, listing);
+		}
+	}
+
+	virtual void *ThreadProc()
+	{
+		try {
+			Revalidate();
+
+		} catch (std::exception &e) {
+			fprintf(stderr, "DirectoryCache::Revalidation('%s'): %s\n", _dir.c_str(), e.what());
+			return this;
+		}
+
+		fprintf(stderr, "DirectoryCache::Revalidation('%s'): changed=%d\n", _dir.c_str(), _changed);
+		return nullptr;
+	}
+
+public:
+	Revalidation(std::shared_ptr<IHost> &host, const std::string &dir, const std::string &path,
+		const timespec &cached_mtime, std::vector<char> &cached_listing)
+		:
+		_host(host), _dir(dir), _path(path), _cached_mtime(cached_mtime)
+	{
+		_cached_listing.swap(cached_listing);
+		if (!StartThread()) {
+			throw std::runtime_error("StartThread failed");
+		}
+	}
+
+	virtual ~Revalidation()
+	{
+		Stop();
+	}
+
+	// aborts revalidation if it still in progress, returns host if it still usable
+	std::shared_ptr<IHost> Stop()
+	{
+		if (!WaitThread(0)) {
+			_aborted = true;
+			_host->Abort();
+			WaitThread();
+		}
+		if (_aborted || GetThreadResult() != nullptr) {
+			return std::shared_ptr<IHost>();
+		}
+		return _host;
+	}
+
+	inline bool Finished() { return WaitThread(0); }
+	inline bool Changed() const { return _changed; }
+	inline const std::string &Dir() const { return _dir; }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DirectoryCache::DirectoryCache()
+{
+}
+
+DirectoryCache::~DirectoryCache()
+{
+	Reset();
+}
+
+void DirectoryCache::AllowCached()
+{
+	_allow_cached = true;
+}
+
+void DirectoryCache::StopRevalidation()
+{
+	if (_revalidation) {
+		_revalidation_host = _revalidation->Stop();
+		_revalidation.reset();
+	}
+}
+
+void DirectoryCache::Reset()
+{
+	StopRevalidation();
+	_revalidation_host.reset();
+	_listed_dir.clear();
+	_revalidated_dir.clear();
+	_allow_cached = false;
+}
+
+bool DirectoryCache::Fetch(int op_mode, std::shared_ptr<IHost> &host, const std::string &dir, PluginPanelItems &result)
+{
+	if (IS_SILENT(op_mode)) {
+		return false;
+	}
+
+	const bool allow_cached = _allow_cached;
+	const bool serve_revalidated = (_revalidated_dir == dir);
+	_allow_cached = false;
+	_revalidated_dir.clear();
+	_listed_dir = dir;
+
+	if ((!allow_cached && !serve_revalidated) || !host->PersistentDirectoryCache()) {
+		return false;
+	}
+
+	const std::string &path = CacheFilePath(host.get(), dir, false);
+	timespec dir_mtime{};
+	std::vector<char> listing;
+	if (!LoadCacheFile(path, dir, dir_mtime, listing)) {
+		return false;
+	}
+
+	const int initial_count = result.count;
+	try {
+		DeserializeListing(listing, result);
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "DirectoryCache::Fetch('%s'): %s\n", dir.c_str(), e.what());
+		result.Shrink(initial_count);
+		return false;
+	}
+
+	if (!serve_revalidated) try {
+		StopRevalidation();
+		std::shared_ptr<IHost> revalidation_host;
+		revalidation_host.swap(_revalidation_host);
+		if (!revalidation_host || !IsSameIdentity(revalidation_host.get(), host.get())) {
+			revalidation_host = host->Clone();
+		}
+		_revalidation.reset(new Revalidation(revalidation_host, dir, path, dir_mtime, listing));
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "DirectoryCache::Fetch('%s'): %s\n", dir.c_str(), e.what());
+	}
+
+	return true;
+}
+
+timespec DirectoryCache::QueryModificationTime(int op_mode, std::shared_ptr<IHost> &host, const std::string &dir)
+{
+	FileInformation file_info{};
+	if (!IS_SILENT(op_mode) && host->PersistentDirectoryCache()) try {
+		host->GetInformation(file_info, dir);
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "DirectoryCache::QueryModificationTime('%s'): %s\n", dir.c_str(), e.what());
+		file_info.modification_time = timespec{};
+	}
+
+	return file_info.modification_time;
+}
+
+void DirectoryCache::Store(int op_mode, std::shared_ptr<IHost> &host, const std::string &dir,
+	const timespec &dir_mtime, const PluginPanelItem *items, int count)
+{
+	if (IS_SILENT(op_mode) || !host->PersistentDirectoryCache()) {
+		return;
+	}
+
+	// live listing supersedes result of revalidation that could be still in progress
+	_listed_dir.clear();
+
+	std::vector<char> listing;
+	SerializeListing(listing, items, count);
+	const std::string &path = CacheFilePath(host.get(), dir, true);
+	SaveCacheFile(path, dir, dir_mtime, listing);
+	CachedFilesPrune(SiteCacheSubpath(host.get()).c_str(), DIRECTORY_CACHE_EXPIRATION);
+}
+
+bool DirectoryCache::CheckRevalidated()
+{
+	if (!_revalidation || !_revalidation->Finished()) {
+		return false;
+	}
+
+	const bool changed = _revalidation->Changed() && _revalidation->Dir() == _listed_dir;
+	if (changed) {
+		_revalidated_dir = _listed_dir;
+	}
+	StopRevalidation();
+	return changed;
+}
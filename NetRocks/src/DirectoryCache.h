@@ -0,0 +1,50 @@
+#pragma once
+#include <time.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include "Host/Host.h"
+#include "PluginPanelItems.h"
+
+/// Optional persistent cache of remote directories listings, kept per site in local cache directory.
+/// When panel enters directory its cached listing shown instantly while own connection revalidates
+/// it in background: by directory's modification time if protocol reports it, otherwise by comparing
+/// with fresh listing. If listing appears changed - it's saved to cache and panel gets updated in place.
+class DirectoryCache
+{
+	class Revalidation;
+
+	std::unique_ptr<Revalidation> _revalidation;
+	std::shared_ptr<IHost> _revalidation_host; // reused by subsequent revalidations of same site
+	std::string _listed_dir, _revalidated_dir;
+	bool _allow_cached = false;
+
+	void StopRevalidation();
+
+public:
+	DirectoryCache();
+	~DirectoryCache();
+
+	/// Called when panel changed directory, so next listing may be served from cache.
+	/// Listings requested after that (like refresh after some operation) are done live.
+	void AllowCached();
+
+	/// Stops background revalidation and forgets revalidation connection, used when leaving site.
+	void Reset();
+
+	/// Appends cached listing of dir to result and starts its revalidation,
+	/// returns false if listing not in cache or cache is not used for this site or op_mode.
+	bool Fetch(int op_mode, std::shared_ptr<IHost> &host, const std::string &dir, PluginPanelItems &result);
+
+	/// Returns modification time of dir to be passed to Store() with listing obtained after this call,
+	/// zero time returned if it's unknown or cache is not used for this site or op_mode.
+	timespec QueryModificationTime(int op_mode, std::shared_ptr<IHost> &host, const std::string &dir);
+
+	/// Saves live listing of dir to cache if cache is used for this site and op_mode.
+	void Store(int op_mode, std::shared_ptr<IHost> &host, const std::string &dir,
+		const timespec &dir_mtime, const PluginPanelItem *items, int count);
+
+	/// Returns true once if background revalidation found listing of last listed directory changed,
+	/// so panel should be updated and then next Fetch() will serve revalidated listing.
+	bool CheckRevalidated();
+};
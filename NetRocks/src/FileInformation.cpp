@@ -0,0 +1,275 @@
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include "FileInformation.h"
+
+Path2FileInformation::Path2FileInformation()
+{
+	clear();
+}
+
+void Path2FileInformation::clear()
+{
+	_nodes_chunks.clear();
+	_nodes_count = 0;
+	_names.clear();
+	_index.clear();
+	_last_dir.clear();
+	_last_dir_node = 0;
+	NewNode(0, 0, nullptr, 0);
+	_order.clear();
+	_order_valid = true;
+	_count = 0;
+}
+
+// FNV-1a over parent's index and name bytes
+uint32_t Path2FileInformation::Hash(uint32_t parent, const char *name, size_t len)
+{
+	uint32_t h = 2166136261u;
+	for (unsigned int i = 0; i < sizeof(parent); ++i) {
+		h = (h ^ ((parent >> (i * 8)) & 0xff)) * 16777619u;
+	}
+	for (size_t i = 0; i < len; ++i) {
+		h = (h ^ (unsigned char)name[i]) * 16777619u;
+	}
+	return h;
+}
+
+// returns slot of node with given parent and name or empty slot where such node should be placed
+size_t Path2FileInformation::Slot(uint32_t hash, uint32_t parent, const char *name, size_t len) const
+{
+	const size_t mask = _index.size() - 1;
+	for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+		const uint32_t ni = _index[slot];
+		if (ni == 0) {
+			return slot;
+		}
+		const auto &n = N(ni);
+		if (n.hash == hash && n.parent == parent && n.name_len == len
+				&& memcmp(_names.data() + n.name_ofs, name, len) == 0) {
+			return slot;
+		}
+	}
+}
+
+void Path2FileInformation::Rehash(size_t slots)
+{
+	_index.assign(slots, 0);
+	const size_t mask = slots - 1;
+	for (uint32_t i = 1; i < _nodes_count; ++i) {
+		size_t slot = N(i).hash & mask;
+		while (_index[slot] != 0) {
+			slot = (slot + 1) & mask;
+		}
+		_index[slot] = i;
+	}
+}
+
+uint32_t Path2FileInformation::NewNode(uint32_t hash, uint32_t parent, const char *name, size_t len)
+{
+	if (_nodes_count == 0xffffffff || _names.size() + len >= 0xffffffff || len >= 0x80000000) {
+		throw std::length_error("Path2FileInformation: too many entries");
+	}
+	if ((_nodes_count >> NODES_CHUNK_SHIFT) == _nodes_chunks.size()) {
+		_nodes_chunks.emplace_back(new Node[1 << NODES_CHUNK_SHIFT]);
+	}
+	auto &n = N(_nodes_count);
+	n.parent = parent;
+	n.name_ofs = (uint32_t)_names.size();
+	n.name_len = (uint32_t)len;
+	n.valid = 0;
+	n.hash = hash;
+	_names.insert(_names.end(), name, name + len);
+	return _nodes_count++;
+}
+
+uint32_t Path2FileInformation::Find(const std::string &path) const
+{
+	if (_index.empty()) {
+		return 0;
+	}
+
+	uint32_t node = 0;
+	for (size_t i = 0, ii = 0; i <= path.size(); ++i) {
+		if (i == path.size() || path[i] == '/') {
+			const uint32_t ni = _index[Slot(Hash(node, path.data() + ii, i - ii), node, path.data() + ii, i - ii)];
+			if (ni == 0) {
+				return 0;
+			}
+			node = ni;
+			ii = i + 1;
+		}
+	}
+
+	return node;
+}
+
+uint32_t Path2FileInformation::Insert(const std::string &path)
+{
+	// start from deepest directory in common with path of previous insertion
+	while (_last_dir_node != 0 && (path.size() <= _last_dir.size()
+			|| path.compare(0, _last_dir.size(), _last_dir) != 0)) {
+		_last_dir.resize(_last_dir.size() - N(_last_dir_node).name_len - 1);
+		_last_dir_node = N(_last_dir_node).parent;
+	}
+
+	uint32_t node = _last_dir_node;
+	size_t ii = _last_dir.size();
+
+	const size_t last_slash = path.rfind('/');
+	for (size_t i = ii; i <= path.size(); ++i) {
+		if (i == path.size() || path[i] == '/') {
+			// keep load factor under 1/2 so probing sequences remain short
+			if ((size_t(_nodes_count) + 1) * 2 > _index.size()) {
+				Rehash(std::max(_index.size() * 2, (size_t)0x100));
+			}
+			const uint32_t hash = Hash(node, path.data() + ii, i - ii);
+			const size_t slot = Slot(hash, node, path.data() + ii, i - ii);
+			if (_index[slot] == 0) {
+				_index[slot] = NewNode(hash, node, path.data() + ii, i - ii);
+			}
+			node = _index[slot];
+			ii = i + 1;
+			if (i == last_slash) {
+				_last_dir.assign(path, 0, ii);
+				_last_dir_node = node;
+			}
+		}
+	}
+
+	return node;
+}
+
+bool Path2FileInformation::emplace(const std::string &path, const FileInformation &info)
+{
+	auto &n = N(Insert(path));
+	if (n.valid) {
+		return false;
+	}
+
+	n.valid = 1;
+	n.info = info;
+	++_count;
+	_order_valid = false;
+	return true;
+}
+
+size_t Path2FileInformation::count(const std::string &path) const
+{
+	const uint32_t node = Find(path);
+	return (node != 0 && N(node).valid) ? 1 : 0;
+}
+
+void Path2FileInformation::BuildOrder()
+{
+	// lay out children lists contiguously: children of node N are kids[first[N] .. first[N + 1])
+	std::vector<uint32_t> first(size_t(_nodes_count) + 1, 0);
+	for (uint32_t i = 1; i < _nodes_count; ++i) {
+		++first[N(i).parent + 1];
+	}
+	for (size_t i = 1; i < first.size(); ++i) {
+		first[i]+= first[i - 1];
+	}
+
+	std::vector<uint32_t> kids(_nodes_count);
+	{
+		std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+		for (uint32_t i = 1; i < _nodes_count; ++i) {
+			kids[fill[N(i).parent]++] = i;
+		}
+	}
+
+	// same order as std::string comparison gives
+	const auto &name_less = [&](uint32_t a, uint32_t b) -> bool {
+		const auto &na = N(a), &nb = N(b);
+		const int r = memcmp(_names.data() + na.name_ofs, _names.data() + nb.name_ofs, std::min(na.name_len, nb.name_len));
+		return r < 0 || (r == 0 && na.name_len < nb.name_len);
+	};
+
+	_order.clear();
+	_order.reserve(_count);
+	std::vector<uint32_t> stack(1, 0);
+	while (!stack.empty()) {
+		const uint32_t node = stack.back();
+		stack.pop_back();
+		if (N(node).valid) {
+			_order.emplace_back(node);
+		}
+		const auto kids_begin = kids.begin() + first[node], kids_end = kids.begin() + first[node + 1];
+		std::sort(kids_begin, kids_end, name_less);
+		stack.insert(stack.end(), std::reverse_iterator<std::vector<uint32_t>::iterator>(kids_end),
+			std::reverse_iterator<std::vector<uint32_t>::iterator>(kids_begin));
+	}
+
+	_order_valid = true;
+}
+
+// assembles path of node, reusing path of prev_node if its sibling or parent as iteration typically goes
+void Path2FileInformation::AssemblePath(std::string &path, uint32_t node, uint32_t prev_node) const
+{
+	const auto &n = N(node);
+	if (prev_node != 0 && n.parent != 0) {
+		if (N(prev_node).parent == n.parent) {
+			path.resize(path.size() - N(prev_node).name_len);
+			path.append(_names.data() + n.name_ofs, n.name_len);
+			return;
+		}
+		if (prev_node == n.parent) {
+			path+= '/';
+			path.append(_names.data() + n.name_ofs, n.name_len);
+			return;
+		}
+	}
+
+	size_t len = 0;
+	for (uint32_t i = node; i != 0; i = N(i).parent) {
+		len+= N(i).name_len + 1;
+	}
+
+	path.resize(len ? len - 1 : 0);
+	size_t pos = path.size();
+	for (uint32_t i = node; i != 0; i = N(i).parent) {
+		const auto &nd = N(i);
+		pos-= nd.name_len;
+		memcpy(&path[pos], _names.data() + nd.name_ofs, nd.name_len);
+		if (nd.parent != 0) {
+			path[--pos] = '/';
+		}
+	}
+}
+
+Path2FileInformation::iterator Path2FileInformation::begin()
+{
+	if (!_order_valid) {
+		BuildOrder();
+	}
+	return iterator(this, 0, 1);
+}
+
+Path2FileInformation::iterator Path2FileInformation::end()
+{
+	return iterator(this, (ssize_t)_count, 1);
+}
+
+Path2FileInformation::iterator Path2FileInformation::rbegin()
+{
+	if (!_order_valid) {
+		BuildOrder();
+	}
+	return iterator(this, (ssize_t)_count - 1, -1);
+}
+
+Path2FileInformation::iterator Path2FileInformation::rend()
+{
+	return iterator(this, -1, -1);
+}
+
+Path2FileInformation::Entry Path2FileInformation::iterator::operator*() const
+{
+	const uint32_t node = _container->_order[_pos];
+	if (_path_node != node) {
+		_container->AssemblePath(_path, node, _path_node);
+		_path_node = node;
+	}
+	return Entry{_path, _container->N(node).info};
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
+#include <memory>
+#include <stdint.h>
 # include <sys/types.h>
 # include <sys/stat.h>
 
@@ -16,5 +19,103 @@ struct FileInformation
 	mode_t mode;
 };
 
-typedef std::map<std::string, FileInformation> Path2FileInformation;
+/// Maps paths to FileInformation-s, used to keep results of enumerating huge trees.
+/// Instead of keeping full path per each entry paths split by '/' into components
+/// that form tree of nodes, so each component stored once in common names arena.
+/// Iteration goes depth-first with siblings ordered by name, so any directory comes
+/// before its content on forward iteration and after it on reverse iteration.
+/// Iterators assemble paths on the fly and invalidated by emplace(), however
+/// references to FileInformation-s remain valid till container destroyed.
+class Path2FileInformation
+{
+	struct Node
+	{
+		uint32_t parent;
+		uint32_t name_ofs;
+		uint32_t name_len : 31;
+		uint32_t valid : 1; // zero if node is just a component of some other paths
+		uint32_t hash; // of parent and name, so rehashing and probing mostly don't need to compare names
+		FileInformation info;
+	};
+
+	enum { NODES_CHUNK_SHIFT = 12 };
+
+	// nodes kept in fixed size chunks, so growth doesn't relocate them, very first node is root of tree
+	std::vector<std::unique_ptr<Node[]> > _nodes_chunks;
+	uint32_t _nodes_count = 0;
+	std::vector<char> _names;
+	std::vector<uint32_t> _index; // open addressing hash of nodes by (parent, name), zero means empty slot
+	size_t _count = 0;
+
+	// entries typically added during depth-first walk, so remember last directory to skip walking to it
+	std::string _last_dir;
+	uint32_t _last_dir_node = 0;
+
+	std::vector<uint32_t> _order; // valid nodes in order of iteration, rebuilt when needed
+	bool _order_valid = true;
+
+	static uint32_t Hash(uint32_t parent, const char *name, size_t len);
+	size_t Slot(uint32_t hash, uint32_t parent, const char *name, size_t len) const;
+	void Rehash(size_t slots);
+	uint32_t Find(const std::string &path) const;
+	uint32_t Insert(const std::string &path);
+	void BuildOrder();
+	void AssemblePath(std::string &path, uint32_t node, uint32_t prev_node) const;
+	uint32_t NewNode(uint32_t hash, uint32_t parent, const char *name, size_t len);
+
+	inline Node &N(uint32_t i) { return _nodes_chunks[i >> NODES_CHUNK_SHIFT][i & ((1 << NODES_CHUNK_SHIFT) - 1)]; }
+	inline const Node &N(uint32_t i) const { return _nodes_chunks[i >> NODES_CHUNK_SHIFT][i & ((1 << NODES_CHUNK_SHIFT) - 1)]; }
+
+public:
+	// second refers to information stored in container, so it can be altered in place
+	struct Entry
+	{
+		const std::string &first;
+		FileInformation &second;
+	};
+
+	class iterator
+	{
+		friend class Path2FileInformation;
+
+		Path2FileInformation *_container;
+		ssize_t _pos, _step;
+		mutable uint32_t _path_node = 0; // node _path assembled for
+		mutable std::string _path;
 
+		iterator(Path2FileInformation *container, ssize_t pos, ssize_t step)
+			: _container(container), _pos(pos), _step(step) {}
+
+	public:
+		struct Arrow
+		{
+			Entry entry;
+			const Entry *operator->() const { return &entry; }
+		};
+
+		Entry operator*() const;
+		Arrow operator->() const { return Arrow{**this}; }
+
+		iterator &operator++() { _pos+= _step; return *this; }
+		bool operator==(const iterator &other) const { return _pos == other._pos; }
+		bool operator!=(const iterator &other) const { return _pos != other._pos; }
+	};
+
+	Path2FileInformation();
+
+	/// returns false if path already present, in such case its information not changed
+	bool emplace(const std::string &path, const FileInformation &info);
+
+	/// returns 1 if path present, 0 otherwise
+	size_t count(const std::string &path) const;
+
+	void clear();
+
+	inline size_t size() const { return _count; }
+	inline bool empty() const { return _count == 0; }
+
+	iterator begin();
+	iterator end();
+	iterator rbegin();
+	iterator rend();
+};
@@ -18,6 +18,8 @@ struct IHost : IProtocol
 
 	virtual std::string SiteName() = 0; // MT-safe, human-readable site's name
 	virtual void GetIdentity(Identity &identity) = 0; // MT-safe, returns connection host identity details
+	virtual unsigned int TransferConnections() = 0; // MT-safe, returns count of connections site allows for parallel transfers, zero if no limit
+	virtual bool PersistentDirectoryCache() = 0; // MT-safe, returns true if site configured to keep directories listings in persistent cache
 
 	virtual std::shared_ptr<IHost> Clone() = 0; // MT-safe, creates clone of this host that will init automatically with same creds
 	virtual void ReInitialize() = 0;
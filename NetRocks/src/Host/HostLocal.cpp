@@ -60,6 +60,16 @@ void HostLocal::GetIdentity(Identity &identity)
 	identity = Identity();
 }
 
+unsigned int HostLocal::TransferConnections()
+{
+	return 0;
+}
+
+bool HostLocal::PersistentDirectoryCache()
+{
+	return false;
+}
+
 std::shared_ptr<IHost> HostLocal::Clone()
 {
 	return std::make_shared<HostLocal>();
@@ -15,6 +15,8 @@ public:
 
 	virtual std::string SiteName();
 	virtual void GetIdentity(Identity &identity);
+	virtual unsigned int TransferConnections();
+	virtual bool PersistentDirectoryCache();
 
 
 	virtual std::shared_ptr<IHost> Clone();
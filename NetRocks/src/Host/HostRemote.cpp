@@ -8,6 +8,7 @@
 #include <fcntl.h>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <ScopeHelpers.h>
 #include <Threaded.h>
 #include <UtfConvert.hpp>
@@ -185,6 +186,18 @@ void HostRemote::GetIdentity(Identity &identity)
 	identity = _identity;
 }
 
+unsigned int HostRemote::TransferConnections()
+{
+	std::unique_lock<std::mutex> locker(_mutex);
+	return (unsigned int)std::max(1, StringConfig(_options).GetInt("TransferConnections", 1));
+}
+
+bool HostRemote::PersistentDirectoryCache()
+{
+	std::unique_lock<std::mutex> locker(_mutex);
+	return StringConfig(_options).GetInt("PersistentDirCache", 0) != 0;
+}
+
 void HostRemote::BusySet()
 {
 	_busy = true;
@@ -612,6 +625,26 @@ class HostRemoteDirectoryEnumer : public IDirectoryEnumer
 {
 	std::shared_ptr<HostRemote> _conn;
 	bool _complete = false;
+	uint32_t _batch_count = 0; // count of entries in _batch not yet fetched
+	std::vector<char> _batch;
+	IPCFrameReader _batch_reader{_batch};
+
+	void RecvBatch()
+	{
+		_conn->SendCommand(IPC_DIRECTORY_ENUM_BATCH);
+		_conn->RecvReply(IPC_DIRECTORY_ENUM_BATCH);
+		_conn->RecvPOD(_batch_count);
+		if (_batch_count == 0) {
+			_complete = true;
+			return;
+		}
+
+		uint32_t size = 0;
+		_conn->RecvPOD(size);
+		_batch.resize(size);
+		_conn->Recv(_batch.data(), size);
+		_batch_reader.pos = 0;
+	}
 
 public:
 	HostRemoteDirectoryEnumer(std::shared_ptr<HostRemote> conn, const std::string &path)
@@ -632,22 +665,21 @@ public:
 
 	virtual bool Enum(std::string &name, std::string &owner, std::string &group, FileInformation &file_info)
 	{
-		if (_complete)
-			return false;
-
 		try {
-			_conn->SendCommand(IPC_DIRECTORY_ENUM);
-			_conn->RecvReply(IPC_DIRECTORY_ENUM);
+			if (_batch_count == 0) {
+				if (_complete)
+					return false;
 
-			_conn->RecvString(name);
-			if (name.empty()) {
-				_complete = true;
-				return false;
+				RecvBatch();
+				if (_complete)
+					return false;
 			}
 
-			_conn->RecvString(owner);
-			_conn->RecvString(group);
-			_conn->RecvPOD(file_info);
+			_batch_reader.GetString(name);
+			_batch_reader.GetString(owner);
+			_batch_reader.GetString(group);
+			_batch_reader.GetPOD(file_info);
+			--_batch_count;
 			_conn->CodepageRemote2Local(name);
 			_conn->CodepageRemote2Local(owner);
 			_conn->CodepageRemote2Local(group);
@@ -658,6 +690,7 @@ public:
 
 		} catch (...) {
 			_complete = true;
+			_batch_count = 0;
 			throw;
 		}
 	}
@@ -674,21 +707,103 @@ std::shared_ptr<IDirectoryEnumer> HostRemote::DirectoryEnum(const std::string &p
 	return std::make_shared<HostRemoteDirectoryEnumer>(shared_from_this(), path);
 }
 
+std::shared_ptr<IDirectoryEnumer> HostRemote::DirectoryEnumRecursive(const std::string &path)
+{
+	CheckReady();
+
+	SendCommand(IPC_DIRECTORY_ENUM_RECURSIVE);
+	SendString(CodepageLocal2Remote(path));
+	RecvReply(IPC_DIRECTORY_ENUM_RECURSIVE);
+
+	return std::make_shared<HostRemoteDirectoryEnumer>(shared_from_this(), path);
+}
+
 
 class HostRemoteFileIO : public IFileReader, public IFileWriter
 {
 	std::shared_ptr<HostRemote> _conn;
 	bool _complete = false, _writing;
+	size_t _window = 0;	// reading: credit window granted to broker, nonzero once streaming started
+	size_t _pending_acks = 0;	// writing: count of chunks sent but not replied yet
+	std::vector<char> _buf;	// reading: remainder of chunk that didn't fit into caller's buffer
+	size_t _buf_pos = 0;
+
+	void RecvWriteReply(std::string &error)
+	{
+		IPCCommand cmd = _conn->RecvCommand();
+		if (cmd == IPC_ERROR) {
+			std::string str;
+			_conn->RecvString(str);
+			if (error.empty()) {
+				error.swap(str);
+			}
+
+		} else if (cmd != IPC_FILE_PUT && cmd != IPC_STOP) {
+			throw PipeIPCError("Wrong write reply", cmd);
+		}
+	}
+
+	void DrainReadStream()
+	{
+		for (;;) {
+			IPCCommand cmd = _conn->RecvCommand();
+			if (cmd == IPC_STOP) {
+				break;
+			}
+			if (cmd == IPC_FILE_GET) {
+				size_t len = 0;
+				_conn->RecvPOD(len);
+				if (len) {
+					_buf.resize(len);
+					_conn->Recv(&_buf[0], len);
+				}
+
+			} else if (cmd == IPC_ERROR) {
+				std::string str;
+				_conn->RecvString(str);
+
+			} else {
+				throw PipeIPCError("Wrong read reply", cmd);
+			}
+		}
+		_buf.clear();
+		_buf_pos = 0;
+	}
 
 	void EnsureComplete()
 	{
 		if (!_complete) {
 			_complete = true;
 			_conn->SendPOD((size_t)0); // zero length mean stop requested
-			_conn->RecvReply(IPC_STOP);
+			if (_writing) {
+				std::string error;
+				for (; _pending_acks; --_pending_acks) {
+					RecvWriteReply(error);
+				}
+				RecvWriteReply(error); // reply on stop itself
+				if (!error.empty()) {
+					throw ProtocolError(error);
+				}
+
+			} else if (_window) {
+				DrainReadStream();
+
+			} else {
+				_conn->RecvReply(IPC_STOP);
+			}
 		}
 	}
 
+	void CompleteOnError(const std::string &error)
+	{
+		try {
+			EnsureComplete();
+		} catch (ProtocolError &) {
+			; // already have error to report
+		}
+		throw ProtocolError(error);
+	}
+
 public:
 	HostRemoteFileIO(std::shared_ptr<HostRemote> conn, bool writing)
 		: _conn(conn), _writing(writing)
@@ -714,21 +829,43 @@ public:
 		}
 
 		try {
-			_conn->SendPOD(len);
-			_conn->RecvReply(IPC_FILE_GET);
-			size_t recv_len = len;
-			_conn->RecvPOD(recv_len);
-			if (recv_len == 0) {
-				_complete = true;
-				return 0;
-			}
-			if (recv_len > len) {
-				fprintf(stderr, "HostRemoteFileIO::Read: IPC gonna mad\n");
-				_conn->Abort();
-				throw ProtocolError("Read: IPC gonna mad");
+			if (_buf_pos == _buf.size()) {
+				// caller may grow its read size, so grow window and chunks along with it
+				const size_t window = len * IPC_FILE_GET_WINDOW_CHUNKS;
+				if (window > _window) {
+					_window = window;
+					_conn->SendPOD(window);
+				}
+				IPCCommand cmd = _conn->RecvCommand();
+				if (cmd == IPC_ERROR) {
+					std::string str;
+					_conn->RecvString(str);
+					CompleteOnError(str);
+				}
+				if (cmd != IPC_FILE_GET) {
+					throw PipeIPCError("Wrong read reply", cmd);
+				}
+				size_t recv_len = 0;
+				_conn->RecvPOD(recv_len);
+				if (recv_len == 0) {
+					EnsureComplete();
+					return 0;
+				}
+				if (recv_len <= len) {
+					_conn->Recv(buf, recv_len);
+					_conn->SendPOD(recv_len); // return credit
+					return recv_len;
+				}
+				_buf.resize(recv_len);
+				_buf_pos = 0;
+				_conn->Recv(&_buf[0], recv_len);
+				_conn->SendPOD(recv_len);
 			}
-			_conn->Recv(buf, recv_len);
-			return recv_len;
+
+			len = std::min(len, _buf.size() - _buf_pos);
+			memcpy(buf, &_buf[_buf_pos], len);
+			_buf_pos+= len;
+			return len;
 
 		} catch (...) {
 			_complete = true;
@@ -749,7 +886,15 @@ public:
 		try {
 			_conn->SendPOD(len);
 			_conn->Send(buf, len);
-			_conn->RecvReply(IPC_FILE_PUT);
+			++_pending_acks;
+			if (_pending_acks > IPC_FILE_PUT_ACKS_AHEAD) {
+				std::string error;
+				RecvWriteReply(error);
+				--_pending_acks;
+				if (!error.empty()) {
+					CompleteOnError(error);
+				}
+			}
 
 		} catch (...) {
 			_complete = true;
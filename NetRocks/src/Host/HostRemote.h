@@ -65,6 +65,8 @@ public:
 
 	virtual std::string SiteName();
 	virtual void GetIdentity(Identity &identity);
+	virtual unsigned int TransferConnections();
+	virtual bool PersistentDirectoryCache();
 
 	virtual void ReInitialize();
 	virtual void Abort();
@@ -89,6 +91,7 @@ public:
 
 
 	virtual std::shared_ptr<IDirectoryEnumer> DirectoryEnum(const std::string &path);
+	virtual std::shared_ptr<IDirectoryEnumer> DirectoryEnumRecursive(const std::string &path);
 	virtual std::shared_ptr<IFileReader> FileGet(const std::string &path, unsigned long long resume_pos = 0);
 	virtual std::shared_ptr<IFileWriter> FilePut(const std::string &path, mode_t mode, unsigned long long size_hint, unsigned long long resume_pos = 0);
 
@@ -1,13 +1,12 @@
 #include <memory>
 #include <vector>
+#include <algorithm>
 #include <unistd.h>
 #include <stdlib.h>
 #include <signal.h>
 #include "IPC.h"
 #include "Protocol/Protocol.h"
 
-static const std::string s_empty_string;
-
 std::shared_ptr<IProtocol> CreateProtocol(
 	const std::string &protocol, // protocol name e.g. "ftp", "sftp", "scp" etc
 	const std::string &host,
@@ -57,43 +56,64 @@ class HostRemoteBroker : protected IPCEndpoint
 		}
 	}
 
-	void OnDirectoryEnum()
+	template <IPCCommand C, class MethodT>
+		void OnDirectoryEnum(MethodT pEnum)
 	{
 		RecvString(_args.str1);
-		std::shared_ptr<IDirectoryEnumer> enumer = _protocol->DirectoryEnum(_args.str1);
+		std::shared_ptr<IDirectoryEnumer> enumer = ((*_protocol).*(pEnum))(_args.str1);
 		_keepalive_path = _args.str1;
-		SendCommand(IPC_DIRECTORY_ENUM);
-		for (;;) {
-			bool cont;
-			try {
-				cont = enumer->Enum(_args.str1, _args.str2, _args.str3, _args.file_info);
+		SendCommand(C);
 
-			} catch (ProtocolError &ex) {
-				fprintf(stderr, "OnDirectoryEnum: %s\n", ex.what());
-				RecvCommand();
-				SendCommand(IPC_ERROR);
-				SendString(ex.what());
+		// entries sent by batches, each batch requested by IPC_DIRECTORY_ENUM_BATCH,
+		// batch with zero count of entries means enumeration completed
+		std::string error;
+		bool complete = false;
+		for (;;) {
+			auto cmd = RecvCommand();
+			if (cmd != IPC_DIRECTORY_ENUM_BATCH) {
+				SendCommand(cmd);
 				break;
 			}
-			if (cont && _args.str1.empty()) {
-				fprintf(stderr, "OnDirectoryEnum: skipped empty name\n");
-				continue;
+
+			uint32_t count = 0;
+			IPCFrameWriter fw(_io_buf);
+			while (!complete && error.empty() && count < IPC_DIRECTORY_ENUM_BATCH_COUNT
+					&& _io_buf.size() < IPC_DIRECTORY_ENUM_BATCH_SIZE) {
+				try {
+					complete = !enumer->Enum(_args.str1, _args.str2, _args.str3, _args.file_info);
+
+				} catch (ProtocolError &ex) {
+					fprintf(stderr, "OnDirectoryEnum: %s\n", ex.what());
+					error = ex.what();
+					break;
+				}
+				if (!complete) {
+					if (_args.str1.empty()) {
+						fprintf(stderr, "OnDirectoryEnum: skipped empty name\n");
+						continue;
+					}
+					fw.PutString(_args.str1);
+					fw.PutString(_args.str2);
+					fw.PutString(_args.str3);
+					fw.PutPOD(_args.file_info);
+					++count;
+				}
 			}
-			auto cmd = RecvCommand();
-			SendCommand(cmd);
-			if (cmd != IPC_DIRECTORY_ENUM) {
+
+			// report error only after entries enumerated before it are delivered
+			if (count == 0 && !error.empty()) {
+				SendCommand(IPC_ERROR);
+				SendString(error);
 				break;
 			}
 
-			if (!cont) {
-				SendString(s_empty_string);
+			SendCommand(IPC_DIRECTORY_ENUM_BATCH);
+			SendPOD(count);
+			if (count == 0) {
 				break;
 			}
-
-			SendString(_args.str1);
-			SendString(_args.str2);
-			SendString(_args.str3);
-			SendPOD(_args.file_info);
+			SendPOD((uint32_t)_io_buf.size());
+			Send(_io_buf.data(), _io_buf.size());
 		}
 	}
 
@@ -104,13 +124,30 @@ class HostRemoteBroker : protected IPCEndpoint
 		std::shared_ptr<IFileReader> reader = _protocol->FileGet(_args.str1, _args.ull1);
 		SendCommand(IPC_FILE_GET);
 
+		// Data pushed to client without waiting for requests as long as there is credit:
+		// client grants it by sending count of bytes it can accept. Grant that exceeds
+		// current window is a new window: it limits chunk size and adds its growth to credit,
+		// while returned credit never exceeds chunk size. Zero from client requests stop that
+		// acknowledged by IPC_STOP, and after EOF or error reply there is nothing to do but wait for it.
+		size_t window = 0, credit = 0;
+		bool done = false;
 		for (;;) {
-			size_t len = 0;
-			RecvPOD(len);
-			if (len == 0) {
-				SendCommand(IPC_STOP);
-				break;
+			while (done || credit == 0 || WaitForRecv(0)) {
+				size_t grant = 0;
+				RecvPOD(grant);
+				if (grant == 0) {
+					SendCommand(IPC_STOP);
+					return;
+				}
+				if (grant > window) {
+					credit+= grant - window;
+					window = grant;
+				} else {
+					credit+= grant;
+				}
 			}
+
+			size_t len = std::min(credit, std::max(window / IPC_FILE_GET_WINDOW_CHUNKS, (size_t)1));
 			try {
 				if (_io_buf.size() < len) {
 					_io_buf.resize(len);
@@ -120,14 +157,17 @@ class HostRemoteBroker : protected IPCEndpoint
 				fprintf(stderr, "OnFileGet: %s\n", ex.what());
 				SendCommand(IPC_ERROR);
 				SendString(ex.what());
-				break;
+				done = true;
+				continue;
 			}
 			SendCommand(IPC_FILE_GET);
 			SendPOD(len);
 			if (len == 0) {
-				break;
+				done = true;
+				continue;
 			}
 			Send(&_io_buf[0], len);
+			credit-= len;
 		}
 	}
 
@@ -139,8 +179,10 @@ class HostRemoteBroker : protected IPCEndpoint
 		RecvPOD(_args.ull2);
 		std::shared_ptr<IFileWriter> writer = _protocol->FilePut(_args.str1, _args.mode, _args.ull1, _args.ull2);
 		SendCommand(IPC_FILE_PUT);
-		// Trick to improve IO parallelization: instead of sending status reply on operation,
-		// send preliminary OK and if error will occur - do error reply on next operation.
+		// Client doesn't wait for reply on each chunk but sends following chunks ahead and
+		// fetches replies later, so each chunk gets exactly one reply: IPC_FILE_PUT while
+		// all is fine, IPC_ERROR after any error. Once error occured further chunks are
+		// just fetched to keep IPC sequencing. Final zero length replied by IPC_STOP or error.
 		std::string error_str;
 		for (;;) {
 			size_t len = 0;
@@ -148,32 +190,31 @@ class HostRemoteBroker : protected IPCEndpoint
 			if (_io_buf.size() < len) {
 				_io_buf.resize(len);
 			}
-
-			if (!error_str.empty()) {
+			if (len) {
+				Recv(&_io_buf[0], len);
+			}
+			if (error_str.empty()) try {
 				if (len) {
-					// still have to fetch buffer to ensure proper IPC sequencing
-					Recv(&_io_buf[0], len);
+					writer->Write(&_io_buf[0], len);
+				} else {
+					writer->WriteComplete();
 				}
+			} catch (std::exception &ex) {
+				fprintf(stderr, "OnFilePut: %s\n", ex.what());
+				error_str = ex.what();
+				if (error_str.empty())
+					error_str = "Unknown error";
+			}
+
+			if (!error_str.empty()) {
 				SendCommand(IPC_ERROR);
 				SendString(error_str);
-				break;
+			} else {
+				SendCommand(len ? IPC_FILE_PUT : IPC_STOP);
 			}
 			if (!len) {
-				writer->WriteComplete();
-				SendCommand(IPC_STOP);
 				break;
 			}
-			SendCommand(IPC_FILE_PUT);
-
-			Recv(&_io_buf[0], len);
-			try {
-				writer->Write(&_io_buf[0], len);
-			} catch (ProtocolError &ex) {
-				fprintf(stderr, "OnFilePut: %s\n", ex.what());
-				error_str = ex.what();
-				if (error_str.empty())
-					error_str = "Unknown error";
-			}
 		}
 	}
 
@@ -315,7 +356,8 @@ class HostRemoteBroker : protected IPCEndpoint
 			case IPC_SET_MODE: OnSetMode(); break;
 			case IPC_SYMLINK_CREATE: OnSymLinkCreate(); break;
 			case IPC_SYMLINK_QUERY: OnSymLinkQuery(); break;
-			case IPC_DIRECTORY_ENUM: OnDirectoryEnum(); break;
+			case IPC_DIRECTORY_ENUM: OnDirectoryEnum<IPC_DIRECTORY_ENUM>(&IProtocol::DirectoryEnum); break;
+			case IPC_DIRECTORY_ENUM_RECURSIVE: OnDirectoryEnum<IPC_DIRECTORY_ENUM_RECURSIVE>(&IProtocol::DirectoryEnumRecursive); break;
 			case IPC_FILE_GET: OnFileGet(); break;	
 			case IPC_FILE_PUT: OnFilePut(); break;
 			case IPC_EXECUTE_COMMAND: OnExecuteCommand(); break;
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <atomic>
 #include <unistd.h>
 #include <string.h>
@@ -29,6 +30,8 @@ enum IPCCommand
 	IPC_FILE_GET,
 	IPC_FILE_PUT,
 	IPC_EXECUTE_COMMAND,
+	IPC_DIRECTORY_ENUM_BATCH,
+	IPC_DIRECTORY_ENUM_RECURSIVE,
 };
 
 typedef PipeIPCEndpoint<IPCCommand> IPCEndpoint;
@@ -42,4 +45,77 @@ enum IPCProtocolInitStatus
 	IPC_PI_GENERIC_ERROR
 };
 
-#define IPC_VERSION_MAGIC  0xbabe0001
+#define IPC_VERSION_MAGIC  0xbabe0004
+
+// limits of entries count and frame size of single IPC_DIRECTORY_ENUM_BATCH reply,
+// same batching used to deliver entries of IPC_DIRECTORY_ENUM_RECURSIVE
+#define IPC_DIRECTORY_ENUM_BATCH_COUNT  0x1000
+#define IPC_DIRECTORY_ENUM_BATCH_SIZE   0x100000
+
+// IPC_FILE_GET credit window granted by client, in units of its read size,
+// grows when client starts reading by bigger portions
+#define IPC_FILE_GET_WINDOW_CHUNKS  4
+
+// count of IPC_FILE_PUT chunks client may send ahead of their replies
+#define IPC_FILE_PUT_ACKS_AHEAD     8
+
+// Helpers to pack several values into single frame, so they can be sent by single Send()
+// and received by single Recv() instead of doing that for each value separately.
+struct IPCFrameWriter
+{
+	std::vector<char> &frame;
+
+	IPCFrameWriter(std::vector<char> &frame_) : frame(frame_) { frame.clear(); }
+
+	void Put(const void *data, size_t len)
+	{
+		frame.insert(frame.end(), (const char *)data, (const char *)data + len);
+	}
+
+	void PutString(const std::string &s)
+	{
+		const uint32_t len = (uint32_t)s.size();
+		Put(&len, sizeof(len));
+		Put(s.data(), s.size());
+	}
+
+	template <class POD_T>
+		inline void PutPOD(const POD_T &pod)
+	{
+		Put(&pod, sizeof(pod));
+	}
+};
+
+struct IPCFrameReader
+{
+	const std::vector<char> &frame;
+	size_t pos = 0;
+
+	IPCFrameReader(const std::vector<char> &frame_) : frame(frame_) { }
+
+	void Get(void *data, size_t len)
+	{
+		if (len > frame.size() - pos) {
+			throw PipeIPCError("Frame too short", (unsigned int)len);
+		}
+		memcpy(data, &frame[pos], len);
+		pos+= len;
+	}
+
+	void GetString(std::string &s)
+	{
+		uint32_t len;
+		Get(&len, sizeof(len));
+		if (len > frame.size() - pos) {
+			throw PipeIPCError("Frame too short", (unsigned int)len);
+		}
+		s.assign(&frame[pos], len);
+		pos+= len;
+	}
+
+	template <class POD_T>
+		inline void GetPOD(POD_T &pod)
+	{
+		Get(&pod, sizeof(pod));
+	}
+};
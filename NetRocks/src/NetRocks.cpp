@@ -158,6 +158,10 @@ SHAREDSYMBOL int WINAPI ProcessEventW(HANDLE hPlugin, int Event, void * Param)
 				return ((PluginImpl *)hPlugin)->ProcessEventCommand((const wchar_t *)Param);
 		break;
 
+		case FE_IDLE:
+			((PluginImpl *)hPlugin)->ProcessEventIdle();
+		break;
+
 		default:
 			;
 	}
@@ -14,6 +14,62 @@ OpEnumDirectory::OpEnumDirectory(int op_mode, std::shared_ptr<IHost> &base_host,
 	_initial_count_complete = _state.stats.count_complete;
 }
 
+void EnumDirectoryAddItem(PluginPanelItems &result, const std::string &name,
+	const std::string &owner, const std::string &group, const FileInformation &file_info)
+{
+	auto *ppi = result.Add(name.c_str());
+	ppi->FindData.nFileSize = file_info.size;
+	ppi->FindData.dwUnixMode = file_info.mode;
+	ppi->FindData.dwFileAttributes = WINPORT(EvaluateAttributesA)(file_info.mode, name.c_str());
+	ppi->Owner = (wchar_t *)MB2WidePooled(owner);
+	ppi->Group = (wchar_t *)MB2WidePooled(group);
+
+	WINPORT(FileTime_UnixToWin32)(file_info.access_time, &ppi->FindData.ftCreationTime);
+	WINPORT(FileTime_UnixToWin32)(file_info.access_time, &ppi->FindData.ftLastAccessTime);
+	WINPORT(FileTime_UnixToWin32)(file_info.modification_time, &ppi->FindData.ftLastWriteTime);
+}
+
+void EnumDirectoryResolveSymlinks(IHost *host, const std::string &dir, PluginPanelItems &result, int from, const std::function<void()> &on_step)
+{
+	// For those of entries which are symlinks check if they point to directory and
+	// set FILE_ATTRIBUTE_DIRECTORY to tell far2l that they're 'enterable' directories
+	// note that not care about possible faults for a reason to do not bother user with
+	// annoying errors if some directories target's will appear inaccessible.
+	std::vector<std::string> paths;
+	std::vector<mode_t> modes;
+	std::vector<DWORD *> pattrs;
+	size_t paths_len = 0;
+	for (int i = from; ; ++i) {
+		if (paths_len >= 1024 || i >= result.count) {
+			if (!paths.empty()) {
+				host->GetModes(true, paths.size(), paths.data(), modes.data());
+				for (size_t j = 0; j < paths.size(); ++j) {
+					if (modes[j] != (mode_t)-1 && S_ISDIR(modes[j])) {
+						(*pattrs[j])|= FILE_ATTRIBUTE_DIRECTORY;
+					}
+				}
+				paths.clear();
+				modes.clear();
+				pattrs.clear();
+				paths_len = 0;
+			}
+			if (i >= result.count) break;
+		}
+		auto &entry = result.items[i];
+		if (S_ISLNK(entry.FindData.dwUnixMode)) {
+			paths.emplace_back(dir);
+			if (!dir.empty() && dir.back() != '/') {
+				paths.back()+= '/';
+			}
+			paths.back()+= Wide2MB(entry.FindData.lpwszFileName);
+			paths_len+= paths.back().size();
+			modes.emplace_back(~(mode_t)0);
+			pattrs.emplace_back(&entry.FindData.dwFileAttributes);
+		}
+		on_step();
+	}
+}
+
 bool OpEnumDirectory::Do()
 {
 	if (!StartThread()) {
@@ -29,12 +85,14 @@ bool OpEnumDirectory::Do()
 		WaitThread();
 	}
 
-	return true;
+	return GetThreadResult() == nullptr;
 }
 
 
 void OpEnumDirectory::Process()
 {
+	// skipping error returns from wrap without completing enumeration
+	_skipped = true;
 	WhatOnErrorWrap<WEK_ENUMDIR>(_wea_state, _state, _base_host.get(), _base_dir,
 		[&] () mutable
 		{
@@ -46,20 +104,11 @@ void OpEnumDirectory::Process()
 					break;
 				}
 
-				auto *ppi = _result.Add(name.c_str());
-				ppi->FindData.nFileSize = file_info.size;
-				ppi->FindData.dwUnixMode = file_info.mode;
-				ppi->FindData.dwFileAttributes = WINPORT(EvaluateAttributesA)(file_info.mode, name.c_str());
-				ppi->Owner = (wchar_t *)MB2WidePooled(owner);
-				ppi->Group = (wchar_t *)MB2WidePooled(group);
-
-				WINPORT(FileTime_UnixToWin32)(file_info.access_time, &ppi->FindData.ftCreationTime);
-				WINPORT(FileTime_UnixToWin32)(file_info.access_time, &ppi->FindData.ftLastAccessTime);
-				WINPORT(FileTime_UnixToWin32)(file_info.modification_time, &ppi->FindData.ftLastWriteTime);
-
+				EnumDirectoryAddItem(_result, name, owner, group, file_info);
 				ProgressStateUpdate psu(_state);
 				_state.stats.count_complete++;
 			}
+			_skipped = false;
 		}
 		,
 		[this] (bool &recovery) mutable
@@ -71,41 +120,6 @@ void OpEnumDirectory::Process()
 		}
 	);
 
-	// Now for those of them which are symlinks check if they point to directory and
-	// set FILE_ATTRIBUTE_DIRECTORY to tell far2l that they're 'enterable' directories
-	// note that not care about possible faults for a reason to do not bother user with
-	// annoying errors if some directories target's will appear inaccessible.
-	std::vector<std::string> paths;
-	std::vector<mode_t> modes;
-	std::vector<DWORD *> pattrs;
-	size_t paths_len = 0;
-	for (int i = _initial_result_count; ; ++i) {
-		if (paths_len >= 1024 || i >= _result.count) {
-			if (!paths.empty()) {
-				_base_host->GetModes(true, paths.size(), paths.data(), modes.data());
-				for (size_t j = 0; j < paths.size(); ++j) {
-					if (modes[j] != (mode_t)-1 && S_ISDIR(modes[j])) {
-						(*pattrs[j])|= FILE_ATTRIBUTE_DIRECTORY;
-					}
-				}
-				paths.clear();
-				modes.clear();
-				pattrs.clear();
-				paths_len = 0;
-			}
-			if (i >= _result.count) break;
-		}
-		auto &entry = _result.items[i];
-		if (S_ISLNK(entry.FindData.dwUnixMode)) {
-			paths.emplace_back(_base_dir);
-			if (!_base_dir.empty() && _base_dir.back() != '/') {
-				paths.back()+= '/';
-			}
-			paths.back()+= Wide2MB(entry.FindData.lpwszFileName);
-			paths_len+= paths.back().size();
-			modes.emplace_back(~(mode_t)0);
-			pattrs.emplace_back(&entry.FindData.dwFileAttributes);
-		}
-		ProgressStateUpdate psu(_state); // check for pause/abort
-	}
+	EnumDirectoryResolveSymlinks(_base_host.get(), _base_dir, _result, _initial_result_count,
+		[this] () { ProgressStateUpdate psu(_state); }); // check for pause/abort
 }
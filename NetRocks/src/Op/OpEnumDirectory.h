@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include "OpBase.h"
 #include "../PluginPanelItems.h"
 
@@ -8,10 +9,19 @@ class OpEnumDirectory : protected OpBase
 	PluginPanelItems &_result;
 	unsigned long long _initial_count_complete;
 	int _initial_result_count;
+	bool _skipped = false;
 
 	virtual void Process();
 
 public:
 	OpEnumDirectory(int op_mode, std::shared_ptr<IHost> &base_host, const std::string &base_dir, PluginPanelItems &result, std::shared_ptr<WhatOnErrorState> &wea_state);
 	bool Do();
+
+	// valid after Do(): true if user skipped enumeration error, so result may be incomplete
+	bool Skipped() const { return _skipped; }
 };
+
+// Helpers also used to list directory without any UI interaction, on_step invoked for each checked entry
+void EnumDirectoryAddItem(PluginPanelItems &result, const std::string &name,
+	const std::string &owner, const std::string &group, const FileInformation &file_info);
+void EnumDirectoryResolveSymlinks(IHost *host, const std::string &dir, PluginPanelItems &result, int from, const std::function<void()> &on_step);
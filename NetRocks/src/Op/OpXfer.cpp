@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <deque>
+#include <condition_variable>
 #include <utils.h>
 #include <TimeUtils.h>
 #include "OpXfer.h"
@@ -12,9 +14,245 @@
 #define BUFFER_SIZE_GRANULARITY   0x8000
 #define BUFFER_SIZE_LIMIT         0x1000000
 #define BUFFER_SIZE_INITIAL       (2 * BUFFER_SIZE_GRANULARITY)
+#define PIPELINE_RING_SIZE        3
 
 #define EXTRA_NEEDED_MODE	(S_IRUSR | S_IWUSR)
 
+#define PARALLEL_BUFFER_SIZE      0x40000
+#define PARALLEL_JOBS_PER_WORKER  4
+
+// Copies files in several threads, each using its own cloned connections to both sites,
+// so per-file latencies of different files overlap. Workers never interact with user:
+// file that failed to copy for any reason returned to caller that copies it again in
+// usual way with all its error handling and prompts. If only setting attributes or
+// deleting source (when moving) failed then its data is kept and caller repeats only
+// that steps. Worker which connection became broken quits, and if there is no more
+// workers left - all jobs considered failed.
+class OpXferParallel
+{
+public:
+	struct Job
+	{
+		std::string path_src, path_dst;
+		FileInformation info;
+		bool data_copied;	// set by worker if failure happened after data was copied
+	};
+
+private:
+	class Worker : public Threaded
+	{
+		OpXferParallel *_owner;
+		std::shared_ptr<IHost> _base_host, _dst_host;
+		std::vector<char> _buf;
+
+		virtual void *ThreadProc()
+		{
+			Job job;
+			while (_owner->Pop(job)) {
+				unsigned long long complete = 0;
+				bool ok = false;
+				try {
+					Copy(job, complete);
+					ok = true;
+
+				} catch (std::exception &ex) {
+					fprintf(stderr, "NetRocks: parallel copy error %s%s: '%s' -> '%s'\n",
+						ex.what(), job.data_copied ? " after data copied" : "",
+						job.path_src.c_str(), job.path_dst.c_str());
+				}
+				const bool alive = ok || (_base_host->Alive() && _dst_host->Alive());
+				_owner->Done(job, ok, complete, alive);
+				if (!alive) {
+					break;
+				}
+			}
+			return nullptr;
+		}
+
+		void Copy(Job &job, unsigned long long &complete)
+		{
+			std::shared_ptr<IFileReader> reader = _base_host->FileGet(job.path_src, 0);
+			std::shared_ptr<IFileWriter> writer = _dst_host->FilePut(job.path_dst,
+				(job.info.mode | EXTRA_NEEDED_MODE) & 07777, job.info.size, 0);
+			for (;;) {
+				const size_t piece = reader->Read(_buf.data(), _buf.size());
+				if (piece == 0) {
+					break;
+				}
+				writer->Write(_buf.data(), piece);
+				complete+= piece;
+				ProgressStateUpdate psu(_owner->_state);
+				_owner->_state.stats.all_complete+= piece;
+			}
+			writer->WriteComplete();
+			if (complete != job.info.size) {
+				// let usual copy deal with file that changed while copied
+				throw std::runtime_error("Size changed while copied");
+			}
+			job.data_copied = true;
+
+			_dst_host->SetTimes(job.path_dst, job.info.access_time, job.info.modification_time);
+			if (_owner->_umask_override || (job.info.mode | EXTRA_NEEDED_MODE) != job.info.mode) {
+				const mode_t mode = job.info.mode & 07777;
+				try {
+					_dst_host->SetMode(job.path_dst, mode);
+				} catch (...) {
+					if ((mode & 07000) == 0) {
+						throw;
+					}
+					_dst_host->SetMode(job.path_dst, mode & 00777);
+				}
+			}
+			if (_owner->_kind == XK_MOVE) {
+				_base_host->FileDelete(job.path_src);
+			}
+		}
+
+	public:
+		Worker(OpXferParallel *owner, std::shared_ptr<IHost> base_host, std::shared_ptr<IHost> dst_host)
+			: _owner(owner), _base_host(base_host), _dst_host(dst_host), _buf(PARALLEL_BUFFER_SIZE)
+		{
+		}
+
+		virtual ~Worker()
+		{
+			WaitThread();
+		}
+
+		bool Start()
+		{
+			return StartThread();
+		}
+
+		void Abort()
+		{
+			_dst_host->Abort();
+			_base_host->Abort();
+		}
+	};
+
+	ProgressState &_state;
+	XferKind _kind;
+	bool _umask_override;
+
+	std::mutex _mtx;
+	std::condition_variable _cond;
+	std::vector<std::unique_ptr<Worker>> _workers;
+	std::deque<Job> _jobs;
+	std::vector<Job> _failed;
+	size_t _busy = 0, _alive = 0;
+	bool _stopping = false;
+
+	bool Pop(Job &job)
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		while (!_stopping && _jobs.empty()) {
+			_cond.wait(lock);
+		}
+		if (_stopping) {
+			return false;
+		}
+		job = std::move(_jobs.front());
+		_jobs.pop_front();
+		++_busy;
+		_cond.notify_all();
+		return true;
+	}
+
+	void Done(Job &job, bool ok, unsigned long long complete, bool alive)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_state.mtx);
+			if (ok) {
+				_state.stats.count_complete++;
+			} else if (!job.data_copied) {
+				_state.stats.all_complete-= complete;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(_mtx);
+		--_busy;
+		if (!ok) {
+			_failed.emplace_back(std::move(job));
+		}
+		if (!alive && --_alive == 0) {
+			for (auto &left_job : _jobs) {
+				_failed.emplace_back(std::move(left_job));
+			}
+			_jobs.clear();
+		}
+		_cond.notify_all();
+	}
+
+public:
+	OpXferParallel(unsigned int connections, std::shared_ptr<IHost> &base_host, std::shared_ptr<IHost> &dst_host,
+		ProgressState &state, XferKind kind, bool umask_override)
+		: _state(state), _kind(kind), _umask_override(umask_override)
+	{
+		for (unsigned int i = 0; i < connections; ++i) {
+			_workers.emplace_back(new Worker(this, base_host->Clone(), dst_host->Clone()));
+			if (!_workers.back()->Start()) {
+				fprintf(stderr, "NetRocks: parallel copy worker #%u not started\n", i);
+				_workers.pop_back();
+				break;
+			}
+			++_alive;
+		}
+	}
+
+	~OpXferParallel()
+	{
+		Shutdown();
+	}
+
+	// returns false if job wasn't queued cuz there're no workers alive
+	bool Queue(Job &job)
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		while (!_stopping && _alive != 0 && _jobs.size() >= _alive * PARALLEL_JOBS_PER_WORKER) {
+			_cond.wait(lock);
+		}
+		if (_stopping || _alive == 0) {
+			return false;
+		}
+		_jobs.emplace_back(std::move(job));
+		_cond.notify_all();
+		return true;
+	}
+
+	// waits for completion of all queued jobs and returns ones that failed
+	void Wait(std::vector<Job> &failed)
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		while (_alive != 0 && (_busy != 0 || !_jobs.empty())) {
+			_cond.wait(lock);
+		}
+		failed.swap(_failed);
+		_failed.clear();
+	}
+
+	// stops workers discarding not yet started jobs and releases their connections
+	void Shutdown()
+	{
+		std::vector<std::unique_ptr<Worker>> workers;
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			_stopping = true;
+			_cond.notify_all();
+			workers.swap(_workers);
+		}
+		workers.clear();
+	}
+
+	void Abort()
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		for (auto &w : _workers) {
+			w->Abort();
+		}
+	}
+};
+
 OpXfer::OpXfer(int op_mode, std::shared_ptr<IHost> &base_host, const std::string &base_dir,
 	std::shared_ptr<IHost> &dst_host, const std::string &dst_dir,
 	struct PluginPanelItem *items, int items_count, XferKind kind, XferDirection direction)
@@ -78,6 +316,23 @@ OpXfer::OpXfer(int op_mode, std::shared_ptr<IHost> &base_host, const std::string
 		}
 	}
 
+	if (_kind != XK_RENAME && _base_host != _dst_host && G.GetGlobalConfigBool("OverlappedCopy", true)) {
+		_pipelined_reader.reset(new PipelinedReader(PIPELINE_RING_SIZE,
+			BUFFER_SIZE_INITIAL, BUFFER_SIZE_GRANULARITY, BUFFER_SIZE_LIMIT));
+	}
+
+	if (_kind != XK_RENAME && !_on_site_move) {
+		// local host has no own limit, otherwise use most restrictive site's one
+		unsigned int connections = _base_host->TransferConnections();
+		const unsigned int dst_connections = _dst_host->TransferConnections();
+		if (connections == 0 || (dst_connections != 0 && dst_connections < connections)) {
+			connections = dst_connections;
+		}
+		if (connections > 1) {
+			_parallel.reset(new OpXferParallel(connections, _base_host, _dst_host, _state, _kind, _umask_override));
+		}
+	}
+
 	if (!StartThread()) {
 		throw std::runtime_error("Cannot start thread");
 	}
@@ -161,6 +416,9 @@ void OpXfer::Abort()
 
 	_dst_host->Abort();
 	_base_host->Abort();
+	if (_parallel) {
+		_parallel->Abort();
+	}
 }
 
 void OpXfer::Process()
@@ -287,7 +545,7 @@ void OpXfer::Transfer()
 	EnsureDstDirExists();
 
 	std::string path_dst;
-	for (auto &e : _entries) {
+	for (const auto &e : _entries) {
 		const std::string &subpath = e.first.substr(_base_dir.size());
 		path_dst = _dst_dir;
 		path_dst+= subpath;
@@ -301,7 +559,7 @@ void OpXfer::Transfer()
 		}
 
 		FileInformation existing_file_info;
-		bool existing = false;
+		bool existing = false, resuming = false;
 		try {
 			_dst_host->GetInformation(existing_file_info, path_dst);
 			existing = true;
@@ -357,6 +615,9 @@ void OpXfer::Transfer()
 					xoa = ConfirmOverwrite(_kind, _direction, path_dst, e.second.modification_time, e.second.size,
 								existing_file_info.modification_time, existing_file_info.size).Ask(_default_xoa);
 					if (xoa == XOA_CANCEL) {
+						if (_parallel) {
+							_parallel->Shutdown();
+						}
 						return;
 					}
 				}
@@ -366,6 +627,7 @@ void OpXfer::Transfer()
 				}
 				if (xoa == XOA_RESUME) {
 					if (existing_file_info.size < e.second.size) {
+						resuming = true;
 						std::lock_guard<std::mutex> lock(_state.mtx);
 						_state.stats.all_complete+= existing_file_info.size;
 						_state.stats.file_complete = existing_file_info.size;
@@ -400,18 +662,47 @@ void OpXfer::Transfer()
 					ex.what(), e.first.c_str(), path_dst.c_str());
 			}
 
-			if (FileCopyLoop(e.first, path_dst, e.second)) {
-				CopyAttributes(path_dst, e.second);
-				if (_kind == XK_MOVE) {
-					FileDelete(e.first);
+			if (_parallel && !resuming && S_ISREG(e.second.mode)) {
+				OpXferParallel::Job job{e.first, path_dst, e.second, false};
+				if (_parallel->Queue(job)) {
+					continue; // worker will account its completion
 				}
 			}
+
+			FileCopy(e.first, path_dst, e.second);
 		}
 
 		ProgressStateUpdate psu(_state);
 		_state.stats.count_complete++;
 	}
 
+	if (_parallel) {
+		std::vector<OpXferParallel::Job> failed_jobs;
+		_parallel->Wait(failed_jobs);
+		_parallel->Shutdown();
+		for (auto &job : failed_jobs) {
+			{
+				std::lock_guard<std::mutex> lock(_state.mtx);
+				_state.path = job.path_src.substr(_base_dir.size());
+				_state.stats.file_complete = job.data_copied ? job.info.size : 0;
+				_state.stats.file_total = job.info.size;
+				_state.stats.current_start = TimeMSNow();
+				_state.stats.current_paused = std::chrono::milliseconds::zero();
+			}
+			if (job.data_copied) {
+				// data already there, so only finish what worker failed to do
+				CopyAttributes(job.path_dst, job.info);
+				if (_kind == XK_MOVE) {
+					FileDelete(job.path_src);
+				}
+			} else {
+				FileCopy(job.path_src, job.path_dst, job.info);
+			}
+			ProgressStateUpdate psu(_state);
+			_state.stats.count_complete++;
+		}
+	}
+
 	for (auto rev_i = _entries.rbegin(); rev_i != _entries.rend(); ++rev_i) {
 		if (S_ISDIR(rev_i->second.mode)) {
 			path_dst = _dst_dir;
@@ -432,6 +723,16 @@ void OpXfer::Transfer()
 	}
 }
 
+void OpXfer::FileCopy(const std::string &path_src, const std::string &path_dst, FileInformation &info)
+{
+	if (FileCopyLoop(path_src, path_dst, info)) {
+		CopyAttributes(path_dst, info);
+		if (_kind == XK_MOVE) {
+			FileDelete(path_src);
+		}
+	}
+}
+
 void OpXfer::FileDelete(const std::string &path)
 {
 	WhatOnErrorWrap<WEK_REMOVE>(_wea_state, _state, _base_host.get(), path,
@@ -481,6 +782,24 @@ void OpXfer::EnsureProgressConsistency()
 	}
 }
 
+namespace
+{
+	// stops pipelined reading on any exit from copy attempt, before its reader and writer released
+	struct PipelinedReaderScope
+	{
+		PipelinedReader *_pr;
+
+		PipelinedReaderScope(PipelinedReader *pr) : _pr(pr) {}
+
+		~PipelinedReaderScope()
+		{
+			if (_pr) {
+				_pr->Stop();
+			}
+		}
+	};
+}
+
 bool OpXfer::FileCopyLoop(const std::string &path_src, const std::string &path_dst, FileInformation &info)
 {
 	for (IHost *indicted = nullptr;;) try {
@@ -506,18 +825,31 @@ bool OpXfer::FileCopyLoop(const std::string &path_src, const std::string &path_d
 		if (!_io_buf.Size())
 			throw std::runtime_error("No buffer - no file");
 
+		PipelinedReaderScope pipelined_reader_scope(_pipelined_reader.get());
+		if (_pipelined_reader) {
+			_pipelined_reader->Start(reader, file_complete, info.size);
+		}
+
 		for (unsigned long long transfer_msec = 0, initial_complete = file_complete;;) {
 			indicted = _base_host.get();
-			size_t ask_piece = _io_buf.Size();
-			if (info.size < file_complete + ask_piece && info.size > file_complete) {
-				// use small buffer if gonna read small piece: IO may have small-read-optimized implementation
-				// but ask by one extra byte more to properly detect file being grew while copied
-				ask_piece = (info.size - file_complete) + 1;
-			}
-
 			std::chrono::milliseconds msec = TimeMSNow();
 
-			const size_t piece = reader->Read(_io_buf.Data(), ask_piece);
+			size_t ask_piece, piece;
+			const void *data;
+			if (_pipelined_reader) {
+				data = _pipelined_reader->Fetch(piece, ask_piece);
+
+			} else {
+				ask_piece = _io_buf.Size();
+				if (info.size < file_complete + ask_piece && info.size > file_complete) {
+					// use small buffer if gonna read small piece: IO may have small-read-optimized implementation
+					// but ask by one extra byte more to properly detect file being grew while copied
+					ask_piece = (info.size - file_complete) + 1;
+				}
+				piece = reader->Read(_io_buf.Data(), ask_piece);
+				data = _io_buf.Data();
+			}
+
 			if (piece == 0) {
 				if (file_complete < info.size) {
 					// protocol returned no read error, but trieved less data then expected, only two reasons possible:
@@ -538,7 +870,10 @@ bool OpXfer::FileCopyLoop(const std::string &path_src, const std::string &path_d
 			}
 
 			indicted = _dst_host.get();
-			writer->Write(_io_buf.Data(), piece);
+			writer->Write(data, piece);
+			if (_pipelined_reader) {
+				_pipelined_reader->Release();
+			}
 
 			file_complete+= piece;
 			const bool fast_complete = (piece < ask_piece && file_complete == info.size);
@@ -558,11 +893,21 @@ bool OpXfer::FileCopyLoop(const std::string &path_src, const std::string &path_d
 					bufsize_optimal-= bufsize_align;
 				}
 
-				unsigned long prev_bufsize = _io_buf.Size();
-				_io_buf.Desire(bufsize_optimal);
+				if (_pipelined_reader) {
+					unsigned long prev_bufsize = _pipelined_reader->PieceSize();
+					_pipelined_reader->DesirePieceSize(bufsize_optimal);
+
+					if (g_netrocks_verbosity > 0 && _pipelined_reader->PieceSize() != prev_bufsize) {
+						fprintf(stderr, "NetRocks: IO piece size changed to %lu\n", (unsigned long)_pipelined_reader->PieceSize());
+					}
+
+				} else {
+					unsigned long prev_bufsize = _io_buf.Size();
+					_io_buf.Desire(bufsize_optimal);
 
-				if (g_netrocks_verbosity > 0 && _io_buf.Size() != prev_bufsize) {
-					fprintf(stderr, "NetRocks: IO buffer size changed to %lu\n", (unsigned long)_io_buf.Size());
+					if (g_netrocks_verbosity > 0 && _io_buf.Size() != prev_bufsize) {
+						fprintf(stderr, "NetRocks: IO buffer size changed to %lu\n", (unsigned long)_io_buf.Size());
+					}
 				}
 			}
 
@@ -641,7 +986,7 @@ bool OpXfer::SymlinkCopy(const std::string &path_src, const std::string &path_ds
 		;
 
 	} else if (symlink_target[0] == '/') {
-		if (_entries.find(symlink_target) == _entries.end()) {
+		if (_entries.count(symlink_target) == 0) {
 			fprintf(stderr, "NetRocks: SymlinkCopy dismiss '%s' [%s]\n",
 				path_src.c_str(), orig_symlink_target.c_str());
 			return false;
@@ -681,7 +1026,7 @@ bool OpXfer::SymlinkCopy(const std::string &path_src, const std::string &path_ds
 			}
 		}
 
-		if (_entries.find(refined) == _entries.end()) {
+		if (_entries.count(refined) == 0) {
 			fprintf(stderr, "NetRocks: SymlinkCopy dismiss '%s' [%s] refined='%s;\n",
 				path_src.c_str(), orig_symlink_target.c_str(), refined.c_str());
 			return false;
@@ -709,4 +1054,7 @@ void OpXfer::ForcefullyAbort()
 {
 	OpBase::ForcefullyAbort();
 	_dst_host->Abort();
+	if (_parallel) {
+		_parallel->Abort();
+	}
 }
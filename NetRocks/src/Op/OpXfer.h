@@ -2,10 +2,13 @@
 #include "OpBase.h"
 #include "./Utils/Enumer.h"
 #include "./Utils/IOBuffer.h"
+#include "./Utils/PipelinedReader.h"
 #include "../UI/Defs.h"
 #include "../BackgroundTasks.h"
 
 
+class OpXferParallel;
+
 class OpXfer : protected OpBase, public IBackgroundTask
 {
 	Path2FileInformation _entries;
@@ -16,9 +19,11 @@ class OpXfer : protected OpBase, public IBackgroundTask
 	XferKind _kind;
 	XferDirection _direction;
 	IOBuffer _io_buf;
+	std::unique_ptr<PipelinedReader> _pipelined_reader;
 	bool _smart_symlinks_copy;
 	bool _umask_override;
 	bool _on_site_move = false;
+	std::unique_ptr<OpXferParallel> _parallel;
 
 	virtual void Process();
 
@@ -29,6 +34,7 @@ class OpXfer : protected OpBase, public IBackgroundTask
 	void Rename(const std::set<std::string> &items);
 	void EnsureDstDirExists();
 	void Transfer();
+	void FileCopy(const std::string &path_src, const std::string &path_dst, FileInformation &info);
 	void FileDelete(const std::string &path);
 	void DirectoryCopy(const std::string &path_dst, const FileInformation &info);
 	bool SymlinkCopy(const std::string &path_src, const std::string &path_dst);
@@ -28,14 +28,16 @@ void Enumer::Scan(bool recurse)
 			if (recurse) {
 				subpath = path;
 				subpath+= '/';
-				_scan_depth_limit = 255;
-				ScanItem(subpath);
+				if (!ScanItemRecursive(subpath)) {
+					_scan_depth_limit = 255;
+					ScanItem(subpath);
+				}
 			}
 		}
 	}
 }
 
-void Enumer::GetSubitems(const std::string &path, Path2FileInformation &subitems)
+void Enumer::GetSubitems(const std::string &path, Subitems &subitems)
 {
 	WhatOnErrorWrap<WEK_ENUMDIR>(_wea_state, _state, _host.get(), path,
 		[&] () mutable
@@ -47,7 +49,7 @@ void Enumer::GetSubitems(const std::string &path, Path2FileInformation &subitems
 				if (!enumer->Enum(name, owner, group, file_info)) {
 					break;
 				}
-				subitems.emplace(name, file_info);
+				subitems.emplace_back(name, file_info);
 				ProgressStateUpdate psu(_state); // check for abort/pause
 			}
 		}
@@ -56,7 +58,7 @@ void Enumer::GetSubitems(const std::string &path, Path2FileInformation &subitems
 
 void Enumer::ScanItem(const std::string &path)
 {
-	Path2FileInformation subitems;
+	Subitems subitems;
 	GetSubitems(path, subitems);
 
 	if (subitems.empty())
@@ -79,6 +81,42 @@ void Enumer::ScanItem(const std::string &path)
 	}
 }
 
+// lists whole tree by single request if host supports that, saving round-trip
+// per each subdirectory, returns false if not supported so caller must ScanItem
+bool Enumer::ScanItemRecursive(const std::string &path)
+{
+	if (_recursive_enum_unsupported)
+		return false;
+
+	WhatOnErrorWrap<WEK_ENUMDIR>(_wea_state, _state, _host.get(), path,
+		[&] () mutable
+		{
+			std::shared_ptr<IDirectoryEnumer> enumer;
+			try {
+				enumer = _host->DirectoryEnumRecursive(path);
+
+			} catch (ProtocolUnsupportedError &) {
+				_recursive_enum_unsupported = true;
+				return;
+			}
+
+			std::string name, owner, group, subpath;
+			FileInformation file_info;
+			for (;;) {
+				if (!enumer->Enum(name, owner, group, file_info)) {
+					break;
+				}
+				subpath = path;
+				subpath+= name;
+				OnScanningPath(subpath, &file_info);
+				ProgressStateUpdate psu(_state); // check for abort/pause
+			}
+		}
+	);
+
+	return !_recursive_enum_unsupported;
+}
+
 bool Enumer::OnScanningPath(const std::string &path, const FileInformation *file_info)
 {
 	FileInformation info = {};
@@ -96,7 +134,7 @@ bool Enumer::OnScanningPath(const std::string &path, const FileInformation *file
 		info.size = 0;
 	}
 
-	if (!_result.emplace(path, info).second)
+	if (!_result.emplace(path, info))
 		return false;
 
 	ProgressStateUpdate psu(_state);
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <set>
+#include <vector>
 #include <memory>
 #include <farplug-wide.h>
 #include "../../UI/Defs.h"
@@ -10,6 +11,8 @@
 
 class Enumer
 {
+	typedef std::vector<std::pair<std::string, FileInformation> > Subitems;
+
 	Path2FileInformation &_result;
 	std::shared_ptr<IHost> _host;
 	std::set<std::string> _items;
@@ -17,9 +20,11 @@ class Enumer
 	ProgressState &_state;
 	std::shared_ptr<WhatOnErrorState> _wea_state;
 	unsigned int _scan_depth_limit = 0;
+	bool _recursive_enum_unsupported = false;
 
-	void GetSubitems(const std::string &path, Path2FileInformation &subitems);
+	void GetSubitems(const std::string &path, Subitems &subitems);
 	void ScanItem(const std::string &path);
+	bool ScanItemRecursive(const std::string &path);
 	bool OnScanningPath(const std::string &path, const FileInformation *file_info = nullptr);
 
 public:
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <stdexcept>
+#include "PipelinedReader.h"
+
+PipelinedReader::PipelinedReader(size_t ring_size, size_t initial_size, size_t min_size, size_t max_size)
+	: _piece_size(initial_size), _min_size(min_size), _max_size(max_size)
+{
+	// one slot is owned by consumer, so need at least two to read ahead anything
+	ring_size = std::max(ring_size, (size_t)2);
+	for (size_t i = 0; i < ring_size; ++i) {
+		_ring.emplace_back(new Slot(initial_size, min_size, max_size));
+	}
+
+	if (!StartThread()) {
+		throw std::runtime_error("Cannot start reader thread");
+	}
+}
+
+PipelinedReader::~PipelinedReader()
+{
+	Stop();
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		_exiting = true;
+		_cond.notify_all();
+	}
+	WaitThread();
+}
+
+void *PipelinedReader::ThreadProc()
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	for (;;) {
+		if (_exiting) {
+			break;
+		}
+		if (!_reading || _filled == _ring.size()) {
+			_cond.wait(lock);
+			continue;
+		}
+
+		Slot &slot = *_ring[(_head + _filled) % _ring.size()];
+		std::shared_ptr<IFileReader> reader = _reader;
+		slot.buf.Desire(_piece_size, false);
+		size_t ask = slot.buf.Size();
+		if (_size < _pos + ask && _size > _pos) {
+			// use small buffer if gonna read small piece: IO may have small-read-optimized implementation
+			// but ask by one extra byte more to properly detect file being grew while copied
+			ask = (_size - _pos) + 1;
+		}
+		_busy = true;
+		lock.unlock();
+
+		size_t len = 0;
+		std::exception_ptr error;
+		try {
+			len = reader->Read(slot.buf.Data(), ask);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		reader.reset();
+
+		lock.lock();
+		_busy = false;
+		slot.len = len;
+		slot.asked = ask;
+		slot.error = error;
+		++_filled;
+		_pos+= len;
+		if (error || len == 0 || (len < ask && _pos == _size)) {
+			// error, EOF or pretty sure its EOF - same assumption consumer does
+			_reading = false;
+		}
+		_cond.notify_all();
+	}
+
+	return nullptr;
+}
+
+void PipelinedReader::Start(std::shared_ptr<IFileReader> reader, unsigned long long pos, unsigned long long size)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	_reader = reader;
+	_pos = pos;
+	_size = size;
+	_head = _filled = 0;
+	_reading = true;
+	_cond.notify_all();
+}
+
+void PipelinedReader::Stop()
+{
+	std::shared_ptr<IFileReader> reader;
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		_reading = false;
+		while (_busy) {
+			_cond.wait(lock);
+		}
+		for (auto &slot : _ring) {
+			slot->error = nullptr;
+		}
+		_head = _filled = 0;
+		reader.swap(_reader);
+	}
+	// reader released outside of lock cuz it may do some IO on release
+}
+
+const void *PipelinedReader::Fetch(size_t &len, size_t &asked)
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	while (_filled == 0) {
+		if (!_reading && !_busy) {
+			throw std::runtime_error("Fetch beyond end of reading");
+		}
+		_cond.wait(lock);
+	}
+
+	Slot &slot = *_ring[_head];
+	if (slot.error) {
+		std::rethrow_exception(slot.error);
+	}
+	len = slot.len;
+	asked = slot.asked;
+	return slot.buf.Data();
+}
+
+void PipelinedReader::Release()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	if (_filled) {
+		_head = (_head + 1) % _ring.size();
+		--_filled;
+		_cond.notify_all();
+	}
+}
+
+size_t PipelinedReader::PieceSize()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _piece_size;
+}
+
+void PipelinedReader::DesirePieceSize(size_t size)
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	_piece_size = std::min(std::max(size, _min_size), _max_size);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <exception>
+#include <condition_variable>
+#include <Threaded.h>
+#include "IOBuffer.h"
+#include "../../Protocol/Protocol.h"
+
+// Reads file by own thread into ring of buffers ahead of consumer, so reading of next pieces
+// overlaps with consumer's writing of previous ones. Thread and buffers persist across files,
+// so adaptively changed piece size and allocated memory reused.
+class PipelinedReader : protected Threaded
+{
+	struct Slot
+	{
+		IOBuffer buf;
+		size_t len = 0, asked = 0;
+		std::exception_ptr error;
+
+		Slot(size_t initial_size, size_t min_size, size_t max_size) : buf(initial_size, min_size, max_size) {}
+	};
+
+	std::vector<std::unique_ptr<Slot>> _ring;
+	std::mutex _mtx;
+	std::condition_variable _cond;
+	std::shared_ptr<IFileReader> _reader;
+	unsigned long long _pos = 0, _size = 0;
+	size_t _head = 0, _filled = 0;
+	size_t _piece_size, _min_size, _max_size;
+	bool _reading = false, _busy = false, _exiting = false;
+
+	virtual void *ThreadProc();
+
+public:
+	PipelinedReader(size_t ring_size, size_t initial_size, size_t min_size, size_t max_size);
+	virtual ~PipelinedReader();
+
+	// starts reading of file from given position, size is expected file size
+	void Start(std::shared_ptr<IFileReader> reader, unsigned long long pos, unsigned long long size);
+
+	// waits for read in progress, discards pieces read ahead and releases reader
+	void Stop();
+
+	// waits for next piece and returns its data, len and size that was asked when reading it,
+	// rethrows exception occured while reading that piece; piece must be released after use
+	const void *Fetch(size_t &len, size_t &asked);
+	void Release();
+
+	size_t PieceSize();
+	void DesirePieceSize(size_t size);
+};
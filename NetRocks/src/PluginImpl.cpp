@@ -118,6 +118,9 @@ PluginImpl::~PluginImpl()
 
 void PluginImpl::UpdatePathInfo()
 {
+	// location could change, so next listing may be served from directory cache
+	_dir_cache.AllowCached();
+
 	std::wstring tmp;
 	if (_remote) {
 		wcsncpy(_format, StrMB2Wide(_location.server).c_str(), ARRAYSIZE(_format) - 1);
@@ -197,7 +200,17 @@ int PluginImpl::GetFindData(PluginPanelItem **pPanelItem, int *pItemsNumber, int
 			}
 
 		} else {
-			OpEnumDirectory(OpMode, _remote, CurrentSiteDir(false), ppis, _wea_state).Do();
+			const std::string &site_dir = CurrentSiteDir(false);
+			if (!_dir_cache.Fetch(OpMode, _remote, site_dir, ppis)) {
+				const int initial_count = ppis.count;
+				const timespec &dir_mtime = _dir_cache.QueryModificationTime(OpMode, _remote, site_dir);
+				OpEnumDirectory oed(OpMode, _remote, site_dir, ppis, _wea_state);
+				// incomplete listing must not be served from cache later
+				if (oed.Do() && !oed.Skipped()) {
+					_dir_cache.Store(OpMode, _remote, site_dir, dir_mtime,
+						ppis.items + initial_count, ppis.count - initial_count);
+				}
+			}
 			//_remote->DirectoryEnum(CurrentSiteDir(false), il, OpMode);
 		}
 
@@ -879,6 +892,14 @@ void PluginImpl::StackedDirApply(StackedDir &sd)
 	UpdatePathInfo();
 }
 
+void PluginImpl::ProcessEventIdle()
+{
+	if (_remote && _dir_cache.CheckRevalidated()) {
+		G.info.Control(this, FCTL_UPDATEPANEL, 1, 0);
+		G.info.Control(this, FCTL_REDRAWPANEL, 0, 0);
+	}
+}
+
 int PluginImpl::ProcessEventCommand(const wchar_t *cmd)
 {
 	if (wcsstr(cmd, L"exit ") == cmd || wcscmp(cmd, L"exit") == 0) {
@@ -947,6 +968,7 @@ void PluginImpl::DismissRemoteHost()
 		g_conn_pool.reset(new ConnectionsPool);
 
 	g_conn_pool->Put(CurrentConnectionPoolId(), _remote);
+	_dir_cache.Reset();
 
 	if (_allow_remember_location_dir &&
 		_location.server_kind == Location::SK_SITE
@@ -9,6 +9,7 @@
 #include "BackgroundTasks.h"
 #include "Location.h"
 #include "SitesConfig.h"
+#include "DirectoryCache.h"
 
 class PluginImpl
 {
@@ -34,6 +35,7 @@ class PluginImpl
 
 	std::deque<StackedDir> _dir_stack;
 	std::shared_ptr<WhatOnErrorState> _wea_state = std::make_shared<WhatOnErrorState>();
+	DirectoryCache _dir_cache;
 
 	void StackedDirCapture(StackedDir &sd);
 	void StackedDirApply(StackedDir &sd);
@@ -77,4 +79,5 @@ public:
 	int MakeDirectory(const wchar_t **Name, int OpMode);
 	int ProcessKey(int Key, unsigned int ControlState);
 	int ProcessEventCommand(const wchar_t *cmd);
+	void ProcessEventIdle();
 };
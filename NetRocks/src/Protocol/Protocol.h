@@ -91,6 +91,11 @@ struct IProtocol
 	virtual std::shared_ptr<IFileReader> FileGet(const std::string &path, unsigned long long resume_pos = 0) = 0;
 	virtual std::shared_ptr<IFileWriter> FilePut(const std::string &path, mode_t mode, unsigned long long size_hint, unsigned long long resume_pos = 0) = 0;
 
+	/* optional: enumerates whole tree under path by single request, yielded names are paths relative
+	   to given path, entries are same as DirectoryEnum would give for each directory, symlinks not followed */
+	virtual std::shared_ptr<IDirectoryEnumer> DirectoryEnumRecursive(const std::string &path)
+		{ throw ProtocolUnsupportedError(""); }
+
 	virtual void ExecuteCommand(const std::string &working_dir, const std::string &command_line, const std::string &fifo)
 		{ throw ProtocolUnsupportedError(""); }
 };
@@ -83,6 +83,10 @@ SHELLFCN_CMD_ENUM() {
  fi
 }
 
+SHELLFCN_CMD_TREE() {
+ find -H "$SHELLVAR_ARG" -mindepth 1 -printf "$SHELLVAR_FIND_FMT_TREE" 2>>$SHELLVAR_LOG
+}
+
 SHELLFCN_CMD_INFO_SINGLE() {
  SHELLFCN_GET_INFO "$SHELLVAR_ARG" "$1" "$2" "$3" "$4"
 }
@@ -168,6 +172,56 @@ SHELLFCN_CMD_READ() {
  fi
 }
 
+SHELLFCN_CMD_READ_GZIP() {
+# same as SHELLFCN_CMD_READ with dd but each piece is compressed into temporary file
+# and then sent as separate gzip member, so +NEXT: tells compressed size of piece;
+# temporary files are kept in private directory made by mktemp, so nobody can meddle with them
+ $SHELLVAR_READ_FN SHELLVAR_OFFSET || exit
+ SHELLVAR_SIZE=`SHELLFCN_GET_SIZE "$SHELLVAR_ARG"`
+ if [ ! -n "$SHELLVAR_SIZE" ]; then
+    echo '+FAIL'
+    return
+ fi
+ SHELLVAR_ZDIR=`mktemp -d "$SHELLVAR_ZTMPL" 2>>$SHELLVAR_LOG`
+ if [ ! -n "$SHELLVAR_ZDIR" ] || [ ! -d "$SHELLVAR_ZDIR" ]; then
+    echo '+FAIL'
+    return
+ fi
+ SHELLVAR_ZTMP="$SHELLVAR_ZDIR/z"
+ SHELLVAR_STATE=
+ while true; do
+  SHELLVAR_REMAIN=`expr $SHELLVAR_SIZE - $SHELLVAR_OFFSET`
+  $SHELLVAR_READ_FN SHELLVAR_STATE || exit
+  if [ "$SHELLVAR_STATE" = 'abort' ]; then
+   echo '+ABORTED'
+   $SHELLVAR_READ_FN SHELLVAR_STATE || exit
+   break
+  fi
+  if [ $SHELLVAR_REMAIN -le 0 ]; then
+   echo '+DONE'
+   $SHELLVAR_READ_FN SHELLVAR_STATE || exit
+   break
+  fi
+  SHELLFCN_CHOOSE_BLOCK $SHELLVAR_REMAIN $SHELLVAR_OFFSET
+  SHELLVAR_PIECE=$SHELLVAR_REMAIN
+  # smaller pieces than for uncompressed read to overlap remote compression with transfer
+  [ $SHELLVAR_PIECE -gt 1048576 ] && SHELLVAR_PIECE=1048576
+  CNT=`expr $SHELLVAR_PIECE / $SHELLVAR_BLOCK`
+  SHELLVAR_PIECE=`expr $CNT '*' $SHELLVAR_BLOCK`
+  SHELLVAR_DDSKIP=`expr $SHELLVAR_OFFSET / $SHELLVAR_BLOCK`
+  ( dd iflag=fullblock skip=$SHELLVAR_DDSKIP count=$CNT bs=$SHELLVAR_BLOCK if="${SHELLVAR_ARG}" 2>>$SHELLVAR_LOG || echo "$?" >"$SHELLVAR_ZTMP.err" ) | gzip -c -1 >"$SHELLVAR_ZTMP" 2>>$SHELLVAR_LOG || echo 'gzip' >"$SHELLVAR_ZTMP.err"
+  if [ -f "$SHELLVAR_ZTMP.err" ]; then
+   ERR=`cat "$SHELLVAR_ZTMP.err"`
+   SHELLFCN_SEND_ERROR_AND_RESYNC "$ERR"
+   break
+  fi
+  echo '+NEXT:'`wc -c <"$SHELLVAR_ZTMP"`
+  cat "$SHELLVAR_ZTMP"
+  SHELLVAR_OFFSET=`expr $SHELLVAR_OFFSET + $SHELLVAR_PIECE`
+ done
+ rm -rf "$SHELLVAR_ZDIR"
+}
+
 SHELLFCN_WRITE_BY_DD() {
 # $1 - size
 # $2 - offset
@@ -345,6 +399,7 @@ SHELLFCN_CMD_EXECUTE() {
 
 SHELLVAR_STAT_FMT='%n %f %s %X %Y %Z %U %G'
 SHELLVAR_FIND_FMT='%f %M %s %A@ %T@ %C@ %u %g\n'
+SHELLVAR_FIND_FMT_TREE='%P %M %s %A@ %T@ %C@ %u %g\n'
 SHELLVAR_STAT_FMT_INFO='%f %s %X %Y %Z'
 SHELLVAR_FIND_FMT_INFO='%M %s %A@ %T@ %C@\n'
 SHELLVAR_STAT_FMT_SIZE='%s'
@@ -354,12 +409,15 @@ SHELLVAR_FIND_FMT_MODE='%M\n'
 
 SHELLVAR_READLINK_FN=SHELLFCN_READLINK_BY_LS
 SHELLVAR_FIND=
+SHELLVAR_FIND_TREE=
 SHELLVAR_STAT=
 SHELLVAR_LS_ARGS='-l -A'
 SHELLVAR_DD=
 SHELLVAR_HEAD=
 SHELLVAR_WRITE_BLOCK=
 SHELLVAR_BASE64=
+SHELLVAR_GZIP=
+SHELLVAR_ZTMPL="${TMPDIR:-/tmp}/far2l-nr.XXXXXX"
 SHELLVAR_ERRCNT=0
 SHELLVAR_GREP_ARGS=
 SHELLVAR_READ_FN=read
@@ -380,6 +438,11 @@ if find -H . -mindepth 0 -maxdepth 0 -printf "$SHELLVAR_FIND_FMT" >>$SHELLVAR_LO
  SHELLVAR_FIND=Y
 fi
 
+# tree listing is done by find even if stat used for everything else
+if find -H . -mindepth 0 -maxdepth 0 -printf "$SHELLVAR_FIND_FMT_TREE" >>$SHELLVAR_LOG 2>&1; then
+ SHELLVAR_FIND_TREE=Y
+fi
+
 if stat -L --format="$SHELLVAR_STAT_FMT" . >>$SHELLVAR_LOG 2>&1; then
  SHELLVAR_STAT=Y
 fi
@@ -413,12 +476,25 @@ fi
 
 [ "`echo aGVsbG8K | base64 -d 2>>$SHELLVAR_LOG`" = hello ] && SHELLVAR_BASE64=Y
 
+# compressed read needs dd for pieces and mktemp for private directory of temporary file,
+# without them peer uses uncompressed read
+if [ -n "$SHELLVAR_DD" ]; then
+ SHELLVAR_ZDIR=`mktemp -d "$SHELLVAR_ZTMPL" 2>>$SHELLVAR_LOG`
+ if [ -n "$SHELLVAR_ZDIR" ] && [ -d "$SHELLVAR_ZDIR" ]; then
+  if echo hello | gzip -c -1 >"$SHELLVAR_ZDIR/z" 2>>$SHELLVAR_LOG; then
+   [ "`gzip -d -c <"$SHELLVAR_ZDIR/z" 2>>$SHELLVAR_LOG`" = hello ] && SHELLVAR_GZIP=Y
+  fi
+  rm -rf "$SHELLVAR_ZDIR"
+ fi
+fi
+
 #debug
 #SHELLVAR_STAT=
 #SHELLVAR_FIND=
 #SHELLVAR_DD=
 #SHELLVAR_HEAD=
 #SHELLVAR_BASE64=
+#SHELLVAR_GZIP=
 #echo "SHELLVAR_LS_ARGS=$SHELLVAR_LS_ARGS"
 
 SHELLVAR_FEATS=
@@ -430,6 +506,9 @@ else
  SHELLVAR_FEATS="${SHELLVAR_FEATS}LS "
 fi
 
+[ -n "$SHELLVAR_FIND_TREE" ] && SHELLVAR_FEATS="${SHELLVAR_FEATS}TREE "
+[ -n "$SHELLVAR_GZIP" ] && SHELLVAR_FEATS="${SHELLVAR_FEATS}READ_GZIP "
+
 if [ -n "$SHELLVAR_DD" ]; then
  SHELLVAR_FEATS="${SHELLVAR_FEATS}READ_RESUME WRITE_RESUME "
 elif [ -n "$SHELLVAR_HEAD" ]; then
@@ -450,6 +529,7 @@ while true; do
  case "$SHELLVAR_CMD" in
   feats ) echo "FEATS ${SHELLVAR_FEATS} SHELL.FAR2L";;
   enum ) SHELLFCN_CMD_ENUM;;
+  tree ) SHELLFCN_CMD_TREE;;
   linfo ) SHELLFCN_CMD_INFO_SINGLE '0' "$SHELLVAR_STAT_FMT_INFO" "$SHELLVAR_FIND_FMT_INFO" '';;
   info ) SHELLFCN_CMD_INFO_SINGLE '1' "$SHELLVAR_STAT_FMT_INFO" "$SHELLVAR_FIND_FMT_INFO" '';;
   lsize ) SHELLFCN_CMD_INFO_SINGLE '0' "$SHELLVAR_STAT_FMT_SIZE" "$SHELLVAR_FIND_FMT_SIZE" 'n n n n y n';;
@@ -459,6 +539,7 @@ while true; do
   lmodes ) SHELLFCN_CMD_INFO_MULTI '0' "$SHELLVAR_STAT_FMT_MODE" "$SHELLVAR_FIND_FMT_MODE" 'y n n n n n';;
   modes ) SHELLFCN_CMD_INFO_MULTI '1' "$SHELLVAR_STAT_FMT_MODE" "$SHELLVAR_FIND_FMT_MODE" 'y n n n n n';;
   read ) SHELLFCN_CMD_READ;;
+  zread ) SHELLFCN_CMD_READ_GZIP;;
   write ) SHELLFCN_CMD_WRITE;;
   rmfile ) SHELLFCN_CMD_REMOVE_FILE;;
   rmdir ) SHELLFCN_CMD_REMOVE_DIR;;
@@ -54,7 +54,7 @@ static unsigned int ParseModeByStatOrFindLine(const std::string &s)
 	return ShellParseUtils::Str2Mode(s.c_str(), s.size());
 }
 
-static bool SHELLParseEnumByStatOrFindLine(FileInfo &fi, std::string line)
+static bool SHELLParseEnumByStatOrFindLine(FileInfo &fi, std::string line, bool keep_subpath)
 {
 	StrTrim(line, " \t\n");
 	// NAME MODE SIZE TIME_ACC TIME_MOD TIME_ST OWNER GROUP
@@ -67,7 +67,7 @@ static bool SHELLParseEnumByStatOrFindLine(FileInfo &fi, std::string line)
 	fi.size = (uint64_t)strtoull(FetchTail(line).c_str(), nullptr, 10);
 	fi.mode = ParseModeByStatOrFindLine(FetchTail(line));
 	StrTrim(line, " \t\n");
-	const size_t p = line.rfind('/');
+	const size_t p = keep_subpath ? std::string::npos : line.rfind('/');
 	if (p != std::string::npos) {
 		fi.path = line.substr(p + 1);
 	} else {
@@ -76,12 +76,12 @@ static bool SHELLParseEnumByStatOrFindLine(FileInfo &fi, std::string line)
 	return !fi.path.empty() && fi.path != "." && fi.path != "..";
 }
 
-void SHELLParseEnumByStatOrFind(std::vector<FileInfo> &files, const std::vector<std::string> &lines)
+void SHELLParseEnumByStatOrFind(std::vector<FileInfo> &files, const std::vector<std::string> &lines, bool keep_subpaths)
 {
 	for (const auto &line : lines) {
 		if (!line.empty()) {
 			files.emplace_back();
-			if (!SHELLParseEnumByStatOrFindLine(files.back(), line)) {
+			if (!SHELLParseEnumByStatOrFindLine(files.back(), line, keep_subpaths)) {
 				files.pop_back();
 			}
 		}
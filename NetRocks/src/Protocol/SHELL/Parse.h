@@ -16,7 +16,7 @@ struct FileInfo
 	timespec access_time{}, modification_time{}, status_change_time{};
 };
 
-void SHELLParseEnumByStatOrFind(std::vector<FileInfo> &files, const std::vector<std::string> &lines);
+void SHELLParseEnumByStatOrFind(std::vector<FileInfo> &files, const std::vector<std::string> &lines, bool keep_subpaths = false);
 void SHELLParseInfoByStatOrFind(FileInformation &fi, std::string &line);
 uint64_t SHELLParseSizeByStatOrFind(std::string &line);
 uint32_t SHELLParseModeByStatOrFind(std::string &line);
@@ -12,6 +12,9 @@
 #include "RemoteSh.h"
 #include <base64.h>
 #include <utils.h>
+#ifdef HAVE_ZLIB
+# include <zlib.h>
+#endif
 
 #include <cstdlib> // для getenv
 
@@ -120,6 +123,8 @@ void ProtocolSHELL::ParseFeatsLine(const std::string &feats_line)
 	_feats.using_stat = (feats_line.find(" STAT ") != std::string::npos);
 	_feats.using_find = (feats_line.find(" FIND ") != std::string::npos);
 	_feats.using_ls = (feats_line.find(" LS ") != std::string::npos);
+	_feats.support_tree = (feats_line.find(" TREE ") != std::string::npos);
+	_feats.support_read_gzip = (feats_line.find(" READ_GZIP ") != std::string::npos);
 	if (feats_line.find(" READ_RESUME ") != std::string::npos) {
 		_feats.support_read = _feats.support_read_resume = true;
 	}
@@ -186,8 +191,8 @@ void ProtocolSHELL::Initialize()
 			}
 		}
 	}
-	fprintf(stderr, "[SHELL] stat=%u find=%u ls=%u read=%u r/resume:%u write:%u w/resume:%u w/base64:%u w/block:%u*%u\n",
-		_feats.using_stat, _feats.using_find, _feats.using_ls, _feats.support_read, _feats.support_read_resume,
+	fprintf(stderr, "[SHELL] stat=%u find=%u ls=%u tree=%u read=%u r/resume:%u r/gzip:%u write:%u w/resume:%u w/base64:%u w/block:%u*%u\n",
+		_feats.using_stat, _feats.using_find, _feats.using_ls, _feats.support_tree, _feats.support_read, _feats.support_read_resume, _feats.support_read_gzip,
 		_feats.support_write, _feats.support_write_resume, _feats.require_write_base64,
 		_feats.require_write_block, _feats.limit_max_blocks);
 }
@@ -436,18 +441,22 @@ private:
 	size_t _index = 0;
 
 public:
-	SHELLDirectoryEnumer(std::shared_ptr<WayToShell> &app, const std::string &path, const RemoteFeats &feats)
+	SHELLDirectoryEnumer(std::shared_ptr<WayToShell> &app, const std::string &path, const RemoteFeats &feats, bool recursive = false)
 		: _way(app)
 	{
 		auto wr = _way->SendAndWaitReply(
-			Request("enum ").Add(path, '\n'),
+			Request(recursive ? "tree " : "enum ").Add(path, '\n'),
 			s_prompt_or_error
 		);
 		if (wr.index != 0) {
 			_way->WaitReply(s_prompt);
 			throw ProtocolError("dir query error");
 		}
-		if (feats.using_stat || feats.using_find) {
+		if (recursive) { // tree always listed by find and gives paths relative to given one
+			wr.stdout_lines.pop_back(); // get rid of reply
+			SHELLParseEnumByStatOrFind(_files, wr.stdout_lines, true);
+
+		} else if (feats.using_stat || feats.using_find) {
 			wr.stdout_lines.pop_back(); // get rid of reply
 			SHELLParseEnumByStatOrFind(_files, wr.stdout_lines);
 
@@ -499,6 +508,16 @@ std::shared_ptr<IDirectoryEnumer> ProtocolSHELL::DirectoryEnum(const std::string
 	return std::shared_ptr<IDirectoryEnumer>(new SHELLDirectoryEnumer(_way, path, _feats));
 }
 
+std::shared_ptr<IDirectoryEnumer> ProtocolSHELL::DirectoryEnumRecursive(const std::string &path)
+{
+	if (!_feats.support_tree) {
+		throw ProtocolUnsupportedError("tree listing unsupported");
+	}
+	fprintf(stderr, "[SHELL] Tree '%s'\n", path.c_str());
+	FinalizeExecCmd();
+	return std::shared_ptr<IDirectoryEnumer>(new SHELLDirectoryEnumer(_way, path, _feats, true));
+}
+
 class SHELLFileReader : public IFileReader
 {
 	std::shared_ptr<WayToShell> _way;
@@ -530,11 +549,11 @@ class SHELLFileReader : public IFileReader
 
 
 public:
-	SHELLFileReader(std::shared_ptr<WayToShell> &app, const std::string &path, unsigned long long resume_pos)
+	SHELLFileReader(std::shared_ptr<WayToShell> &app, const std::string &path, unsigned long long resume_pos, const char *cmd = "read ")
 		: _way(app)
 	{
 		_way->Send(
-			Request("read ").Add(path, '\n').AddFmt("%llu\n", resume_pos).Add("cont", '\n')
+			Request(cmd).Add(path, '\n').AddFmt("%llu\n", resume_pos).Add("cont", '\n')
 		);
 	}
 
@@ -579,6 +598,61 @@ public:
 	}
 };
 
+#ifdef HAVE_ZLIB
+// Remote side sends each piece of file as separate gzip member, so its just
+// inflated continuously with reset of inflater at the end of each member.
+class SHELLFileReaderGzip : public SHELLFileReader
+{
+	z_stream _zs{};
+	std::vector<unsigned char> _in;
+	bool _member_open{false};
+
+public:
+	SHELLFileReaderGzip(std::shared_ptr<WayToShell> &app, const std::string &path, unsigned long long resume_pos)
+		: SHELLFileReader(app, path, resume_pos, "zread "), _in(0x10000)
+	{
+		const int r = inflateInit2(&_zs, 16 + MAX_WBITS);
+		if (r != Z_OK) {
+			throw ProtocolError("inflateInit2", r);
+		}
+	}
+
+	virtual ~SHELLFileReaderGzip()
+	{
+		inflateEnd(&_zs);
+	}
+
+	virtual size_t Read(void *buf, size_t len)
+	{
+		_zs.next_out = (Bytef *)buf;
+		_zs.avail_out = (uInt)std::min(len, (size_t)0x40000000);
+		while (_zs.avail_out != 0) {
+			if (_zs.avail_in == 0) {
+				const size_t piece = SHELLFileReader::Read(_in.data(), _in.size());
+				if (piece == 0) {
+					if (_member_open) {
+						throw ProtocolError("truncated compressed data");
+					}
+					break;
+				}
+				_zs.next_in = _in.data();
+				_zs.avail_in = (uInt)piece;
+				_member_open = true;
+			}
+			const int r = inflate(&_zs, Z_NO_FLUSH);
+			if (r == Z_STREAM_END) {
+				inflateReset(&_zs);
+				_member_open = (_zs.avail_in != 0);
+
+			} else if (r != Z_OK) {
+				throw ProtocolError("inflate", r);
+			}
+		}
+		return (size_t)((unsigned char *)_zs.next_out - (unsigned char *)buf);
+	}
+};
+#endif
+
 class SHELLFileWriter : public IFileWriter
 {
 	std::shared_ptr<WayToShell> _way;
@@ -718,6 +792,12 @@ std::shared_ptr<IFileReader> ProtocolSHELL::FileGet(const std::string &path, uns
 		throw ProtocolUnsupportedError("read-resume unsupported");
 	}
 
+#ifdef HAVE_ZLIB
+	if (_feats.support_read_gzip && _protocol_options.GetInt("Compression", 0) != 0) {
+		return std::make_shared<SHELLFileReaderGzip>(_way, path, resume_pos);
+	}
+#endif
+
 	return std::make_shared<SHELLFileReader>(_way, path, resume_pos);
 }
 
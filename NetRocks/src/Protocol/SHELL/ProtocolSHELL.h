@@ -19,8 +19,10 @@ struct RemoteFeats
 	bool using_stat : 1;
 	bool using_find : 1;
 	bool using_ls : 1;
+	bool support_tree : 1;
 	bool support_read : 1;
 	bool support_read_resume : 1;
+	bool support_read_gzip : 1;
 	bool support_write : 1;
 	bool support_write_resume : 1;
 	bool require_write_base64 : 1;
@@ -114,6 +116,7 @@ public:
 	virtual void SymlinkQuery(const std::string &link_path, std::string &link_target);
 
 	virtual std::shared_ptr<IDirectoryEnumer> DirectoryEnum(const std::string &path);
+	virtual std::shared_ptr<IDirectoryEnumer> DirectoryEnumRecursive(const std::string &path);
 	virtual std::shared_ptr<IFileReader> FileGet(const std::string &path, unsigned long long resume_pos = 0);
 	virtual std::shared_ptr<IFileWriter> FilePut(const std::string &path, mode_t mode, unsigned long long size_hint, unsigned long long resume_pos = 0);
 
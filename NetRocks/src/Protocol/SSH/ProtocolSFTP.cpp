@@ -77,6 +77,7 @@ struct SFTPConnection : SSHConnection
 	SFTPSession sftp;
 	size_t max_read_block = 32768; // default value
 	size_t max_write_block = 32768; // default value
+	size_t write_pipeline = 16; // default value
 
 	SFTPConnection(const std::string &host, unsigned int port, const std::string &username,
 		const std::string &password, const StringConfig &protocol_options)
@@ -85,6 +86,7 @@ struct SFTPConnection : SSHConnection
 	{
 		max_read_block = (size_t)std::max(protocol_options.GetInt("MaxReadBlock", max_read_block), 512);
 		max_write_block = (size_t)std::max(protocol_options.GetInt("MaxWriteBlock", max_write_block), 512);
+		write_pipeline = (size_t)std::max(protocol_options.GetInt("WritePipeline", write_pipeline), 1);
 
 		const std::string &subsystem = protocol_options.GetString("CustomSubsystem");
 		if (!subsystem.empty() && protocol_options.GetInt("UseCustomSubsystem", 0) != 0) {
@@ -652,12 +654,79 @@ public:
 };
 
 
+// libssh has asynchronous write API since 0.11.0, with older versions have to write synchronously
+#if (LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0))
+# define SFTP_ASYNC_WRITE
+#endif
+
 class SFTPFileWriter : protected SFTPFileIO, public IFileWriter
 {
+#ifdef SFTP_ASYNC_WRITE
+	// pipeline of write requests that were sent but not yet replied
+	std::deque<sftp_aio> _pipeline;
+
+	// max size of single write request, limited also by server
+	size_t _max_write_block;
+
+	bool AsyncWriteComplete()
+	{
+		sftp_aio aio = _pipeline.front();
+		_pipeline.pop_front();
+		ssize_t r = sftp_aio_wait_write(&aio);
+		if (aio) {
+			sftp_aio_free(aio);
+		}
+		return r >= 0;
+	}
+
+	// replies on all pipelined requests must be fetched even after failure to keep session consistent
+	void AsyncWriteFailed()
+	{
+		const std::string error = ssh_get_error(_conn->ssh);
+		while (!_pipeline.empty()) {
+			AsyncWriteComplete();
+		}
+		throw ProtocolError("write error", error.c_str());
+	}
+
+	void AsyncWriteCompleteUntil(size_t pipeline_size_limit)
+	{
+		while (_pipeline.size() > pipeline_size_limit) {
+			if (!AsyncWriteComplete()) {
+				AsyncWriteFailed();
+			}
+		}
+	}
+#endif
+
 public:
 	SFTPFileWriter(std::shared_ptr<SFTPConnection> &conn, const std::string &path, int flags, mode_t mode, unsigned long long resume_pos)
 		: SFTPFileIO(conn, path, flags, mode, resume_pos)
 	{
+#ifdef SFTP_ASYNC_WRITE
+		_max_write_block = _conn->max_write_block;
+		sftp_limits_t limits = sftp_limits(_conn->sftp);
+		if (limits) {
+			if (limits->max_write_length && limits->max_write_length < _max_write_block) {
+				_max_write_block = (size_t)limits->max_write_length;
+			}
+			sftp_limits_free(limits);
+		}
+#endif
+	}
+
+	~SFTPFileWriter()
+	{
+#ifdef SFTP_ASYNC_WRITE
+		if (!_pipeline.empty()) {
+			if (g_netrocks_verbosity > 0) {
+				fprintf(stderr, "~SFTPFileWriter: still pipelined %u\n", (unsigned int)_pipeline.size());
+			}
+			do {
+				AsyncWriteComplete();
+			} while (!_pipeline.empty());
+		}
+#endif
 	}
 
 	virtual void Write(const void *buf, size_t len)
@@ -666,7 +735,24 @@ public:
 		if ( (rand() % 100) + 1 <= SIMULATED_WRITE_FAILS_RATE)
 			throw ProtocolError("Simulated write file error");
 #endif
-		// somewhy libssh doesnt have async write yet
+#ifdef SFTP_ASYNC_WRITE
+		while (len > 0) {
+			AsyncWriteCompleteUntil(_conn->write_pipeline - 1);
+
+			sftp_aio aio = nullptr;
+			ssize_t sent = sftp_aio_begin_write(_file, buf, std::min(len, _max_write_block), &aio);
+			if (sent <= 0) {
+				if (aio) {
+					sftp_aio_free(aio);
+				}
+				AsyncWriteFailed();
+			}
+			_pipeline.emplace_back(aio);
+
+			len-= (size_t)sent;
+			buf = (const char *)buf + sent;
+		}
+#else
 		if (len > 0) for (;;) {
 			size_t piece = (len >= _conn->max_write_block) ? _conn->max_write_block : len;
 			ssize_t written = sftp_write(_file, buf, piece);
@@ -680,6 +766,7 @@ public:
 			len-= (size_t)written;
 			buf = (const char *)buf + written;
 		}
+#endif
 	}
 
 	virtual void WriteComplete()
@@ -688,7 +775,9 @@ public:
 		if ( (rand() % 100) + 1 <= SIMULATED_WRITE_COMPLETE_FAILS_RATE)
 			throw ProtocolError("Simulated write-complete file error");
 #endif
-		// what?
+#ifdef SFTP_ASYNC_WRITE
+		AsyncWriteCompleteUntil(0);
+#endif
 	}
 };
 
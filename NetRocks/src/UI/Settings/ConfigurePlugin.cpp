@@ -15,6 +15,7 @@
 | [x] <ENTER> to execute files remotely when possible        |
 | [x] Smart symlinks copying                                 |
 | [ ] Copy attributes that overrides umask                   |
+| [x] Overlap reading and writing while copying              |
 | [ ] Remember working directory in site settings            |
 | Connections pool expiration (seconds):               [   ] |
 | [ ] Connect using proxy (requires tsocks library)          |
@@ -60,6 +61,7 @@ class ConfigurePlugin : protected BaseDialog
 	int _i_enter_exec_remotely = -1;
 	int _i_smart_symlinks_copy = -1;
 	int _i_umask_override = -1;
+	int _i_overlapped_copy = -1;
 	int _i_remember_directory = -1;
 	int _i_conn_pool_expiration = -1;
 	int _i_use_proxy = -1, _i_edit_tsocks_config = -1;
@@ -111,6 +113,9 @@ public:
 		_di.NextLine();
 		_i_umask_override = _di.AddAtLine(DI_CHECKBOX, 5,62, 0, MUMaskOverride);
 
+		_di.NextLine();
+		_i_overlapped_copy = _di.AddAtLine(DI_CHECKBOX, 5,62, 0, MOverlappedCopy);
+
 		_di.NextLine();
 		_i_remember_directory = _di.AddAtLine(DI_CHECKBOX, 5,62, 0, MRememberDirectory);
 
@@ -142,6 +147,7 @@ public:
 		SetCheckedDialogControl( _i_enter_exec_remotely, G.GetGlobalConfigBool("EnterExecRemotely", true) );
 		SetCheckedDialogControl( _i_smart_symlinks_copy, G.GetGlobalConfigBool("SmartSymlinksCopy", true) );
 		SetCheckedDialogControl( _i_umask_override, G.GetGlobalConfigBool("UMaskOverride", false) );
+		SetCheckedDialogControl( _i_overlapped_copy, G.GetGlobalConfigBool("OverlappedCopy", true) );
 		SetCheckedDialogControl( _i_remember_directory, G.GetGlobalConfigBool("RememberDirectory", false) );
 		LongLongToDialogControl( _i_conn_pool_expiration, G.GetGlobalConfigInt("ConnectionsPoolExpiration", 30) );
 		SetCheckedDialogControl( _i_use_proxy, G.GetGlobalConfigBool("UseProxy", false) );
@@ -152,6 +158,7 @@ public:
 			gcw.SetBool("EnterExecRemotely", IsCheckedDialogControl(_i_enter_exec_remotely) );
 			gcw.SetBool("SmartSymlinksCopy", IsCheckedDialogControl(_i_smart_symlinks_copy) );
 			gcw.SetBool("UMaskOverride", IsCheckedDialogControl(_i_umask_override) );
+			gcw.SetBool("OverlappedCopy", IsCheckedDialogControl(_i_overlapped_copy) );
 			gcw.SetBool("RememberDirectory", IsCheckedDialogControl(_i_remember_directory) );
 			gcw.SetInt("ConnectionsPoolExpiration", LongLongFromDialogControl( _i_conn_pool_expiration) );
 			gcw.SetBool("UseProxy", IsCheckedDialogControl(_i_use_proxy) );
@@ -16,6 +16,7 @@
 | Compression:          [COMBOBOX Compressed traffic       ] |
 | Max read block size, bytes:                 [9999999]      |
 | Max write block size, bytes:                [9999999]      |
+| Write pipeline length, requests:            [###]          |
 | Automatically retry connect, times:         [##]           |
 | Connection timeout, seconds:                [###]          |
 | Allowed host keys:    [EDIT..............................] |
@@ -35,7 +36,7 @@ class ProtocolOptionsSFTPSCP : protected BaseDialog
 	int _i_auth_mode = -1, _i_privkey_path = -1;
 	int _i_use_custom_subsystem = -1, _i_custom_subsystem = -1;
 	int _i_compression = -1;
-	int _i_max_read_block_size = -1, _i_max_write_block_size = -1;
+	int _i_max_read_block_size = -1, _i_max_write_block_size = -1, _i_write_pipeline = -1;
 	int _i_connect_retries = -1, _i_connect_timeout = -1;
 	int _i_allowed_hostkeys = -1;
 	int _i_openssh_configs = -1;
@@ -188,6 +189,10 @@ public:
 			_di.NextLine();
 			_di.AddAtLine(DI_TEXT, 5,50, 0, MSFTPMaxWriteBlockSize);
 			_i_max_write_block_size = _di.AddAtLine(DI_FIXEDIT, 51,60, DIF_MASKEDIT, "32768", "9999999999");
+
+			_di.NextLine();
+			_di.AddAtLine(DI_TEXT, 5,50, 0, MSFTPWritePipeline);
+			_i_write_pipeline = _di.AddAtLine(DI_FIXEDIT, 51,53, DIF_MASKEDIT, "16", "999");
 			_di.NextLine();
 		}
 
@@ -269,6 +274,9 @@ public:
 		if (_i_max_write_block_size != -1) {
 			LongLongToDialogControl(_i_max_write_block_size, std::max((int)512, sc.GetInt("MaxWriteBlock", 32768)));
 		}
+		if (_i_write_pipeline != -1) {
+			LongLongToDialogControl(_i_write_pipeline, std::max((int)1, sc.GetInt("WritePipeline", 16)));
+		}
 
 		SetCheckedDialogControl(_i_tcp_nodelay, sc.GetInt("TcpNoDelay", 1) != 0);
 		SetCheckedDialogControl(_i_tcp_quickack, sc.GetInt("TcpQuickAck", 0) != 0);
@@ -309,6 +317,9 @@ public:
 			if (_i_max_write_block_size != -1) {
 				sc.SetInt("MaxWriteBlock", std::max((int)512, (int)LongLongFromDialogControl(_i_max_write_block_size)));
 			}
+			if (_i_write_pipeline != -1) {
+				sc.SetInt("WritePipeline", std::max((int)1, (int)LongLongFromDialogControl(_i_write_pipeline)));
+			}
 			sc.SetInt("TcpNoDelay", IsCheckedDialogControl(_i_tcp_nodelay) ? 1 : 0);
 			sc.SetInt("TcpQuickAck", IsCheckedDialogControl(_i_tcp_quickack) ? 1 : 0);
 			sc.SetInt("IgnoreTimeModeErrors", IsCheckedDialogControl(_i_ignore_time_and_mode_errors) ? 1 : 0);
@@ -23,6 +23,8 @@
 | Option7        :              [                 ] |
 | Option8        :              [                 ] |
 |---------------------------------------------------|
+| [ ] Compress downloaded data if possible          |
+|---------------------------------------------------|
 | [  OK    ]    [ Cancel ]                          |
  ===================================================
     6                     29       38 
@@ -35,7 +37,7 @@ class ProtocolOptionsSHELL : protected BaseDialog
 
 	std::string _ways_ini;
 
-	int _i_ok = -1, _i_cancel = -1, _i_way = -1;
+	int _i_ok = -1, _i_cancel = -1, _i_way = -1, _i_compression = -1;
 
 	FarListWrapper _di_ways;
 	struct Option
@@ -124,10 +126,18 @@ public:
 		_di.NextLine();
 		_di.AddAtLine(DI_TEXT, 4,49, DIF_BOXCOLOR | DIF_SEPARATOR);
 
+		_di.NextLine();
+		_i_compression = _di.AddAtLine(DI_CHECKBOX, 5,53, 0, MSHELLCompression);
+
+		_di.NextLine();
+		_di.AddAtLine(DI_TEXT, 4,49, DIF_BOXCOLOR | DIF_SEPARATOR);
+
 		_di.NextLine();
 		_i_ok = _di.AddAtLine(DI_BUTTON, 7,11, DIF_CENTERGROUP, MOK);
 		_i_cancel = _di.AddAtLine(DI_BUTTON, 12,23, DIF_CENTERGROUP, MCancel);
 
+		SetCheckedDialogControl(_i_compression, _sc.GetInt("Compression", 0) != 0);
+
 		SetFocusedDialogControl(_i_ok);
 		SetDefaultDialogControl(_i_ok);
 	}
@@ -139,6 +149,7 @@ public:
 		TextFromDialogControl(_i_way, _way);
 		if (r == _i_ok) {
 			_sc.SetString("Way", _way);
+			_sc.SetInt("Compression", IsCheckedDialogControl(_i_compression) ? 1 : 0);
 			WayToShellConfig cfg(_ways_ini, _way);
 			unsigned i = 0;
 			for (auto &opt : _opts) {
@@ -55,6 +55,8 @@ static BOOL __stdcall EnumCodePagesProc(LPWSTR lpwszCodePage)
 | Keep alive:                      [INTEG]                   |
 | Codepage:                        [COMBOBOX               ] |
 | Time adjust, seconds:            [99999]                   |
+| Parallel transfer connections:   [99]                      |
+| [x] Keep directories listings in persistent cache          |
 | Command to execute on connect:                             |
 | [EDIT....................................................] |
 | Extra string passed to command:                            |
@@ -71,7 +73,8 @@ static BOOL __stdcall EnumCodePagesProc(LPWSTR lpwszCodePage)
 class ExtraSiteSettings : protected BaseDialog
 {
 	int _i_ok = -1, _i_cancel = -1;
-	int _i_keepalive = -1, _i_codepage = -1, _i_timeadjust = -1;
+	int _i_keepalive = -1, _i_codepage = -1, _i_timeadjust = -1, _i_transfer_connections = -1;
+	int _i_persistent_dir_cache = -1;
 	int _i_command = -1, _i_command_deinit = -1, _i_extra = -1, _i_command_time_limit = -1;
 	FarListWrapper _di_codepages;
 
@@ -108,6 +111,14 @@ public:
 		itoa(sc.GetInt("TimeAdjust", 0), sz, 10);
 		_i_timeadjust = _di.AddAtLine(DI_FIXEDIT, 57,62, DIF_MASKEDIT, sz, "#99999");
 
+		_di.NextLine();
+		_di.AddAtLine(DI_TEXT, 5,56, 0, MTransferConnections);
+		itoa(std::max(1, sc.GetInt("TransferConnections", 1)), sz, 10);
+		_i_transfer_connections = _di.AddAtLine(DI_FIXEDIT, 57,62, DIF_MASKEDIT, sz, "99");
+
+		_di.NextLine();
+		_i_persistent_dir_cache = _di.AddAtLine(DI_CHECKBOX, 5,62, 0, MPersistentDirCache);
+
 		_di.NextLine();
 		_di.AddAtLine(DI_TEXT, 5,37, 0, MCodepage);
 		_i_codepage = _di.AddAtLine(DI_COMBOBOX, 38,62, DIF_DROPDOWNLIST | DIF_LISTAUTOHIGHLIGHT | DIF_LISTNOAMPERSAND, "");
@@ -152,6 +163,7 @@ public:
 		TextToDialogControl(_i_command_deinit, sc.GetString("CommandDeinit"));
 		TextToDialogControl(_i_extra, sc.GetString("Extra"));
 
+		SetCheckedDialogControl(_i_persistent_dir_cache, sc.GetInt("PersistentDirCache", 0) != 0);
 		LongLongToDialogControl(_i_command_time_limit, std::max(3, sc.GetInt("CommandTimeLimit", 30)));
 		if (Show(L"ExtraSiteSettings", 6, 2) == _i_ok) {
 			std::string str;
@@ -164,6 +176,8 @@ public:
 			sc.SetInt("CommandTimeLimit", std::max(3, (int)LongLongFromDialogControl(_i_command_time_limit)));
 			sc.SetInt("KeepAlive", std::max(0, (int)LongLongFromDialogControl(_i_keepalive)));
 			sc.SetInt("TimeAdjust", (int)LongLongFromDialogControl(_i_timeadjust));
+			sc.SetInt("TransferConnections", std::max(1, (int)LongLongFromDialogControl(_i_transfer_connections)));
+			sc.SetInt("PersistentDirCache", IsCheckedDialogControl(_i_persistent_dir_cache) ? 1 : 0);
 
 			{
 				int cp_index = GetDialogListPosition(_i_codepage);
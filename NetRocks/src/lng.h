@@ -17,6 +17,7 @@ enum LanguageID
 	MEnterExecRemotely,
 	MSmartSymlinksCopy,
 	MUMaskOverride,
+	MOverlappedCopy,
 	MRememberDirectory,
 	MConnPoolExpiration,
 	MConnectUsingProxy,
@@ -45,6 +46,8 @@ enum LanguageID
 	MKeepAlive,
 	MCodepage,
 	MTimeAdjust,
+	MTransferConnections,
+	MPersistentDirCache,
 	MDisplayName,
 	MExtraOptions,
 	MProtocolOptions,
@@ -221,6 +224,7 @@ enum LanguageID
 	MSFTPCustomSubsystem,
 	MSFTPMaxReadBlockSize,
 	MSFTPMaxWriteBlockSize,
+	MSFTPWritePipeline,
 	MSFTPTCPNodelay,
 	MSFTPTCPQuickAck,
 	MSFTPIgnoreTimeAndModeErrors,
@@ -290,5 +294,6 @@ enum LanguageID
 
 	MSHELLOptionsTitle,
 	MSHELLWay,
-	MSHELLWaySettings
+	MSHELLWaySettings,
+	MSHELLCompression
 };
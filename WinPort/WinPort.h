@@ -183,6 +183,7 @@ extern "C" {
 #define FIND_FILE_FLAG_NO_CUR_UP	0x10 //skip virtual . and ..
 #define FIND_FILE_FLAG_CASE_INSENSITIVE	0x1000 //currently affects only english characters
 #define FIND_FILE_FLAG_NOT_ANNOYING	0x2000 //avoid sudo prompt if can't query some not very important information without it
+#define FIND_FILE_FLAG_PARALLEL_STAT	0x4000 //read names by batches and query their attributes using several threads
 
 	WINPORT_DECL(FindFirstFileWithFlags, HANDLE, (LPCWSTR lpFileName, LPWIN32_FIND_DATAW lpFindFileData, DWORD dwFlags));
 	WINPORT_DECL(FindFirstFile, HANDLE, (LPCWSTR lpFileName, LPWIN32_FIND_DATAW lpFindFileData));
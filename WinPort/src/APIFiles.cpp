@@ -7,6 +7,7 @@
 #include <fstream>
 #include <mutex>
 #include <utils.h>
+#include <WorkStealingPool.h>
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -569,7 +570,16 @@ extern "C"
 		}
 
 	public:
+		Statocaster() : _attr(INVALID_FILE_ATTRIBUTES)
+		{
+		}
+
 		Statocaster(const char *pathname, const char *name = nullptr)
+		{
+			Query(pathname, name);
+		}
+
+		void Query(const char *pathname, const char *name = nullptr)
 		{
 			if (os_call_int(sdc_lstat, pathname, &_st_lnk) < 0) {
 				_attr = INVALID_FILE_ATTRIBUTES;
@@ -730,6 +740,10 @@ extern "C"
 
 		bool Iterate(LPWIN32_FIND_DATAW lpFindFileData)
 		{
+			if ((_flags & FIND_FILE_FLAG_PARALLEL_STAT) != 0) {
+				return IterateBatched(lpFindFileData);
+			}
+
 			struct dirent *de;
 			for (;;) {
 				if (!_d)
@@ -742,18 +756,7 @@ extern "C"
 
 #ifndef __HAIKU__
 				if (PreMatchDType(de->d_type) && MatchName(de->d_name) ) {
-					mode_t hint_mode_type = 0;
-					switch (de-> d_type) {
-						case DT_DIR: hint_mode_type = S_IFDIR; break;
-						case DT_REG: hint_mode_type = S_IFREG; break;
-						case DT_LNK: hint_mode_type = S_IFLNK; break;
-						case DT_BLK: hint_mode_type = S_IFBLK; break;
-						case DT_FIFO: hint_mode_type = S_IFIFO; break;
-						case DT_CHR: hint_mode_type = S_IFCHR; break;
-						case DT_SOCK: hint_mode_type = S_IFSOCK; break;
-						default: hint_mode_type = 0;
-					}
-					if (MatchAttributesAndFillWFD(de->d_name, lpFindFileData, hint_mode_type))
+					if (MatchAttributesAndFillWFD(de->d_name, lpFindFileData, DTypeToModeType(de->d_type)))
 #else
 				if (MatchName(de->d_name) ) {
 					if (MatchAttributesAndFillWFD(de->d_name, lpFindFileData))
@@ -782,17 +785,140 @@ extern "C"
 			wfd->cFileName[0] = 0;
 		}
 
+		///////// FIND_FILE_FLAG_PARALLEL_STAT mode: names are read by batches and then
+		// stat-ed by pool of threads, while results returned in same order as readdir gave them
+
+		// how many names read from directory at once
+		static constexpr size_t BATCH_SIZE = 0x400;
+
+		// dont bother threads for small batches
+		static constexpr size_t BATCH_PARALLEL_THRESHOLD = 0x40;
+
+		struct BatchedEntry
+		{
+			std::string name;
+			mode_t hint_mode_type;
+			int err;
+			Statocaster st;
+		};
+
+		std::vector<BatchedEntry> _batch;
+		size_t _batch_size = 0, _batch_pos = 0;
+		std::unique_ptr<WorkStealingPool> _pool;
+
+		bool IterateBatched(LPWIN32_FIND_DATAW lpFindFileData)
+		{
+			for (;;) {
+				if (_batch_pos == _batch_size && !FetchBatch()) {
+					return false;
+				}
+
+				const auto &be = _batch[_batch_pos++];
+				if (MatchAttributesAndFillWFD(be.name.c_str(), be.st, be.err, lpFindFileData, be.hint_mode_type)) {
+					return true;
+				}
+			}
+		}
+
+		void BatchedStat(size_t begin, size_t end)
+		{
+			std::string path;
+			for (size_t i = begin; i != end; ++i) {
+				auto &be = _batch[i];
+				MakePath(path, be.name.c_str());
+				be.st.Query(path.c_str(), be.name.c_str());
+				be.err = (be.st.Attributes() == INVALID_FILE_ATTRIBUTES) ? errno : 0;
+			}
+		}
+
+		bool FetchBatch()
+		{
+			_batch_size = _batch_pos = 0;
+			while (_d && _batch_size < BATCH_SIZE) {
+				errno = 0;
+				struct dirent *de = os_call_pv<struct dirent>(sdc_readdir, _d);
+				if (!de)
+					break;
+
+				mode_t hint_mode_type = 0;
+#ifndef __HAIKU__
+				if (!PreMatchDType(de->d_type))
+					continue;
+				hint_mode_type = DTypeToModeType(de->d_type);
+#endif
+				if (!MatchName(de->d_name))
+					continue;
+
+				if (_batch.size() == _batch_size) {
+					_batch.emplace_back();
+				}
+				auto &be = _batch[_batch_size++];
+				be.name = de->d_name;
+				be.hint_mode_type = hint_mode_type;
+			}
+
+			if (_batch_size == 0) {
+				return false;
+			}
+
+			if (_batch_size < BATCH_PARALLEL_THRESHOLD) {
+				BatchedStat(0, _batch_size);
+
+			} else {
+				if (!_pool) {
+					// stat-ing is mostly IO-bound, especially on network filesystems,
+					// so use more threads than CPU-s count to keep more requests in flight
+					_pool.reset(new WorkStealingPool(std::max(4u, 2 * BestThreadsCount())));
+				}
+				const size_t portion = std::max(BATCH_PARALLEL_THRESHOLD / 4,
+					_batch_size / (2 * _pool->ThreadsCount()));
+				for (size_t begin = 0; begin < _batch_size; begin+= portion) {
+					const size_t end = std::min(_batch_size, begin + portion);
+					_pool->Queue([this, begin, end]() { BatchedStat(begin, end); });
+				}
+				_pool->Wait();
+			}
+
+			// pool threads are not inside of sudo client region, so they just fail on access denied
+			// errors, retry such entries from this thread letting sudo to do its job if its enabled
+			for (size_t i = 0; i != _batch_size; ++i) {
+				auto &be = _batch[i];
+				if (be.err == EACCES || be.err == EPERM) {
+					MakePath(_tmp.path, be.name.c_str());
+					SudoSilentQueryRegion ssqr(be.hint_mode_type != 0 && (_flags & FIND_FILE_FLAG_NOT_ANNOYING) != 0);
+					be.st.Query(_tmp.path.c_str(), be.name.c_str());
+					be.err = (be.st.Attributes() == INVALID_FILE_ATTRIBUTES) ? errno : 0;
+				}
+			}
+
+			return true;
+		}
+
+		/////////
+
+		void MakePath(std::string &path, const char *name)
+		{
+			path = _root;
+			if (path.empty() || path.back() != GOOD_SLASH)
+				path+= GOOD_SLASH;
+			path+= name;
+		}
+
 		bool MatchAttributesAndFillWFD(const char *name, LPWIN32_FIND_DATAW wfd, mode_t hint_mode_type = 0)
 		{
-			_tmp.path = _root;
-			if (_tmp.path.empty() || _tmp.path.back() != GOOD_SLASH)
-				_tmp.path+= GOOD_SLASH;
-			_tmp.path+= name;
+			MakePath(_tmp.path, name);
 
 			SudoSilentQueryRegion ssqr(hint_mode_type !=0 && (_flags & FIND_FILE_FLAG_NOT_ANNOYING) != 0);
-			if (!Statocaster(_tmp.path.c_str(), name).FillWFD(wfd)) {
-				fprintf(stderr, "UnixFindFile: errno=%u hmt=0%o on '%s'\n",
-					errno, hint_mode_type, _tmp.path.c_str());
+			Statocaster st(_tmp.path.c_str(), name);
+			return MatchAttributesAndFillWFD(name, st, errno, wfd, hint_mode_type);
+		}
+
+		bool MatchAttributesAndFillWFD(const char *name, const Statocaster &st, int err,
+			LPWIN32_FIND_DATAW wfd, mode_t hint_mode_type)
+		{
+			if (!st.FillWFD(wfd)) {
+				fprintf(stderr, "UnixFindFile: errno=%u hmt=0%o on '%s' in '%s'\n",
+					err, hint_mode_type, name, _root.c_str());
 				ZeroFillWFD(wfd);
 				wfd->dwFileAttributes = FILE_ATTRIBUTE_BROKEN | EvaluateAttributesT(hint_mode_type, name);
 			}
@@ -858,6 +984,20 @@ extern "C"
 
 			}
 		}
+
+		static mode_t DTypeToModeType(unsigned char d_type)
+		{
+			switch (d_type) {
+				case DT_DIR: return S_IFDIR;
+				case DT_REG: return S_IFREG;
+				case DT_LNK: return S_IFLNK;
+				case DT_BLK: return S_IFBLK;
+				case DT_FIFO: return S_IFIFO;
+				case DT_CHR: return S_IFCHR;
+				case DT_SOCK: return S_IFSOCK;
+				default: return 0;
+			}
+		}
 #endif
 
 		struct {
@@ -941,9 +1081,13 @@ extern "C"
 		if (hFindFile == (HANDLE)&g_unix_found_file_dummy)
 			return FALSE;
 		UnixFindFile *uff = (UnixFindFile *)hFindFile;
-		std::lock_guard<std::mutex> lock(g_unix_find_files);
-		if (g_unix_find_files.find(uff)==g_unix_find_files.end())
-			return FALSE;
+		{
+			// dont hold lock while iterating: that would serialize enumerations
+			// performed by different threads (like parallel ScanTree does)
+			std::lock_guard<std::mutex> lock(g_unix_find_files);
+			if (g_unix_find_files.find(uff)==g_unix_find_files.end())
+				return FALSE;
+		}
 
 		if (!uff->Iterate(lpFindFileData)) {
 			WINPORT(SetLastError)(ERROR_NO_MORE_FILES);
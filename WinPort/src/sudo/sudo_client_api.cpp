@@ -19,6 +19,9 @@
 # include <sys/xattr.h>
 #endif
 #include <map>
+#include <unordered_map>
+#include <deque>
+#include <vector>
 #include <mutex>
 #include <utimens_compat.h>
 #include "sudo_private.h"
@@ -106,6 +109,167 @@ static class Client2ServerDIR : protected Client2Server<DIR *, void *>
 
 } s_c2s_dir;
 
+// Directories opened via sudo are read by batches of entries together with their stat-s,
+// so enumeration that lstat-s each entry (like FindFile does) costs single IPC per batch.
+// Stat-s kept only while their directory is open and each served at most once.
+static class ClientDirBatches
+{
+	struct Batch
+	{
+		std::string path; // with trailing slash
+		std::vector<ReadDirStatEntry> entries;
+		size_t pos = 0;
+		int end = 0; // nonzero if nothing more to fetch: errno or -1 on end of directory
+	};
+
+	struct CachedStat
+	{
+		DIR *dir;
+		int lstat_err, stat_err;
+		struct stat lst, st;
+	};
+
+	enum { MAX_CACHED_STATS = 0x4000 };
+
+	std::map<DIR *, Batch> _batches;
+	std::unordered_map<std::string, CachedStat> _stats;
+	std::deque<std::string> _stats_order; // for eviction, may refer to already removed entries
+	std::mutex _mutex;
+
+	void CacheStats(DIR *dir, const Batch &b)
+	{
+		std::string path;
+		for (const auto &e : b.entries) {
+			if (strcmp(e.de.d_name, ".") == 0 || strcmp(e.de.d_name, "..") == 0)
+				continue;
+
+			path = b.path;
+			path+= e.de.d_name;
+			auto &cs = _stats[path];
+			cs.dir = dir;
+			cs.lstat_err = e.lstat_err;
+			cs.stat_err = e.stat_err;
+			memcpy(&cs.lst, &e.lst, sizeof(cs.lst));
+			memcpy(&cs.st, &e.st, sizeof(cs.st));
+			_stats_order.emplace_back(path);
+		}
+
+		while (_stats_order.size() > MAX_CACHED_STATS) {
+			_stats.erase(_stats_order.front());
+			_stats_order.pop_front();
+		}
+	}
+
+public:
+	void Open(DIR *dir, const char *path)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto &b = _batches[dir];
+		b.path = path;
+		if (b.path.empty() || b.path.back() != '/')
+			b.path+= '/';
+	}
+
+	void Close(DIR *dir)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_batches.erase(dir);
+		for (auto it = _stats.begin(); it != _stats.end();) {
+			if (it->second.dir == dir) {
+				it = _stats.erase(it);
+			} else {
+				++it;
+			}
+		}
+		if (_stats.empty())
+			_stats_order.clear();
+	}
+
+	// returns zero if de filled by next entry, otherwise errno or -1 on end of directory
+	int Next(DIR *dir, void *remote_dir, struct dirent &de)
+	{
+		for (;;) {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				auto &b = _batches[dir];
+				if (b.pos < b.entries.size()) {
+					memcpy(&de, &b.entries[b.pos].de, sizeof(de));
+					++b.pos;
+					return 0;
+				}
+				if (b.end != 0)
+					return b.end;
+			}
+
+			// fetch next batch without holding lock, so concurrent stat-s of previous ones not blocked
+			std::vector<ReadDirStatEntry> entries;
+			int end;
+			{
+				ClientTransaction ct(SUDO_CMD_READDIR_STAT);
+				ct.SendPOD(remote_dir);
+				ct.SendPOD((unsigned int)READDIR_STAT_BATCH);
+				ct.SendErrno();
+				unsigned int count = 0;
+				ct.RecvPOD(count);
+				if (count > READDIR_STAT_BATCH)
+					throw std::runtime_error("too many entries");
+				entries.resize(count);
+				if (count)
+					ct.RecvBuf(entries.data(), count * sizeof(ReadDirStatEntry));
+				end = ct.RecvInt();
+			}
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto &b = _batches[dir];
+			b.entries.swap(entries);
+			b.pos = 0;
+			b.end = (end != 0 || b.entries.empty()) ? (end ? end : -1) : 0;
+			CacheStats(dir, b);
+		}
+	}
+
+	// returns false if path not cached, otherwise err is zero and buf filled or err is errno
+	bool LookupLStat(const char *path, struct stat *buf, int &err)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_stats.empty())
+			return false;
+
+		auto it = _stats.find(path);
+		if (it == _stats.end())
+			return false;
+
+		err = it->second.lstat_err;
+		if (err == 0)
+			memcpy(buf, &it->second.lst, sizeof(*buf));
+
+		// symlink's stat typically queried next
+		if (err != 0 || (it->second.lst.st_mode & S_IFMT) != S_IFLNK)
+			_stats.erase(it);
+
+		return true;
+	}
+
+	bool LookupStat(const char *path, struct stat *buf, int &err)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_stats.empty())
+			return false;
+
+		auto it = _stats.find(path);
+		if (it == _stats.end())
+			return false;
+
+		err = it->second.stat_err;
+		if (err == 0)
+			memcpy(buf, &it->second.st, sizeof(*buf));
+
+		_stats.erase(it);
+		return true;
+	}
+
+} s_dir_batches;
+
 ////////////////////////////////////////////
 
 
@@ -308,9 +472,15 @@ extern "C" __attribute__ ((visibility("default"))) int sdc_stat(const char *path
 	ClientReconstructCurDir crcd(path);
 	int r = stat(path, buf);
 	if (r==-1 && IsAccessDeniedErrno() && TouchClientConnection(false)) {
-		r = common_stat(SUDO_CMD_STAT, path, buf);
-		if (r==0)
-			errno = saved_errno;
+		int err;
+		if (s_dir_batches.LookupStat(path, buf, err)) {
+			r = err ? -1 : 0;
+			errno = err ? err : saved_errno;
+		} else {
+			r = common_stat(SUDO_CMD_STAT, path, buf);
+			if (r==0)
+				errno = saved_errno;
+		}
 	}
 
 	return r;
@@ -322,9 +492,15 @@ extern "C" __attribute__ ((visibility("default"))) int sdc_lstat(const char *pat
 	ClientReconstructCurDir crcd(path);
 	int r = lstat(path, buf);
 	if (r==-1 && IsAccessDeniedErrno() && TouchClientConnection(false)) {
-		r = common_stat(SUDO_CMD_LSTAT, path, buf);
-		if (r==0)
-			errno = saved_errno;
+		int err;
+		if (s_dir_batches.LookupLStat(path, buf, err)) {
+			r = err ? -1 : 0;
+			errno = err ? err : saved_errno;
+		} else {
+			r = common_stat(SUDO_CMD_LSTAT, path, buf);
+			if (r==0)
+				errno = saved_errno;
+		}
 	}
 	return r;
 }
@@ -374,6 +550,7 @@ extern "C" __attribute__ ((visibility("default"))) DIR *sdc_opendir(const char *
 			if (remote) {
 				dir = s_c2s_dir.Register(remote);
 				if (dir) {
+					s_dir_batches.Open(dir, path);
 					errno = saved_errno;
 				} else {
 					ct.NewTransaction(SUDO_CMD_CLOSEDIR);
@@ -393,6 +570,9 @@ extern "C" __attribute__ ((visibility("default"))) DIR *sdc_opendir(const char *
 
 extern "C" __attribute__ ((visibility("default"))) int sdc_closedir(DIR *dir)
 {
+	// forget batched entries before dir pointer becomes invalid, its cheap for local dirs
+	s_dir_batches.Close(dir);
+
 	void *remote_dir = s_c2s_dir.Deregister(dir);
 	if (!remote_dir) {
 		return closedir(dir);
@@ -403,7 +583,7 @@ extern "C" __attribute__ ((visibility("default"))) int sdc_closedir(DIR *dir)
 		ct.SendPOD(remote_dir);
 		return ct.RecvInt();
 	} catch(std::exception &e) {
-		fprintf(stderr, "sudo_client: closedir(%p -> %p) - error %s\n", dir, remote_dir, e.what());
+		fprintf(stderr, "sudo_client: closedir(-> %p) - error %s\n", remote_dir, e.what());
 		return 0;
 	}
 }
@@ -418,15 +598,11 @@ extern "C" __attribute__ ((visibility("default"))) struct dirent *sdc_readdir(DI
 		return readdir(dir);
 
 	try {
-		ClientTransaction ct(SUDO_CMD_READDIR);
-		ct.SendPOD(remote_dir);
-		ct.SendErrno();
-		int err = ct.RecvInt();
-		if (err==0) {
-			ct.RecvPOD(sudo_client_dirent);
+		int err = s_dir_batches.Next(dir, remote_dir, sudo_client_dirent);
+		if (err==0)
 			return &sudo_client_dirent;
-		} else
-			errno = err;
+
+		errno = err;
 	} catch(std::exception &e) {
 		fprintf(stderr, "sudo_client: readdir(%p -> %p) - error %s\n", dir, remote_dir, e.what());
 	}
@@ -22,6 +22,7 @@
 # include <sys/xattr.h>
 #endif
 #include <stdexcept>
+#include <algorithm>
 #include <set>
 #include <vector>
 #include <mutex>
@@ -151,6 +152,50 @@ namespace Sudo
 		}
 	}
 	
+	static void OnSudoDispatch_ReadDirStat(BaseTransaction &bt)
+	{
+		DIR *d;
+		unsigned int limit;
+		bt.RecvPOD(d);
+		bt.RecvPOD(limit);
+		bt.RecvErrno();
+
+		std::vector<ReadDirStatEntry> entries;
+		int end = 0;
+		if (!g_dirs.Check(d)) {
+			end = EBADF;
+		}
+		while (end == 0 && entries.size() < std::min(limit, (unsigned int)READDIR_STAT_BATCH)) {
+			errno = 0;	// fstatat of previous entry could leave it set
+			struct dirent *de = readdir(d);
+			if (!de) {
+				end = errno ? errno : -1;
+				break;
+			}
+			entries.emplace_back();
+			auto &e = entries.back();
+			memcpy(&e.de, de, sizeof(e.de));
+			e.lstat_err = e.stat_err = 0;
+			if (fstatat(dirfd(d), de->d_name, &e.lst, AT_SYMLINK_NOFOLLOW) == -1) {
+				e.lstat_err = e.stat_err = errno ? errno : -1;
+
+			} else if ((e.lst.st_mode & S_IFMT) == S_IFLNK) {
+				if (fstatat(dirfd(d), de->d_name, &e.st, 0) == -1) {
+					e.stat_err = errno ? errno : -1;
+				}
+
+			} else {
+				memcpy(&e.st, &e.lst, sizeof(e.st));
+			}
+		}
+
+		bt.SendPOD((unsigned int)entries.size());
+		if (!entries.empty()) {
+			bt.SendBuf(entries.data(), entries.size() * sizeof(ReadDirStatEntry));
+		}
+		bt.SendInt(end);
+	}
+
 	static void OnSudoDispatch_MkDir(BaseTransaction &bt)
 	{
 		std::string path;
@@ -449,6 +494,10 @@ namespace Sudo
 			case SUDO_CMD_FCHMOD:
 				OnSudoDispatch_FChMod(bt);
 				break;
+
+			case SUDO_CMD_READDIR_STAT:
+				OnSudoDispatch_ReadDirStat(bt);
+				break;
 				
 			default:
 				throw std::runtime_error("OnSudoDispatch - bad command");
@@ -3,6 +3,8 @@
 #include <mutex>
 #include <utils.h>
 #include <limits.h>
+#include <dirent.h>
+#include <sys/stat.h>
 #include <LocalSocket.h>
 
 namespace Sudo
@@ -38,8 +40,22 @@ namespace Sudo
 		SUDO_CMD_FSFLAGSGET,
 		SUDO_CMD_FSFLAGSSET,
 		SUDO_CMD_FCHMOD,
+		SUDO_CMD_READDIR_STAT,
 	};
 
+	// SUDO_CMD_READDIR_STAT replies with array of such entries followed by end-of-directory status
+	struct ReadDirStatEntry
+	{
+		struct dirent de;
+		int lstat_err; // zero if lst valid
+		int stat_err; // zero if st valid, for non-symlinks st is same as lst
+		struct stat lst;
+		struct stat st;
+	};
+
+	// max count of entries in single SUDO_CMD_READDIR_STAT reply
+	enum { READDIR_STAT_BATCH = 0x100 };
+
 	class BaseTransaction
 	{
 		LocalSocket &_sock;
@@ -16,8 +16,9 @@ public:
       @param type If 0 - filename RE, if 1 - firstline RE
       @param prior Priority of this rule
       @param re Associated regular expression
+      @param source Source text of regular expression
   */
-  FileTypeChooser(ChooserType type, double prior, CRegExp* re);
+  FileTypeChooser(ChooserType type, double prior, CRegExp* re, const String* source);
   /** Default destructor */
   ~FileTypeChooser() {};
   /** Returns type of chooser */
@@ -28,14 +29,17 @@ public:
   double getPriority() const;
   /** Returns associated regular expression */
   CRegExp* getRE() const;
+  /** Returns source text of associated regular expression */
+  const String* getSource() const;
 private:
   std::unique_ptr<CRegExp> reg_matcher;
+  SString reg_source;
   ChooserType type;
   double priority;
 };
 
-inline FileTypeChooser::FileTypeChooser(ChooserType type_, double prior, CRegExp* re):
-  reg_matcher(re), type(type_), priority(prior)
+inline FileTypeChooser::FileTypeChooser(ChooserType type_, double prior, CRegExp* re, const String* source):
+  reg_matcher(re), reg_source(source), type(type_), priority(prior)
 {
 }
 
@@ -59,6 +63,11 @@ inline CRegExp* FileTypeChooser::getRE() const
   return reg_matcher.get();
 }
 
+inline const String* FileTypeChooser::getSource() const
+{
+  return &reg_source;
+}
+
 #endif //_COLORER_FILETYPECHOOSER_H_
 
 
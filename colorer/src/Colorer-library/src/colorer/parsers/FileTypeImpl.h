@@ -31,6 +31,7 @@ public:
 class FileTypeImpl : public FileType
 {
   friend class HRCParserImpl;
+  friend class HRCCatalogCache;
   friend class TextParserImpl;
 public:
   const String *getName() const;
@@ -0,0 +1,435 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <colorer/parsers/HRCCatalogCache.h>
+#include <colorer/parsers/HRCParserImpl.h>
+#include <colorer/xml/XmlInputSource.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define COLORER_HRC_CACHE 1
+#endif
+
+#if COLORER_HRC_CACHE
+
+// file starts with magic and format version, then goes catalog path, hrc locations and
+// dependencies with their stats that all must match current ones, then version and types
+#define HRC_CACHE_MAGIC 0x43524843
+#define HRC_CACHE_VERSION 1
+
+namespace
+{
+struct FileStat
+{
+  int64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  int64_t ino;
+};
+
+bool getFileStat(const String* path, FileStat &fs)
+{
+  struct stat st;
+  if (stat(path->getChars(), &st) == -1) {
+    return false;
+  }
+  memset(&fs, 0, sizeof(fs));
+  fs.size = st.st_size;
+  fs.mtime_sec = st.st_mtime;
+#if defined(__APPLE__)
+  fs.mtime_nsec = st.st_mtimespec.tv_nsec;
+#else
+  fs.mtime_nsec = st.st_mtim.tv_nsec;
+#endif
+  fs.ino = st.st_ino;
+  return true;
+}
+
+class CacheWriter
+{
+public:
+  std::vector<char> data;
+
+  void putRaw(const void* ptr, size_t len)
+  {
+    data.insert(data.end(), (const char*)ptr, (const char*)ptr + len);
+  }
+
+  void putU32(uint32_t v)
+  {
+    putRaw(&v, sizeof(v));
+  }
+
+  void putDouble(double v)
+  {
+    putRaw(&v, sizeof(v));
+  }
+
+  // null strings written with length 0xffffffff
+  void putString(const String* s)
+  {
+    if (s == nullptr) {
+      putU32(0xffffffff);
+      return;
+    }
+    putU32((uint32_t)s->length());
+    for (size_t i = 0; i < s->length(); i++) {
+      putU32((uint32_t)(*s)[i]);
+    }
+  }
+};
+
+class CacheReader
+{
+public:
+  CacheReader(const char* data, size_t len): cur(data), end(data + len) {}
+
+  bool getRaw(void* ptr, size_t len)
+  {
+    if ((size_t)(end - cur) < len) {
+      return false;
+    }
+    memcpy(ptr, cur, len);
+    cur += len;
+    return true;
+  }
+
+  bool getU32(uint32_t &v)
+  {
+    return getRaw(&v, sizeof(v));
+  }
+
+  bool getDouble(double &v)
+  {
+    return getRaw(&v, sizeof(v));
+  }
+
+  bool getString(UString &s)
+  {
+    uint32_t len;
+    if (!getU32(len)) {
+      return false;
+    }
+    if (len == 0xffffffff) {
+      s.reset();
+      return true;
+    }
+    if ((size_t)(end - cur) / sizeof(uint32_t) < len) {
+      return false;
+    }
+    std::vector<w4char> chars(len);
+    for (auto &ch : chars) {
+      uint32_t v;
+      getU32(v);
+      ch = (w4char)v;
+    }
+    s.reset(new SString(chars.data(), 0, len));
+    return true;
+  }
+
+  bool matchString(const String* s)
+  {
+    UString cached;
+    return getString(cached) && cached && cached->equals(s);
+  }
+
+  bool atEnd() const
+  {
+    return cur == end;
+  }
+
+private:
+  const char* cur;
+  const char* end;
+};
+
+}
+
+HRCCatalogCache::HRCCatalogCache(const String* cache_path_, const String* catalog_path_, const std::vector<SString> &hrc_locations_):
+  cache_path(cache_path_), catalog_path(catalog_path_), hrc_locations(hrc_locations_), recording_parser(nullptr)
+{
+}
+
+HRCCatalogCache::~HRCCatalogCache()
+{
+  if (recording_parser) {
+    recording_parser->loaded_sources = nullptr;
+  }
+}
+
+bool HRCCatalogCache::load(HRCParserImpl* hrc_parser)
+{
+  int fd = open(cache_path.getChars(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat st;
+  void* mapped = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+
+  CacheReader reader((const char*)mapped, (size_t)st.st_size);
+  std::vector<FileTypeImpl*> types;
+  UString version;
+  bool ok = false;
+
+  do {
+    uint32_t magic, format, count;
+    if (!reader.getU32(magic) || magic != HRC_CACHE_MAGIC || !reader.getU32(format) || format != HRC_CACHE_VERSION) {
+      break;
+    }
+
+    if (!reader.matchString(&catalog_path) || !reader.getU32(count) || count != hrc_locations.size()) {
+      break;
+    }
+    bool matched = true;
+    for (const auto &location : hrc_locations) {
+      if (!reader.matchString(&location)) {
+        matched = false;
+        break;
+      }
+    }
+
+    // any changed or missing dependency makes cache outdated
+    if (!matched || !reader.getU32(count)) {
+      break;
+    }
+    for (uint32_t i = 0; matched && i < count; i++) {
+      UString path;
+      FileStat cached_fs, fs;
+      matched = reader.getString(path) && path && reader.getRaw(&cached_fs, sizeof(cached_fs))
+                && getFileStat(path.get(), fs) && memcmp(&fs, &cached_fs, sizeof(fs)) == 0;
+    }
+
+    if (!matched || !reader.getString(version) || !reader.getU32(count)) {
+      break;
+    }
+    for (uint32_t i = 0; matched && i < count; i++) {
+      auto* type = new FileTypeImpl(hrc_parser);
+      types.push_back(type);
+      UString location;
+      uint32_t is_package, choosers, params;
+      matched = reader.getString(type->name) && type->name && reader.getString(type->group)
+                && reader.getString(type->description) && reader.getU32(is_package) && reader.getString(location);
+      if (!matched) {
+        break;
+      }
+      type->isPackage = (is_package != 0);
+      if (location) {
+        type->inputSource = XmlInputSource::newInstance(location->getW2Chars(), static_cast<XMLCh*>(nullptr));
+      }
+
+      matched = reader.getU32(choosers);
+      for (uint32_t j = 0; matched && j < choosers; j++) {
+        uint32_t ctype;
+        double prior;
+        UString re_source;
+        matched = reader.getU32(ctype) && reader.getDouble(prior) && reader.getString(re_source) && re_source;
+        if (matched) {
+          std::unique_ptr<CRegExp> matchRE(new CRegExp(re_source.get()));
+          matchRE->setPositionMoves(true);
+          matched = matchRE->isOk();
+          if (matched) {
+            type->chooserVector.emplace_back(new FileTypeChooser(ctype ? FileTypeChooser::ChooserType::CT_FIRSTLINE
+                                                                  : FileTypeChooser::ChooserType::CT_FILENAME,
+                                                                  prior, matchRE.release(), re_source.get()));
+          }
+        }
+      }
+
+      matched = matched && reader.getU32(params);
+      for (uint32_t j = 0; matched && j < params; j++) {
+        UString name, value, descr;
+        matched = reader.getString(name) && name && reader.getString(value) && value && reader.getString(descr);
+        if (matched) {
+          TypeParameter* tp = type->addParam(name.get());
+          tp->default_value = std::move(value);
+          tp->description = std::move(descr);
+        }
+      }
+
+      type->protoLoaded = true;
+    }
+
+    ok = matched && reader.atEnd();
+  } while (false);
+
+  munmap(mapped, (size_t)st.st_size);
+
+  if (!ok) {
+    for (auto type : types) {
+      delete type;
+    }
+    logger->debug("hrc cache '{0}' is missing or outdated", cache_path.getChars());
+    return false;
+  }
+
+  for (auto ft : types) {
+    std::pair<SString, FileTypeImpl*> pp(ft->getName(), ft);
+    hrc_parser->fileTypeHash.emplace(pp);
+    if (!ft->isPackage) {
+      hrc_parser->fileTypeVector.push_back(ft);
+    }
+  }
+  if (version && hrc_parser->versionName == nullptr) {
+    hrc_parser->versionName = version.release();
+  }
+  hrc_parser->structureChanged = true;
+  logger->debug("{0} hrc prototypes loaded from cache '{1}'", types.size(), cache_path.getChars());
+  return true;
+}
+
+void HRCCatalogCache::startRecording(HRCParserImpl* hrc_parser)
+{
+  dependencies.clear();
+  recording_parser = hrc_parser;
+  recording_parser->loaded_sources = &dependencies;
+}
+
+void HRCCatalogCache::addDependency(const String* path)
+{
+  dependencies.emplace_back(path);
+}
+
+void HRCCatalogCache::save(HRCParserImpl* hrc_parser)
+{
+  if (recording_parser) {
+    recording_parser->loaded_sources = nullptr;
+    recording_parser = nullptr;
+  }
+
+  // only plain prototypes are cached, not types or anything else
+  if (dependencies.empty() || !hrc_parser->schemeHash.empty() || !hrc_parser->regionNamesVector.empty()
+      || !hrc_parser->schemeEntitiesHash.empty()) {
+    return;
+  }
+
+  CacheWriter writer;
+  writer.putU32(HRC_CACHE_MAGIC);
+  writer.putU32(HRC_CACHE_VERSION);
+  writer.putString(&catalog_path);
+  writer.putU32((uint32_t)hrc_locations.size());
+  for (const auto &location : hrc_locations) {
+    writer.putString(&location);
+  }
+
+  writer.putU32((uint32_t)dependencies.size());
+  for (const auto &path : dependencies) {
+    FileStat fs;
+    if (!getFileStat(&path, fs)) {
+      logger->debug("hrc cache not saved: can't stat '{0}'", path.getChars());
+      return;
+    }
+    writer.putString(&path);
+    writer.putRaw(&fs, sizeof(fs));
+  }
+
+  writer.putString(hrc_parser->versionName);
+
+  // types keep their order as it matters for choosing, packages go after them
+  std::vector<FileTypeImpl*> types(hrc_parser->fileTypeVector);
+  for (const auto &it : hrc_parser->fileTypeHash) {
+    if (it.second->isPackage) {
+      types.push_back(it.second);
+    }
+  }
+
+  writer.putU32((uint32_t)types.size());
+  for (auto type : types) {
+    if (type->type_loaded || type->load_broken) {
+      return;
+    }
+
+    UString location;
+    if (type->inputSource) {
+      location.reset(new SString(CString(type->inputSource->getInputSource()->getSystemId())));
+      if (location->startsWith(CString("jar:"))) {
+        return;
+      }
+    }
+
+    writer.putString(type->name.get());
+    writer.putString(type->group.get());
+    writer.putString(type->description.get());
+    writer.putU32(type->isPackage ? 1 : 0);
+    writer.putString(location.get());
+
+    writer.putU32((uint32_t)type->chooserVector.size());
+    for (const auto &ftc : type->chooserVector) {
+      writer.putU32(ftc->isFileContent() ? 1 : 0);
+      writer.putDouble(ftc->getPriority());
+      writer.putString(ftc->getSource());
+    }
+
+    writer.putU32((uint32_t)type->paramsHash.size());
+    for (const auto &it : type->paramsHash) {
+      writer.putString(&it.first);
+      writer.putString(it.second->default_value.get());
+      writer.putString(it.second->description.get());
+    }
+  }
+
+  // write aside and rename, so concurrent loaders never see partial cache
+  SString tmp_path(cache_path);
+  tmp_path.append(CString(".")).append(SString((int)getpid()));
+  int fd = open(tmp_path.getChars(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd == -1) {
+    logger->debug("hrc cache not saved: can't create '{0}'", tmp_path.getChars());
+    return;
+  }
+
+  size_t written = 0;
+  while (written < writer.data.size()) {
+    ssize_t r = write(fd, writer.data.data() + written, writer.data.size() - written);
+    if (r <= 0) {
+      break;
+    }
+    written += (size_t)r;
+  }
+  close(fd);
+
+  if (written != writer.data.size() || rename(tmp_path.getChars(), cache_path.getChars()) == -1) {
+    unlink(tmp_path.getChars());
+    logger->debug("hrc cache not saved: can't write '{0}'", cache_path.getChars());
+    return;
+  }
+  logger->debug("{0} hrc prototypes saved to cache '{1}'", types.size(), cache_path.getChars());
+}
+
+#else // COLORER_HRC_CACHE
+
+HRCCatalogCache::HRCCatalogCache(const String* cache_path_, const String* catalog_path_, const std::vector<SString> &hrc_locations_):
+  cache_path(cache_path_), catalog_path(catalog_path_), hrc_locations(hrc_locations_), recording_parser(nullptr)
+{
+}
+
+HRCCatalogCache::~HRCCatalogCache()
+{
+}
+
+bool HRCCatalogCache::load(HRCParserImpl* hrc_parser)
+{
+  return false;
+}
+
+void HRCCatalogCache::startRecording(HRCParserImpl* hrc_parser)
+{
+}
+
+void HRCCatalogCache::addDependency(const String* path)
+{
+}
+
+void HRCCatalogCache::save(HRCParserImpl* hrc_parser)
+{
+}
+
+#endif // COLORER_HRC_CACHE
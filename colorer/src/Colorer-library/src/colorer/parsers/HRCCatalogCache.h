@@ -0,0 +1,52 @@
+#ifndef _COLORER_HRCCATALOGCACHE_H_
+#define _COLORER_HRCCATALOGCACHE_H_
+
+#include <vector>
+#include <colorer/Common.h>
+
+class HRCParserImpl;
+
+/** Binary cache of file type prototypes loaded from catalog's hrc locations.
+    Keeps types and packages with their choosers and parameters, so startup and
+    file type detection don't need to parse proto.hrc with all its entities.
+    Schemes of types are still loaded from hrc files when type is used.
+    Cache is valid while catalog has same hrc locations and all files it was
+    built from keep their sizes and modification times.
+    @ingroup colorer_parsers
+*/
+class HRCCatalogCache
+{
+public:
+  HRCCatalogCache(const String* cache_path, const String* catalog_path, const std::vector<SString> &hrc_locations);
+  ~HRCCatalogCache();
+
+  /** Fills hrc_parser with prototypes from cache, returns false if there is no valid cache.
+  */
+  bool load(HRCParserImpl* hrc_parser);
+
+  /** Starts recording of hrc files and entities parsed by hrc_parser, so they
+      become dependencies of cache written by save().
+  */
+  void startRecording(HRCParserImpl* hrc_parser);
+
+  /** Adds file or directory, that affects loaded prototypes, to dependencies.
+  */
+  void addDependency(const String* path);
+
+  /** Stops recording and writes prototypes of hrc_parser to cache, if they all came from
+      local files and no types were loaded yet.
+  */
+  void save(HRCParserImpl* hrc_parser);
+
+private:
+  SString cache_path;
+  SString catalog_path;
+  std::vector<SString> hrc_locations;
+  std::vector<SString> dependencies;
+  HRCParserImpl* recording_parser;
+
+  HRCCatalogCache(const HRCCatalogCache &) = delete;
+  void operator=(const HRCCatalogCache &) = delete;
+};
+
+#endif //_COLORER_HRCCATALOGCACHE_H_
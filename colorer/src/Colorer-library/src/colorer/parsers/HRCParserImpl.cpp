@@ -14,7 +14,7 @@
 
 HRCParserImpl::HRCParserImpl():
   versionName(nullptr), parseProtoType(nullptr), parseType(nullptr), current_input_source(nullptr),
-  structureChanged(false), updateStarted(false)
+  structureChanged(false), updateStarted(false), loaded_sources(nullptr)
 {
   fileTypeHash.reserve(200);
   fileTypeVector.reserve(150);
@@ -200,6 +200,10 @@ void HRCParserImpl::parseHRC(XmlInputSource* is)
   xml_parser.setXMLEntityResolver(&resolver);
   xml_parser.setLoadExternalDTD(false);
   xml_parser.setSkipDTDValidation(true);
+  if (loaded_sources) {
+    loaded_sources->emplace_back(CString(is->getInputSource()->getSystemId()));
+    resolver.resolved_entities = loaded_sources;
+  }
   xml_parser.parse(*is->getInputSource());
   if (error_handler.getSawErrors()) {
     throw HRCParserException(SString("Error reading hrc file '") + CString(is->getInputSource()->getSystemId()) + "'");
@@ -367,7 +371,7 @@ void HRCParserImpl::addPrototypeDetectParam(const xercesc::DOMElement* elem)
   double prior = ctype ? 1 : 2;
   CString weight = CString(elem->getAttribute(hrcFilenameAttrWeight));
   UnicodeTools::getNumber(&weight, &prior);
-  auto* ftc = new FileTypeChooser(ctype, prior, matchRE);
+  auto* ftc = new FileTypeChooser(ctype, prior, matchRE, &dmatch);
   parseProtoType->chooserVector.emplace_back(ftc);
 }
 
@@ -37,6 +37,7 @@ public:
 
 protected:
   friend class FileTypeImpl;
+  friend class HRCCatalogCache;
 
   enum QualifyNameType { QNT_DEFINE, QNT_SCHEME, QNT_ENTITY };
 
@@ -59,6 +60,8 @@ protected:
   XmlInputSource* current_input_source;
   bool structureChanged;
   bool updateStarted;
+  // if set - receives paths of all parsed hrc files and their entities
+  std::vector<SString>* loaded_sources;
 
   void loadFileType(FileType* filetype);
   void unloadFileType(FileTypeImpl* filetype);
@@ -16,6 +16,7 @@
 #include <colorer/parsers/CatalogParser.h>
 #include <colorer/viewer/TextLinesStore.h>
 #include <colorer/parsers/HRCParserImpl.h>
+#include <colorer/parsers/HRCCatalogCache.h>
 #include <colorer/parsers/TextParserImpl.h>
 #include <colorer/parsers/ParserFactoryException.h>
 
@@ -155,12 +156,27 @@ void ParserFactory::loadCatalog(const String* catalog_path)
 
 
   parseCatalog(base_catalog_path);
+
+  auto* hrc_parser_impl = static_cast<HRCParserImpl*>(hrc_parser);
+  std::unique_ptr<HRCCatalogCache> hrc_cache;
+  if (hrc_cache_path.length() != 0) {
+    hrc_cache.reset(new HRCCatalogCache(&hrc_cache_path, &base_catalog_path, hrc_locations));
+    if (hrc_cache->load(hrc_parser_impl)) {
+      return;
+    }
+    hrc_cache->startRecording(hrc_parser_impl);
+  }
+
   logger->debug("begin load hrc files");
   for (const auto& location : hrc_locations) {
     try {
       logger->debug("try load '{0}'", location.getChars());
       auto clear_path = XmlInputSource::getClearPath(&base_catalog_path, &location);
       if (XmlInputSource::isDirectory(clear_path.get())) {
+        if (hrc_cache) {
+          // catches added or removed files
+          hrc_cache->addDependency(clear_path.get());
+        }
         std::vector<SString> paths;
         XmlInputSource::getFileFromDir(clear_path.get(), paths);
         for (const auto& files : paths) {
@@ -175,6 +191,15 @@ void ParserFactory::loadCatalog(const String* catalog_path)
   }
 
   logger->debug("end load hrc files");
+
+  if (hrc_cache) {
+    hrc_cache->save(hrc_parser_impl);
+  }
+}
+
+void ParserFactory::setHrcCache(const String* cache_path)
+{
+  hrc_cache_path = SString(cache_path);
 }
 
 void ParserFactory::loadHrc(const String* hrc_path, const String* base_path) const
@@ -100,6 +100,12 @@ public:
   * @throw ParserFactoryException If can't load specified catalog.
   */
   void loadCatalog(const String* catalog_path);
+
+  /**
+  * Enables binary cache of HRC prototypes, must be called before loadCatalog().
+  * @param cache_path Path to cache file, it's created or rewritten when outdated.
+  */
+  void setHrcCache(const String* cache_path);
   void addHrd(std::unique_ptr<HRDNode> hrd);
 private:
 
@@ -111,6 +117,7 @@ private:
   void loadHrc(const String* hrc_path, const String* base_path) const;
 
   SString base_catalog_path;
+  SString hrc_cache_path;
   std::vector<SString> hrc_locations;
   std::unordered_map<SString, std::unique_ptr<std::vector<std::unique_ptr<HRDNode>>>> hrd_nodes;
 
@@ -4,6 +4,14 @@
 
 xercesc::InputSource* BaseEntityResolver::resolveEntity(xercesc::XMLResourceIdentifier* resourceIdentifier)
 {
+  if (resolved_entities != nullptr) {
+    try {
+      auto input_source = XmlInputSource::newInstance(resourceIdentifier->getSystemId(), resourceIdentifier->getBaseURI());
+      resolved_entities->emplace_back(CString(input_source->getInputSource()->getSystemId()));
+    } catch (Exception &) {
+      // parser reports it by itself
+    }
+  }
   if (xercesc::XMLString::startsWith(resourceIdentifier->getBaseURI(), kJar) ||
       xercesc::XMLString::findAny(resourceIdentifier->getSystemId(), kPercent)) {
     auto input_source = XmlInputSource::newInstance(resourceIdentifier->getSystemId(), resourceIdentifier->getBaseURI());
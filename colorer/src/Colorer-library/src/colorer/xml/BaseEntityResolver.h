@@ -1,6 +1,7 @@
 #ifndef _COLORER_BASE_ENTITY_RESOLVER_H_
 #define _COLORER_BASE_ENTITY_RESOLVER_H_
 
+#include <vector>
 #include <xercesc/util/XMLEntityResolver.hpp>
 #include <colorer/xml/XmlInputSource.h>
 
@@ -10,6 +11,9 @@ public:
     BaseEntityResolver(){};
     ~BaseEntityResolver() {};
     xercesc::InputSource* resolveEntity(xercesc::XMLResourceIdentifier* resourceIdentifier);
+
+    // if set - receives system ids of all resolved entities
+    std::vector<SString>* resolved_entities = nullptr;
 };
 
 #endif
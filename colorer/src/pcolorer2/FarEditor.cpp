@@ -1,4 +1,6 @@
 #include <vector>
+#include <algorithm>
+#include <chrono>
 #include"FarEditor.h"
 
 const SString DShowCross("show-cross");
@@ -23,11 +25,21 @@ const SString DFavorite("favorite");
 const SString DFirstLines("firstlines");
 const SString DFirstLineBytes("firstlinebytes");
 
+// lines parsed by parser thread per slice, between slices parser can be used by main thread
+#define PARSER_SLICE_TIME 100
+// how long redraw waits for parser thread to parse visible text before drawing older results
+#define REDRAW_WAIT_MSEC 50
+// idle event time spent on copying lines for parser thread
+#define IDLE_FEED_MSEC 20
+
+std::mutex FarEditor::parseMutex;
+
 FarEditor::FarEditor(PluginStartupInfo *inf, ParserFactory *pf):
   info(inf),
   parserFactory(pf),
   baseEditor(new BaseEditor(parserFactory, this)),
   maxLineLength(0),
+  backParse(-1),
   fullBackground(true),
   drawCross(2),
   showVerticalCross(false),
@@ -45,8 +57,13 @@ FarEditor::FarEditor(PluginStartupInfo *inf, ParserFactory *pf):
   idleCount(0),
   prevLinePosition(0),
   blockTopPosition(-1),
-  ret_str(nullptr),
   ret_strNumber(-1),
+  parserStop(false),
+  parserLocked(false),
+  generation(0),
+  pendingModify(-1),
+  parsedLine(0),
+  request(),
   newfore(-1),
   newback(-1),
   rdBackground(nullptr),
@@ -66,6 +83,8 @@ FarEditor::FarEditor(PluginStartupInfo *inf, ParserFactory *pf):
 
 FarEditor::~FarEditor()
 {
+  stopParser();
+
   delete cursorRegion;
   cursorRegion = nullptr;
 
@@ -77,15 +96,16 @@ FarEditor::~FarEditor()
 
   delete baseEditor;
   baseEditor = nullptr;
-
-  delete ret_str;
-  ret_str = nullptr;
 }
 
 void FarEditor::endJob(size_t lno)
 {
-  delete ret_str;
-  ret_str = nullptr;
+  if (std::this_thread::get_id() == parserThread.get_id()){
+    parser_str.reset();
+  }
+  else{
+    ret_str.reset();
+  }
 }
 
 #if 0
@@ -93,43 +113,56 @@ String *FarEditor::getLine(int lno)
 #endif // if 0
 SString *FarEditor::getLine(size_t lno)
 {
-  if (ret_strNumber == lno && ret_str != nullptr){
-    return ret_str;
+  if (std::this_thread::get_id() == parserThread.get_id()){
+    // parser thread can't access FAR, lines not copied yet or dropped by
+    // modification are given empty - their regions will be reparsed anyway
+    std::lock_guard<std::mutex> lock(textMutex);
+    if (lno < textLines.size()){
+      parser_str = textLines[lno];
+    }
+    else{
+      parser_str.reset(new StringBuffer());
+    }
+    return parser_str.get();
   }
 
-  EditorGetString es;
-  int len = 0;
-  ret_strNumber = lno;
+  if (ret_strNumber == lno && ret_str){
+    return ret_str.get();
+  }
 
-  es.StringNumber = lno;
-  es.StringText = nullptr;
+  feedLines(lno + 1);
+  ret_strNumber = lno;
 
-  if (info->EditorControl(ECTL_GETSTRING, &es)){
-    len = es.StringLength;
+  std::lock_guard<std::mutex> lock(textMutex);
+  if (lno < textLines.size()){
+    ret_str = textLines[lno];
   }
-
-  if (len > maxLineLength && maxLineLength > 0){
-    len = maxLineLength;
+  else{
+    ret_str.reset(new StringBuffer());
   }
-
-  delete ret_str;
-  ret_str = new StringBuffer(es.StringText, 0, len);
-  return ret_str;
+  return ret_str.get();
 }
 
 void FarEditor::chooseFileType(String *fname)
 {
-  FileType *ftype = baseEditor->chooseFileType(fname);
+  FileType *ftype;
+  {
+    ParserLock lock(this);
+    ftype = baseEditor->chooseFileType(fname);
+  }
   setFileType(ftype);
 }
 
 void FarEditor::setFileType(FileType *ftype)
 {
+  ParserLock lock(this);
   baseEditor->setFileType(ftype);
   // clear Outliner
   structOutliner->modifyEvent(0);
   errorOutliner->modifyEvent(0);
   reloadTypeSettings();
+  // lines could be cut by other maxlinelength
+  textModified(0);
 }
 
 void FarEditor::reloadTypeSettings()
@@ -224,6 +257,7 @@ void FarEditor::reloadTypeSettings()
     crossZOrder = 1;
   }
 
+  backParse = backparse;
   baseEditor->setBackParse(backparse);
 }
 
@@ -244,10 +278,12 @@ void FarEditor::setDrawCross(int _drawCross)
     showHorizontalCross = true;
     showVerticalCross   = true;
     break;
-  case 2:
+  case 2:{
+    ParserLock lock(this);
     reloadTypeSettings();
     break;
   }
+  }
 }
 
 void FarEditor::setDrawPairs(bool drawPairs)
@@ -272,7 +308,13 @@ void FarEditor::setTrueMod(bool _TrueMod)
 
 void FarEditor::setRegionMapper(RegionMapper *rs)
 {
+  ParserLock lock(this);
   baseEditor->setRegionMapper(rs);
+  {
+    std::lock_guard<std::mutex> tlock(textMutex);
+    generation++;
+    parserCond.notify_one();
+  }
   rdBackground = StyledRegion::cast(baseEditor->rd_def_Text);
   horzCrossColor = convert(StyledRegion::cast(baseEditor->rd_def_HorzCross));
   vertCrossColor = convert(StyledRegion::cast(baseEditor->rd_def_VertCross));
@@ -286,6 +328,7 @@ void FarEditor::matchPair()
 {
   EditorSetPosition esp;
   enterHandler();
+  ParserLock lock(this);
   PairMatch *pm = baseEditor->searchGlobalPair(ei.CurLine, ei.CurPos);
 
   if ((pm == nullptr)||(pm->eline == -1)){
@@ -323,6 +366,7 @@ void FarEditor::selectPair()
   EditorSelect es;
   int X1, X2, Y1, Y2;
   enterHandler();
+  ParserLock lock(this);
   PairMatch *pm = baseEditor->searchGlobalPair(ei.CurLine, ei.CurPos);
 
   if ((pm == nullptr)||(pm->eline == -1)){
@@ -359,6 +403,7 @@ void FarEditor::selectBlock()
   EditorSelect es;
   int X1, X2, Y1, Y2;
   enterHandler();
+  ParserLock lock(this);
   PairMatch *pm = baseEditor->searchGlobalPair(ei.CurLine, ei.CurPos);
 
   if ((pm == nullptr)||(pm->eline == -1)){
@@ -417,12 +462,17 @@ void FarEditor::selectRegion()
 
 void FarEditor::listFunctions()
 {
+  enterHandler();
+  // outliner is filled by parser, so keep parser away till menu closed
+  ParserLock lock(this);
   baseEditor->validate(-1, false);
   showOutliner(structOutliner);
 }
 
 void FarEditor::listErrors()
 {
+  enterHandler();
+  ParserLock lock(this);
   baseEditor->validate(-1, false);
   showOutliner(errorOutliner);
 }
@@ -432,6 +482,7 @@ void FarEditor::locateFunction()
 {
   // extract word
   enterHandler();
+  ParserLock lock(this);
   String &curLine = *getLine(ei.CurLine);
   int cpos = ei.CurPos;
   int sword = cpos;
@@ -513,20 +564,30 @@ void FarEditor::locateFunction()
 void FarEditor::updateHighlighting()
 {
   enterHandler();
+  ParserLock lock(this);
   baseEditor->validate(ei.TopScreenLine, true);
+  std::lock_guard<std::mutex> tlock(textMutex);
+  generation++;
+  parserCond.notify_one();
 }
 
 int FarEditor::editorInput(const INPUT_RECORD *ir)
 {
   if (ir->EventType == KEY_EVENT && ir->Event.KeyEvent.wVirtualKeyCode == 0){
 
-    if (baseEditor->haveInvalidLine()){
-     
-      idleCount++;
-      if (idleCount > 10){
-        idleCount = 10;
-      }
-      baseEditor->idleJob(idleCount*idleCount*100);
+    idleCount++;
+    if (idleCount > 10){
+      idleCount = 10;
+    }
+    // parser thread goes further as more lines copied for it
+    feedLinesIdle(idleCount*IDLE_FEED_MSEC);
+
+    bool redraw;
+    {
+      std::lock_guard<std::mutex> lock(textMutex);
+      redraw = (published != drawnWindow);
+    }
+    if (redraw){
       info->EditorControl(ECTL_REDRAW, nullptr);
     }
   }
@@ -549,10 +610,6 @@ int FarEditor::editorEvent(int event, void *param)
   WindowSizeX = ei.WindowSizeX;
   WindowSizeY = ei.WindowSizeY;
 
-  baseEditor->visibleTextEvent(ei.TopScreenLine, WindowSizeY);
-
-  baseEditor->lineCountEvent(ei.TotalLines);
-
   if (param == EEREDRAW_CHANGE){
     int ml = (prevLinePosition < ei.CurLine ? prevLinePosition : ei.CurLine)-1;
 
@@ -564,7 +621,7 @@ int FarEditor::editorEvent(int event, void *param)
       ml = blockTopPosition;
     }
 
-    baseEditor->modifyEvent(ml);
+    textModified(ml);
   };
 
   prevLinePosition = ei.CurLine;
@@ -574,6 +631,43 @@ int FarEditor::editorEvent(int event, void *param)
     blockTopPosition = ei.BlockStartLine;
   }
 
+  startParser();
+
+  ParseRequest req;
+  req.topLine = ei.TopScreenLine;
+  req.lines = WindowSizeY;
+  req.totalLines = ei.TotalLines;
+  req.curLine = ei.CurLine;
+  req.curPos = ei.CurPos;
+  req.pairs = drawPairs;
+
+  // visible text copied right away, unless it's too far for backparse
+  // and would be reached by parser only after idle copying of lines above
+  const int visibleEnd = std::min(ei.TopScreenLine + WindowSizeY, ei.TotalLines);
+  if (backParse <= 0 || visibleEnd - (int)feedLines(0) <= backParse){
+    feedLines(visibleEnd);
+  }
+
+  // let parser thread handle new state and give it a moment to do so,
+  // if it's late - draw its older results now, redraw on idle when it's done
+  std::shared_ptr<ParsedWindow> window;
+  bool upToDate;
+  {
+    std::unique_lock<std::mutex> lock(textMutex);
+    request = req;
+    parserCond.notify_one();
+
+    auto isUpToDate = [&]() {
+      return published && published->generation == generation && published->request == req;
+    };
+    if (!parserLocked){
+      publishCond.wait_for(lock, std::chrono::milliseconds(REDRAW_WAIT_MSEC), isUpToDate);
+    }
+    upToDate = isUpToDate();
+    window = published;
+    drawnWindow = published;
+  }
+
   // hack against tabs in FAR's editor
   EditorConvertPos ecp {}, ecp_cl {};
   ecp.StringNumber = -1;
@@ -593,8 +687,8 @@ int FarEditor::editorEvent(int event, void *param)
 
     LineRegion *l1 = nullptr;
 
-    if (drawSyntax || drawPairs){
-      l1 = baseEditor->getLineRegions(lno);
+    if ((drawSyntax || drawPairs) && window){
+      l1 = window->getLineRegions(lno);
     }
     
     //clean line in far editor
@@ -723,8 +817,8 @@ int FarEditor::editorEvent(int event, void *param)
   /// pair brackets
   PairMatch *pm = nullptr;
 
-  if (drawPairs){
-    pm = baseEditor->searchLocalPair(ei.CurLine, ei.CurPos);
+  if (drawPairs && upToDate){
+    pm = window->pair;
   }
 
   if (pm != nullptr){
@@ -826,8 +920,6 @@ int FarEditor::editorEvent(int event, void *param)
       };
       //
     };
-
-    baseEditor->releasePairMatch(pm);
   };
 
   if (param != EEREDRAW_ALL){
@@ -840,6 +932,252 @@ int FarEditor::editorEvent(int event, void *param)
 }
 
 
+FarEditor::ParsedWindow::ParsedWindow(const ParseRequest &r, unsigned int g):
+  request(r),
+  generation(g),
+  complete(true),
+  lines(r.lines > 0 ? r.lines : 0, nullptr),
+  pair(nullptr)
+{
+}
+
+FarEditor::ParsedWindow::~ParsedWindow()
+{
+  for (LineRegion *lr : lines){
+    while (lr != nullptr){
+      LineRegion *next = lr->next;
+      delete lr;
+      lr = next;
+    }
+  }
+  delete pair;
+}
+
+LineRegion *FarEditor::ParsedWindow::getLineRegions(int lno) const
+{
+  if (lno < request.topLine || lno - request.topLine >= (int)lines.size()){
+    return nullptr;
+  }
+  return lines[lno - request.topLine];
+}
+
+FarEditor::ParserLock::ParserLock(FarEditor *editor):
+  editor(editor)
+{
+  FarEditor::parseMutex.lock();
+  editor->parserLocked = true;
+
+  std::lock_guard<std::mutex> lock(editor->textMutex);
+  editor->applyPendingModify();
+  // main thread may parse whole text as getLine() copies lines it needs
+  editor->baseEditor->lineCountEvent(editor->ei.TotalLines);
+}
+
+FarEditor::ParserLock::~ParserLock()
+{
+  editor->parserLocked = false;
+  FarEditor::parseMutex.unlock();
+}
+
+void FarEditor::startParser()
+{
+  if (!parserThread.joinable()){
+    // parser thread checks its id on getLine(), so let it start only after it's assigned
+    std::lock_guard<std::mutex> lock(textMutex);
+    parserThread = std::thread(&FarEditor::parserThreadProc, this);
+  }
+}
+
+void FarEditor::stopParser()
+{
+  if (parserThread.joinable()){
+    {
+      std::lock_guard<std::mutex> lock(textMutex);
+      parserStop = true;
+      parserCond.notify_one();
+    }
+    parserThread.join();
+  }
+}
+
+bool FarEditor::parserHasWork() const
+{
+  if (pendingModify != -1){
+    return true;
+  }
+
+  if (!published || published->generation != generation || !(published->request == request)){
+    return true;
+  }
+
+  return parsedLine < (int)textLines.size();
+}
+
+void FarEditor::parserThreadProc()
+{
+  std::unique_lock<std::mutex> lock(textMutex);
+  for (;;){
+    parserCond.wait(lock, [this]() { return parserStop || parserHasWork(); });
+    if (parserStop){
+      break;
+    }
+
+    const ParseRequest req = request;
+    const unsigned int gen = generation;
+    const int modify = pendingModify;
+    const int available = (int)textLines.size();
+    const int prevParsed = parsedLine;
+    const bool actual = published && published->generation == gen && published->request == req;
+    const bool incomplete = actual && !published->complete;
+    pendingModify = -1;
+    lock.unlock();
+
+    // visible text goes first, then text below it parsed in slices,
+    // so main thread actions wait for parser not longer than one slice
+    std::unique_ptr<ParsedWindow> window;
+    int parsed;
+    {
+      std::lock_guard<std::mutex> plock(parseMutex);
+      try{
+        if (modify != -1){
+          baseEditor->modifyEvent(modify);
+        }
+        baseEditor->lineCountEvent(available);
+        baseEditor->visibleTextEvent(req.topLine, req.lines);
+
+        if (actual){
+          baseEditor->idleJob(PARSER_SLICE_TIME);
+        }
+
+        if (!actual || incomplete){
+          window.reset(collectWindow(req, gen, available));
+        }
+        parsed = baseEditor->getInvalidLine();
+      }
+      catch (std::exception &e){
+        window.reset(new ParsedWindow(req, gen));
+        parsed = available;
+      }
+    }
+
+    lock.lock();
+    if (actual && parsed <= prevParsed){
+      // no way further with lines copied so far
+      parsed = available;
+    }
+    parsedLine = parsed;
+
+    if (window && gen == generation){
+      published = std::move(window);
+      publishCond.notify_all();
+    }
+  }
+}
+
+FarEditor::ParsedWindow *FarEditor::collectWindow(const ParseRequest &req, unsigned int gen, int available)
+{
+  std::unique_ptr<ParsedWindow> window(new ParsedWindow(req, gen));
+  const int visibleEnd = std::min(req.topLine + req.lines, req.totalLines);
+
+  for (int lno = req.topLine; lno < visibleEnd && lno < available; lno++){
+    LineRegion *last = nullptr;
+    for (LineRegion *l1 = baseEditor->getLineRegions(lno); l1; l1 = l1->next){
+      LineRegion *lr = new LineRegion(*l1);
+      // copy constructor leaves links uninitialized
+      lr->next = lr->prev = nullptr;
+      if (last == nullptr){
+        window->lines[lno - req.topLine] = lr;
+      }
+      else{
+        last->next = lr;
+        lr->prev = last;
+      }
+      last = lr;
+    }
+  }
+
+  if (req.pairs && req.curLine >= req.topLine && req.curLine < visibleEnd && req.curLine < available){
+    window->pair = baseEditor->searchLocalPair(req.curLine, req.curPos);
+  }
+
+  window->complete = (available >= visibleEnd && baseEditor->getInvalidLine() >= visibleEnd);
+  return window.release();
+}
+
+void FarEditor::applyPendingModify()
+{
+  if (pendingModify != -1){
+    baseEditor->modifyEvent(pendingModify);
+    pendingModify = -1;
+  }
+}
+
+void FarEditor::textModified(int topLine)
+{
+  std::lock_guard<std::mutex> lock(textMutex);
+  if (textLines.size() > (size_t)topLine){
+    textLines.resize(topLine);
+  }
+  if (pendingModify == -1 || topLine < pendingModify){
+    pendingModify = topLine;
+  }
+  ret_strNumber = -1;
+  generation++;
+  parserCond.notify_one();
+}
+
+size_t FarEditor::feedLines(size_t count)
+{
+  size_t lno;
+  {
+    std::lock_guard<std::mutex> lock(textMutex);
+    lno = textLines.size();
+  }
+
+  if (lno >= count){
+    return lno;
+  }
+
+  // only main thread adds lines, so no one else extends text meanwhile
+  std::vector<std::shared_ptr<SString>> portion;
+  portion.reserve(std::min(count - lno, (size_t)0x10000));
+  for (; lno < count; lno++){
+    EditorGetString es;
+    es.StringNumber = lno;
+    es.StringText = nullptr;
+
+    if (!info->EditorControl(ECTL_GETSTRING, &es)){
+      break;
+    }
+
+    int len = es.StringLength;
+    if (len > maxLineLength && maxLineLength > 0){
+      len = maxLineLength;
+    }
+    portion.emplace_back(new StringBuffer(es.StringText, 0, len));
+  }
+
+  std::lock_guard<std::mutex> lock(textMutex);
+  if (!portion.empty()){
+    textLines.insert(textLines.end(), portion.begin(), portion.end());
+    parserCond.notify_one();
+  }
+  return textLines.size();
+}
+
+void FarEditor::feedLinesIdle(int msec)
+{
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(msec);
+  size_t count = feedLines(0);
+  do{
+    const size_t fed = feedLines(count + 0x400);
+    if (fed < count + 0x400){
+      break;
+    }
+    count = fed;
+  } while (std::chrono::steady_clock::now() < deadline);
+}
+
 void FarEditor::showOutliner(Outliner *outliner)
 {
   FarMenuItem *menu;
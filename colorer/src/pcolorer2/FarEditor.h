@@ -9,6 +9,11 @@
 #endif // if 0
 #include <colorer/unicode/SString.h>
 #include <colorer/unicode/Character.h>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <vector>
 
 #include"pcolorer.h"
 
@@ -54,6 +59,9 @@ extern const SString DFirstLineBytes;
 /** FAR Editor internal plugin structures.
     Implements text parsing and different
     editor extended functions.
+    Text is parsed by background thread on a copy of editor's lines,
+    that are copied from FAR by main thread, and drawing uses
+    regions of visible lines published by that thread.
     @ingroup far_plugin
 */
 class FarEditor : public LineSource
@@ -67,7 +75,8 @@ public:
 
   void endJob(size_t lno);
   /**
-  Returns line number "lno" from FAR interface. Line is only valid until next call of this function,
+  Returns line number "lno" from copy of FAR editor's text, main thread copies missing lines
+  from FAR interface on demand. Line is only valid until next call of this function,
   it also should not be disposed, this function takes care of this.
   */
 #if 0
@@ -136,7 +145,49 @@ public:
 
   void cleanEditor();
 
+  /** Serializes parsing of all editors and viewers, as parsers share HRC schemes and their regexps.
+  */
+  static std::mutex parseMutex;
+
 private:
+  /** Part of text that should be drawn and cursor position for pairs highlighting.
+  */
+  struct ParseRequest{
+    int topLine, lines, totalLines;
+    int curLine, curPos;
+    bool pairs;
+
+    bool operator==(const ParseRequest &r) const
+    {
+      return topLine == r.topLine && lines == r.lines && totalLines == r.totalLines
+        && curLine == r.curLine && curPos == r.curPos && pairs == r.pairs;
+    }
+  };
+
+  /** Copies of visible lines regions and of local pair under cursor, published by parser thread.
+  */
+  struct ParsedWindow{
+    ParseRequest request;
+    unsigned int generation;
+    bool complete;
+    std::vector<LineRegion *> lines;
+    PairMatch *pair;
+
+    ParsedWindow(const ParseRequest &r, unsigned int g);
+    ~ParsedWindow();
+    LineRegion *getLineRegions(int lno) const;
+  };
+
+  /** Holds parseMutex for main thread's actions, that use parser directly.
+  */
+  class ParserLock{
+  public:
+    ParserLock(FarEditor *editor);
+    ~ParserLock();
+  private:
+    FarEditor *editor;
+  };
+
   EditorInfo ei;
   PluginStartupInfo *info;
 
@@ -144,6 +195,7 @@ private:
   BaseEditor *baseEditor;
 
   int  maxLineLength;
+  int  backParse;
   bool fullBackground;
 
   int drawCross;//0 - off,  1 - always, 2 - if included in the scheme
@@ -165,9 +217,22 @@ private:
 #if 0
   String *ret_str;
 #endif // if 0
-  SString *ret_str;
+  std::shared_ptr<SString> ret_str, parser_str;
   int ret_strNumber;
 
+  // text copy and exchange with parser thread, guarded by textMutex
+  std::mutex textMutex;
+  std::condition_variable parserCond, publishCond;
+  std::thread parserThread;
+  bool parserStop;
+  bool parserLocked;
+  std::vector<std::shared_ptr<SString>> textLines;
+  unsigned int generation;
+  int pendingModify;
+  int parsedLine;
+  ParseRequest request;
+  std::shared_ptr<ParsedWindow> published, drawnWindow;
+
   int newfore, newback;
   const StyledRegion *rdBackground;
   LineRegion *cursorRegion;
@@ -178,6 +243,15 @@ private:
 
   void reloadTypeSettings();
   void enterHandler();
+  void startParser();
+  void stopParser();
+  void parserThreadProc();
+  bool parserHasWork() const;
+  ParsedWindow *collectWindow(const ParseRequest &req, unsigned int gen, int available);
+  void applyPendingModify();
+  void textModified(int topLine);
+  size_t feedLines(size_t count);
+  void feedLinesIdle(int msec);
   color convert(const StyledRegion *rd);
   bool foreDefault(color col);
   bool backDefault(color col);
@@ -219,6 +219,8 @@ void FarEditorSet::viewFile(const String &path)
     // Creates store of text lines
     TextLinesStore textLinesStore;
     textLinesStore.loadFile(&path, nullptr, true);
+    // editors' parser threads wait till viewer is closed
+    std::lock_guard<std::mutex> parseLock(FarEditor::parseMutex);
     // Base editor to make primary parse
     BaseEditor baseEditor(parserFactory, &textLinesStore);
     RegionMapper *regionMap;
@@ -1049,6 +1051,8 @@ void FarEditorSet::ReloadBase()
 
   try{
     parserFactory = new ParserFactory();
+    const SString hrcCache(InMyCache("colorer/hrc_prototypes.cache").c_str());
+    parserFactory->setHrcCache(&hrcCache);
 #if 0
 LOG(DEBUG) << "Parse catalog: " << sCatalogPathExp->getChars();
 #endif // if 0
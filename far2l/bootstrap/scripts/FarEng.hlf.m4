@@ -2795,6 +2795,7 @@ $ #Viewer: control keys#
                        line.
     #Ctrl-Shift-B#       Show/Hide status line
     #Ctrl-S#             Show/Hide the scrollbar.
+    #Ctrl-F#             Toggle follow mode (like tail -f)
     #Alt-BS, Ctrl-Z#     Undo position change
     #RightCtrl-0..9#     Set a bookmark 0..9 at the current position
     #Ctrl-Shift-0..9#    Set a bookmark 0..9 at the current position
@@ -2828,6 +2829,10 @@ $ #Viewer: control keys#
 
     5. For automatic scrolling of a dynamically updating file,
        position the "cursor" to the end of the file (End key).
+       In follow mode (#Ctrl-F#) changes of the file are noticed
+       immediately and only appended data is read; when the file is
+       truncated or replaced by a new one (e.g. rotated log) the viewer
+       rereads or reopens it.
 
     6. Pressing Alt+PgUp/PgDn smoothly increases scrolling speed, futher releasing
        Alt while keeping PgUp/PgDn will continue scrolling with selected speed boost.
@@ -2850,6 +2855,14 @@ by format specifiers added before or after the value.
 
     You can also enter relative values, just add + or - before the number.
 
+    With #Line number# selected the value is a number of line counting from one,
+or, if relative, a count of lines to move by. Lines are counted in background
+when file is opened, so jumping far into a huge file may need to wait until
+counting reaches the destination, #Esc# cancels waiting. Number of line at the
+top of the screen is shown in the viewer's status line. If ~Save file state~@ViewerSettings@
+is enabled then lines of a file that took long to count are remembered until
+file is changed.
+
     Hexadecimal offsets must be specified in one of the following formats:
        0xNNNN, NNNNh, $NNNN
 
@@ -2840,6 +2840,7 @@ $ #Программа просмотра: клавиши управления#
                        клавиш
     #Ctrl-Shift-B#       Спрятать/Показать статусную строку
     #Ctrl-S#             Спрятать/Показать полосу прокрутки
+    #Ctrl-F#             Включить/выключить режим слежения (как tail -f)
     #Alt-BS, Ctrl-Z#     Возврат к предыдущей позиции
     #ПравыйCtrl-0..9#    Установить закладку 0..9 в текущей позиции
     #Ctrl-Shift-0..9#    Установить закладку 0..9 в текущей позиции
@@ -2877,6 +2878,10 @@ $ #Программа просмотра: клавиши управления#
     5. Для автоматического скроллинга просматриваемого
        динамически обновляемого файла необходимо стать в
        конец файла (клавиша End).
+       В режиме слежения (#Ctrl-F#) изменения файла замечаются
+       сразу и читаются только дописанные данные; если файл
+       усечён или заменён новым (например, при ротации лога),
+       то он перечитывается или открывается заново.
 
     6. Нажатие Alt+PgUp/PgDn плавно увеличивает скорость скроллинга, последующее
        отпускание кнопки Alt при сохранении нажатым PgUp/PgDn продолжит скроллинг
@@ -2901,6 +2906,15 @@ $ #Программа просмотра: изменить текущую поз
     Так же можете указать относительное значение - просто укажите знак + или -
 перед числом.
 
+    При выбранном #Номере строки# значение - это номер строки начиная с единицы,
+или, если оно относительное, - на сколько строк переместиться. Строки
+подсчитываются в фоне при открытии файла, поэтому переход далеко вглубь
+огромного файла может потребовать ожидания, пока подсчёт не дойдёт до нужного
+места, #Esc# прерывает ожидание. Номер строки вверху экрана показывается в
+строке статуса программы просмотра. Если включено ~Сохранять состояние~@ViewerSettings@,
+то подсчитанные строки файла, подсчёт которых занял много времени, запоминаются
+до его изменения.
+
     Шестнадцатеричные значения вводятся в одной из следующих форм:
 
      #0xNNNN#, #NNNNh#, #$NNNN#
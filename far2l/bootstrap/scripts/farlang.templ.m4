@@ -19727,6 +19727,39 @@ GoToDecimal
 "10-ічне з&міщення"
 "10-разрадны з&рух"
 
+GoToLine
+"Номер ст&роки"
+"&Line number"
+"Čís&lo řádku"
+"&Zeilennummer"
+"S&orszám"
+"Numer &linii"
+"Número de &línea"
+"Номер &рядка"
+"Нумар &радка"
+
+ViewerCountingLines
+"Подсчёт строк"
+"Counting lines"
+"Počítání řádků"
+"Zeilen werden gezählt"
+"Sorok számolása"
+"Liczenie linii"
+"Contando líneas"
+"Підрахунок рядків"
+"Падлік радкоў"
+
+ViewerFollow
+"Слежение"
+"Follow"
+"Sledování"
+"Verfolgen"
+"Követés"
+"Śledzenie"
+"Seguir"
+"Стеження"
+"Сачэнне"
+
 ExcTrappedException
 "Исключительная ситуация"
 "Exception occurred"
@@ -151,7 +151,7 @@ struct IScannedPattern
 	virtual void GetReady() = 0;
 	virtual const Metrics &GetMetrics() const noexcept = 0;
 	virtual size_t GetCapacity() const noexcept = 0;
-	virtual std::pair<size_t, size_t> FindMatch(const void *begin, size_t len, bool first_fragment, bool last_fragment) const noexcept = 0;
+	virtual std::pair<size_t, size_t> FindMatch(const void *begin, size_t len, size_t start, bool first_fragment, bool last_fragment) const noexcept = 0;
 	virtual void AppendCodePoint(const void *base, size_t base_size, const void *alt, size_t alt_size) = 0;
 
 	// used to check for duplicated patterns
@@ -319,10 +319,12 @@ template <class CodePointT>
 		return 0;
 	}
 
-	virtual std::pair<size_t, size_t> FindMatch(const void *begin, size_t len, bool first_fragment, bool last_fragment) const noexcept
+	virtual std::pair<size_t, size_t> FindMatch(const void *begin, size_t len, size_t start, bool first_fragment, bool last_fragment) const noexcept
 	{
 		const CodeUnit *cu_data = (const CodeUnit *)begin; // already aligned
 		const CodeUnit *cu_end = cu_data + len / sizeof(CodeUnit);
+		// round start up to code unit boundary, so start past previous match never finds it again
+		cu_data+= std::min(size_t(cu_end - cu_data), (start + sizeof(CodeUnit) - 1) / sizeof(CodeUnit));
 		size_t r;
 		for (;;) {
 			r = _case_sensitive
@@ -543,10 +545,22 @@ void FindPattern::GetReady()
 std::pair<size_t, size_t> FindPattern::FindMatch(const void *data, size_t len, bool first_fragment, bool last_fragment) const noexcept
 {
 	for (const auto &pattern : _patterns) {
-		const auto &r = pattern->FindMatch(data, len, first_fragment, last_fragment);
+		const auto &r = pattern->FindMatch(data, len, 0, first_fragment, last_fragment);
 		if (r.second) {
 			return r;
 		}
 	}
 	return std::make_pair((size_t)-1, 0);
 }
+
+std::pair<size_t, size_t> FindPattern::FindEarliestMatch(const void *data, size_t len, size_t start, bool first_fragment, bool last_fragment) const noexcept
+{
+	std::pair<size_t, size_t> out((size_t)-1, 0);
+	for (const auto &pattern : _patterns) {
+		const auto &r = pattern->FindMatch(data, len, start, first_fragment, last_fragment);
+		if (r.second && (!out.second || r.first < out.first)) {
+			out = r;
+		}
+	}
+	return out;
+}
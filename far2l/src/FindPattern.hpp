@@ -50,4 +50,11 @@ public:
 		Returns {start, len} of matching region or {-1, 0} if no match found.
 	*/
 	std::pair<size_t, size_t> FindMatch(const void *data, size_t len, bool first_fragment, bool last_fragment) const noexcept;
+
+	/**
+		Same as FindMatch but looks only for matches starting at or after start offset in data array
+		and returns earliest of them among all added patterns, not just first matched pattern's one.
+		Data preceding start offset still used by whole_words to check left edge of match.
+	*/
+	std::pair<size_t, size_t> FindEarliestMatch(const void *data, size_t len, size_t start, bool first_fragment, bool last_fragment) const noexcept;
 };
@@ -0,0 +1,382 @@
+#include "headers.hpp"
+#include <algorithm>
+#include <crc64.h>
+#include "ViewerLineIndex.hpp"
+
+// mmap'ed window size limit, must be multiple of any sane page size (0x1000 on intel)
+#if defined(__LP64__) || defined(_LP64)
+#define VIEWER_LINE_INDEX_MMAP_WINDOW 0x400000
+#else
+#define VIEWER_LINE_INDEX_MMAP_WINDOW 0x40000
+#endif
+
+// checkpoint put at start of line that follows this many lines or bytes after previous checkpoint
+#define VIEWER_LINE_INDEX_STEP_LINES 0x1000
+#define VIEWER_LINE_INDEX_STEP_BYTES 0x40000
+
+#define VIEWER_LINE_INDEX_CACHE_MAGIC      0x564c4901
+#define VIEWER_LINE_INDEX_CACHE_EXPIRATION (60 * 60 * 24 * 30)
+
+// dont bother caching index of files that were indexed fast enough
+#define VIEWER_LINE_INDEX_CACHE_MIN_MSEC 500
+
+ViewerLineIndex::ViewerLineIndex(const char *path, UINT codepage, wchar_t eol, bool persistent, ViewerLineIndex *grown_from)
+	:
+	_path(path),
+	_persistent(persistent),
+	_smm(path, SafeMMap::M_READ, VIEWER_LINE_INDEX_MMAP_WINDOW),
+	_near_smm(path, SafeMMap::M_READ, VIEWER_LINE_INDEX_MMAP_WINDOW),
+	_size(std::min(_smm.FileSize(), _near_smm.FileSize())),
+	_eol((unsigned char)eol)
+{
+	if (_size == 0) {
+		ThrowPrintf("nothing mapped");
+	}
+
+	// if whole file fits into single window then it will never slide,
+	// otherwise any requested range must fit into window mapped from page-aligned offset
+	_span = (_size <= (int64_t)_smm.Length()) ? _size : int64_t(_smm.Length() - _smm.Page());
+
+	switch (codepage) {
+		case CP_UTF32LE: case CP_UTF32BE:
+			_code_unit = 4;
+			break;
+
+		case CP_UTF16LE: case CP_UTF16BE:
+			_code_unit = 2;
+			break;
+
+		case CP_UTF8:
+			break;
+
+		default: {
+			// line separator must be encoded as is, that is not true for EBCDIC and alike
+			char ch = 0;
+			if (WINPORT(WideCharToMultiByte)(codepage, 0, &eol, 1, &ch, 1, nullptr, nullptr) != 1
+					|| (unsigned char)ch != _eol) {
+				ThrowPrintf("unsupported codepage %u", codepage);
+			}
+		}
+	}
+	_big_endian = (codepage == CP_UTF32BE || codepage == CP_UTF16BE);
+
+	if (grown_from && grown_from->_size <= _size && grown_from->_code_unit == _code_unit
+			&& grown_from->_big_endian == _big_endian && grown_from->_eol == _eol) {
+		// take whatever it managed to index, then continue from its last checkpoint
+		grown_from->_stop = true;
+		grown_from->WaitThread();
+		std::lock_guard<std::mutex> lock(grown_from->_mtx);
+		_checkpoints = grown_from->_checkpoints;
+		_lines = grown_from->_lines;
+		// line that begins right at end of file was not counted, but there is no more end now
+		_indexed = (grown_from->_indexed == grown_from->_size) ? grown_from->_indexed - 1 : grown_from->_indexed;
+
+	} else if (LoadCache()) {
+		return;
+
+	} else {
+		_checkpoints.emplace_back(Checkpoint{0, 0});
+		_lines = 1;
+	}
+
+	if (!StartThread()) {
+		ThrowPrintf("can't start thread");
+	}
+}
+
+ViewerLineIndex::~ViewerLineIndex()
+{
+	_stop = true;
+	WaitThread();
+}
+
+int64_t ViewerLineIndex::Indexed()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _indexed;
+}
+
+int64_t ViewerLineIndex::Lines()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	return _lines;
+}
+
+int64_t ViewerLineIndex::LineOfPos(int64_t pos)
+{
+	pos = std::min(std::max(pos, (int64_t)0), _size);
+	Checkpoint cp;
+	if (!Near(pos, -1, cp)) {
+		return -1;
+	}
+
+	const auto it = std::upper_bound(_near.begin(), _near.end(), pos);
+	return cp.line + (it - _near.begin()) - 1;
+}
+
+int64_t ViewerLineIndex::PosOfLine(int64_t line)
+{
+	Checkpoint cp;
+	if (line < 0 || !Near(-1, line, cp)) {
+		return -1;
+	}
+
+	const size_t index = size_t(line - cp.line);
+	return (index < _near.size()) ? _near[index] : -1;
+}
+
+// finds checkpoint preceding given position (if its not negative) or given line
+// and ensures _near contains offsets of all lines from it up to next checkpoint
+bool ViewerLineIndex::Near(int64_t pos, int64_t line, Checkpoint &cp)
+{
+	size_t checkpoint;
+	int64_t end;
+	bool last;
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		if (pos >= 0 ? (pos > _indexed) : (line >= _lines)) {
+			return false;
+		}
+
+		auto it = (pos >= 0)
+			? std::upper_bound(_checkpoints.begin(), _checkpoints.end(), pos,
+				[](int64_t v, const Checkpoint &c) { return v < c.pos; })
+			: std::upper_bound(_checkpoints.begin(), _checkpoints.end(), line,
+				[](int64_t v, const Checkpoint &c) { return v < c.line; });
+		--it;	// first checkpoint is always at zero line and offset
+		checkpoint = it - _checkpoints.begin();
+		cp = *it;
+		++it;
+		last = (it == _checkpoints.end());
+		end = last ? _indexed : it->pos;
+	}
+
+	return LoadNear(checkpoint, cp, end, last);
+}
+
+bool ViewerLineIndex::LoadNear(size_t checkpoint, const Checkpoint &cp, int64_t end, bool last)
+{
+	if (checkpoint == _near_checkpoint && end == _near_end) {
+		return true;
+	}
+
+	_near_checkpoint = (size_t)-1;
+	_near.clear();
+	try {
+		_near.emplace_back(cp.pos);
+		for (int64_t begin = cp.pos; begin < end;) {
+			const int64_t view_end = std::min(begin + _span, end);
+			const unsigned char *data = View(_near_smm, _near_smm_pos, begin, view_end);
+			const size_t len = size_t(view_end - begin);
+			for (size_t ofs = 0;;) {
+				const size_t eol = FindEOL(data + ofs, len - ofs);
+				if (eol == (size_t)-1) {
+					break;
+				}
+				ofs+= eol + _code_unit;
+				const int64_t pos = begin + ofs;
+				// line that begins exactly at end belongs to next checkpoint unless there is no such
+				if (pos < end || (last && pos == end && pos < _size)) {
+					_near.emplace_back(pos);
+				}
+			}
+			begin = view_end;
+		}
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "ViewerLineIndex::LoadNear: %s [pos=%llx end=%llx]\n",
+			e.what(), (unsigned long long)cp.pos, (unsigned long long)end);
+		_near.clear();
+		return false;
+	}
+
+	_near_checkpoint = checkpoint;
+	_near_end = end;
+	return true;
+}
+
+const unsigned char *ViewerLineIndex::View(SafeMMap &smm, int64_t &smm_pos, int64_t begin, int64_t end)
+{
+	if (begin < smm_pos || end > smm_pos + (int64_t)smm.Length()) {
+		smm_pos = AlignDown(begin, (int64_t)smm.Page());
+		smm.Slide(smm_pos);
+		if (end > smm_pos + (int64_t)smm.Length()) {
+			ThrowPrintf("view [%llx..%llx) doesnt fit window at %llx", (unsigned long long)begin,
+				(unsigned long long)end, (unsigned long long)smm_pos);
+		}
+	}
+
+	return (const unsigned char *)smm.View() + (begin - smm_pos);
+}
+
+// returns offset of first code unit that encodes line separator, data must begin at code unit boundary
+size_t ViewerLineIndex::FindEOL(const unsigned char *data, size_t len) const
+{
+	const size_t low_byte = _big_endian ? _code_unit - 1 : 0;
+	for (size_t ofs = low_byte; ofs < len;) {
+		const unsigned char *p = (const unsigned char *)memchr(data + ofs, _eol, len - ofs);
+		if (!p) {
+			break;
+		}
+
+		const size_t found = p - data;
+		const size_t unit = found - found % _code_unit;
+		if (found - unit == low_byte && unit + _code_unit <= len) {
+			size_t i = unit;
+			while (i < unit + _code_unit && (i == found || !data[i])) {
+				++i;
+			}
+			if (i == unit + _code_unit) {
+				return unit;
+			}
+		}
+		ofs = found + 1;
+	}
+
+	return (size_t)-1;
+}
+
+void *ViewerLineIndex::ThreadProc()
+{
+	const DWORD start_time = WINPORT(GetTickCount)();
+	try {
+		std::vector<Checkpoint> checkpoints;
+		Checkpoint prev;
+		{
+			std::lock_guard<std::mutex> lock(_mtx);
+			prev = _checkpoints.back();
+		}
+		int64_t line = prev.line;
+		for (int64_t begin = prev.pos; begin < _size && !_stop;) {
+			const int64_t end = std::min(begin + _span, _size);
+			const unsigned char *data = View(_smm, _smm_pos, begin, end);
+			const size_t len = size_t(end - begin);
+			for (size_t ofs = 0;;) {
+				const size_t eol = FindEOL(data + ofs, len - ofs);
+				if (eol == (size_t)-1) {
+					break;
+				}
+				ofs+= eol + _code_unit;
+				const int64_t pos = begin + ofs;
+				if (pos >= _size) {
+					break;
+				}
+				++line;
+				if (line - prev.line >= VIEWER_LINE_INDEX_STEP_LINES || pos - prev.pos >= VIEWER_LINE_INDEX_STEP_BYTES) {
+					prev = Checkpoint{line, pos};
+					checkpoints.emplace_back(prev);
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(_mtx);
+			_checkpoints.insert(_checkpoints.end(), checkpoints.begin(), checkpoints.end());
+			checkpoints.clear();
+			_indexed = end;
+			_lines = line + 1;
+			begin = end;
+		}
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "ViewerLineIndex: %s [size=%llx]\n", e.what(), (unsigned long long)_size);
+		return nullptr;
+	}
+
+	if (!_stop && _persistent && WINPORT(GetTickCount)() - start_time >= VIEWER_LINE_INDEX_CACHE_MIN_MSEC) {
+		SaveCache();
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Cache of built indexes: each file has own cache file named by hash of its path. Cache
+// file starts with header that identifies file state and index kind, followed by count of
+// lines and array of checkpoints. Using cache touches its file, so unused ones expire.
+
+std::string ViewerLineIndex::CacheFilePath(bool create_path) const
+{
+	const std::string &sub_path = StrPrintf("viewer/lines/%llx",
+			(unsigned long long)crc64(0, (const unsigned char *)_path.c_str(), _path.size()));
+	return InMyCache(sub_path.c_str(), create_path);
+}
+
+std::string ViewerLineIndex::CacheHeader() const
+{
+	struct stat s{};
+	if (sdc_stat(_path.c_str(), &s) != 0 || s.st_size != _size) {
+		return std::string();
+	}
+
+	std::string out;
+	auto put_pod = [&](uint64_t v) { out.append((const char *)&v, sizeof(v)); };
+	put_pod(VIEWER_LINE_INDEX_CACHE_MAGIC);
+	put_pod(_path.size());
+	out+= _path;
+	put_pod(s.st_dev);
+	put_pod(s.st_ino);
+	put_pod(s.st_size);
+	put_pod(s.st_mtim.tv_sec);
+	put_pod(s.st_mtim.tv_nsec);
+	put_pod(_code_unit);
+	put_pod(_big_endian ? 1 : 0);
+	put_pod(_eol);
+	return out;
+}
+
+bool ViewerLineIndex::LoadCache()
+{
+	if (!_persistent) {
+		return false;
+	}
+
+	const std::string &cache_path = CacheFilePath(false);
+	std::string content;
+	if (!CachedFileLoad(cache_path, content)) {
+		return false;
+	}
+
+	const std::string &header = CacheHeader();
+	if (header.empty() || content.size() < header.size() + sizeof(int64_t)
+			|| content.compare(0, header.size(), header) != 0) {
+		return false;
+	}
+
+	int64_t lines;
+	memcpy(&lines, content.data() + header.size(), sizeof(lines));
+	const size_t ofs = header.size() + sizeof(lines);
+	std::vector<Checkpoint> checkpoints((content.size() - ofs) / sizeof(Checkpoint));
+	if (checkpoints.empty() || (content.size() - ofs) % sizeof(Checkpoint) != 0) {
+		fprintf(stderr, "ViewerLineIndex: bad cache '%s'\n", cache_path.c_str());
+		return false;
+	}
+
+	memcpy(checkpoints.data(), content.data() + ofs, checkpoints.size() * sizeof(Checkpoint));
+	if (checkpoints.front().pos != 0 || checkpoints.front().line != 0
+			|| checkpoints.back().pos >= _size || checkpoints.back().line >= lines) {
+		fprintf(stderr, "ViewerLineIndex: inconsistent cache '%s'\n", cache_path.c_str());
+		return false;
+	}
+
+	_checkpoints.swap(checkpoints);
+	_lines = lines;
+	_indexed = _size;
+	return true;
+}
+
+void ViewerLineIndex::SaveCache()
+{
+	CachedFilesPrune("viewer/lines", VIEWER_LINE_INDEX_CACHE_EXPIRATION);
+
+	std::string content = CacheHeader();
+	if (content.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mtx);
+		content.append((const char *)&_lines, sizeof(_lines));
+		content.append((const char *)_checkpoints.data(), _checkpoints.size() * sizeof(Checkpoint));
+	}
+
+	CachedFileSave(CacheFilePath(true), content.data(), content.size());
+}
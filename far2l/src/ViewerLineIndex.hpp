@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <WinCompat.h>
+#include <Threaded.h>
+#include "SafeMMap.hpp"
+
+/**
+	Index of lines of file shown by viewer, built incrementally by background thread.
+	Keeps sparse checkpoints - offsets where each few thousands line begins, so any line can be
+	found by scanning limited amount of bytes after closest checkpoint, and exact offsets of all
+	lines between checkpoints around last queried position, so moving around it costs nothing.
+	Lines are separated by given character in given codepage, line numbers here are zero-based and
+	all offsets are in bytes, its up to viewer to translate them to its own positions.
+	Constructor throws std::exception if file can't be mapped.
+	If persistent then index that took long to build is saved in cache and reused next time
+	while file keeps same size and modification time.
+	Index of file that grew by appending can continue index of its previous state.
+*/
+class ViewerLineIndex : protected Threaded
+{
+	struct Checkpoint
+	{
+		int64_t line;
+		int64_t pos;
+	};
+
+	const std::string _path;
+	const bool _persistent;
+	SafeMMap _smm;	// used only by background thread
+	SafeMMap _near_smm;	// used only by caller's thread
+	int64_t _smm_pos{0}, _near_smm_pos{0};
+	int64_t _size;
+	int64_t _span;
+	size_t _code_unit{1};
+	bool _big_endian{false};
+	unsigned char _eol;
+
+	std::mutex _mtx;
+	std::vector<Checkpoint> _checkpoints;	// protected by _mtx
+	int64_t _indexed{0};	// protected by _mtx: all lines that begin at or before it are known
+	int64_t _lines{0};		// protected by _mtx: count of known lines
+	std::atomic<bool> _stop{false};
+
+	size_t _near_checkpoint{(size_t)-1};
+	int64_t _near_end{-1};
+	std::vector<int64_t> _near;
+
+	virtual void *ThreadProc();
+
+	const unsigned char *View(SafeMMap &smm, int64_t &smm_pos, int64_t begin, int64_t end);
+	size_t FindEOL(const unsigned char *data, size_t len) const;
+	bool LoadNear(size_t checkpoint, const Checkpoint &cp, int64_t end, bool last);
+	bool Near(int64_t pos, int64_t line, Checkpoint &cp);
+
+	std::string CacheFilePath(bool create_path) const;
+	std::string CacheHeader() const;
+	bool LoadCache();
+	void SaveCache();
+
+public:
+	ViewerLineIndex(const char *path, UINT codepage, wchar_t eol, bool persistent, ViewerLineIndex *grown_from = nullptr);
+	virtual ~ViewerLineIndex();
+
+	inline int64_t FileSize() const { return _size; }
+
+	/// Count of bytes already indexed, equals to FileSize() when done
+	int64_t Indexed();
+
+	/// Count of lines known so far
+	int64_t Lines();
+
+	/// Returns number of line that contains given offset or -1 if its not indexed yet
+	int64_t LineOfPos(int64_t pos);
+
+	/// Returns offset where given line begins or -1 if its not indexed yet
+	int64_t PosOfLine(int64_t line);
+};
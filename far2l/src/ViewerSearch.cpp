@@ -0,0 +1,483 @@
+#include "headers.hpp"
+#include <algorithm>
+#include "ViewerSearch.hpp"
+#include "FindPattern.hpp"
+#include "RegExp.hpp"
+#include "strmix.hpp"
+#include "WideMB.h"
+
+// mmap'ed window size limit, must be multiple of any sane page size (0x1000 on intel)
+#if defined(__LP64__) || defined(_LP64)
+#define VIEWER_SEARCH_MMAP_WINDOW 0x400000
+#else
+#define VIEWER_SEARCH_MMAP_WINDOW 0x40000
+#endif
+
+// extra bytes kept around pattern-sized overlap of adjacent windows so whole words
+// check always sees code units surrounding match, must be multiple of any code unit size
+#define VIEWER_SEARCH_EDGE_SPACE 8
+
+ViewerSearch::ViewerSearch(const char *path, UINT codepage)
+	:
+	_smm(path, SafeMMap::M_READ, VIEWER_SEARCH_MMAP_WINDOW),
+	_size(_smm.FileSize()),
+	_codepage(codepage)
+{
+	// if whole file fits into single window then it will never slide,
+	// otherwise any requested range must fit into window mapped from page-aligned offset
+	_span = (_size <= (int64_t)_smm.Length()) ? _size : int64_t(_smm.Length() - _smm.Page());
+	if (_size == 0) {
+		ThrowPrintf("nothing mapped");
+	}
+
+	switch (_codepage) {
+		case CP_UTF32LE: case CP_UTF32BE:
+			_code_unit = 4;
+			break;
+
+		case CP_UTF16LE: case CP_UTF16BE:
+			_code_unit = 2;
+			break;
+	}
+	_big_endian = (_codepage == CP_UTF32BE || _codepage == CP_UTF16BE);
+}
+
+ViewerSearch::~ViewerSearch()
+{
+	Cancel();
+}
+
+void ViewerSearch::SetupFindPattern()
+{
+	_find_pattern->GetReady();
+	if (_span < _size && int64_t(_find_pattern->LookBehind() + VIEWER_SEARCH_EDGE_SPACE) >= _span / 2) {
+		ThrowPrintf("pattern too long");
+	}
+}
+
+void ViewerSearch::SetText(const wchar_t *str, bool case_sensitive, bool whole_words)
+{
+	_find_pattern.reset(new FindPattern(case_sensitive, whole_words));
+	_find_pattern->AddTextPattern(str, _codepage);
+	SetupFindPattern();
+}
+
+void ViewerSearch::SetHex(const std::vector<uint8_t> &bytes)
+{
+	_find_pattern.reset(new FindPattern(true, false));
+	_find_pattern->AddBytesPattern(bytes.data(), bytes.size());
+	SetupFindPattern();
+}
+
+bool ViewerSearch::SetRegExp(const wchar_t *str, bool case_sensitive)
+{
+	FARString strSlash(str);
+	InsertRegexpQuote(strSlash);
+	_regexp.reset(new RegExp);
+	if (!_regexp->Compile(strSlash, OP_PERLSTYLE | OP_OPTIMIZE | (case_sensitive ? 0 : OP_IGNORECASE))) {
+		_regexp.reset();
+		return false;
+	}
+	_regexp_match.resize(std::max(_regexp->GetBracketsCount(), 1));
+	return true;
+}
+
+void ViewerSearch::Start(int64_t start, bool reverse)
+{
+	_start = std::min(std::max(start, (int64_t)0), _size);
+	_start-= _start % _code_unit;
+	_reverse = reverse;
+	_scanned = 0;
+	_cancel = false;
+	_match_pos = -1;
+	_match_len = 0;
+	_failed = false;
+	if (!StartThread()) {
+		_failed = true;
+	}
+}
+
+bool ViewerSearch::Wait(unsigned int msec)
+{
+	return WaitThread(msec);
+}
+
+void ViewerSearch::Cancel()
+{
+	_cancel = true;
+	WaitThread();
+}
+
+bool ViewerSearch::GetMatch(int64_t &pos, int64_t &len) const
+{
+	if (_match_pos < 0) {
+		return false;
+	}
+
+	pos = _match_pos;
+	len = _match_len;
+	return true;
+}
+
+void *ViewerSearch::ThreadProc()
+{
+	try {
+		if (_regexp && _reverse) {
+			RegExpBackward();
+
+		} else if (_regexp) {
+			RegExpForward();
+
+		} else if (_find_pattern && _reverse) {
+			FindPatternBackward();
+
+		} else if (_find_pattern) {
+			FindPatternForward();
+
+		} else {
+			_failed = true;
+		}
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "ViewerSearch: %s [start=%llx size=%llx]\n",
+			e.what(), (unsigned long long)_start, (unsigned long long)_size);
+		_failed = true;
+	}
+
+	return nullptr;
+}
+
+const unsigned char *ViewerSearch::View(int64_t begin, int64_t end)
+{
+	if (begin < _smm_pos || end > _smm_pos + (int64_t)_smm.Length()) {
+		_smm_pos = AlignDown(begin, (int64_t)_smm.Page());
+		_smm.Slide(_smm_pos);
+		if (end > _smm_pos + (int64_t)_smm.Length()) {
+			ThrowPrintf("view [%llx..%llx) doesnt fit window at %llx", (unsigned long long)begin,
+				(unsigned long long)end, (unsigned long long)_smm_pos);
+		}
+	}
+
+	return (const unsigned char *)_smm.View() + (begin - _smm_pos);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+
+void ViewerSearch::FindPatternForward()
+{
+	const int64_t look_behind = _find_pattern->LookBehind() + VIEWER_SEARCH_EDGE_SPACE;
+	int64_t begin = std::max(_start - VIEWER_SEARCH_EDGE_SPACE, (int64_t)0);
+	for (;;) {
+		const int64_t end = std::min(begin + _span, _size);
+		const size_t start = (_start > begin) ? size_t(_start - begin) : 0;
+		const auto &r = _find_pattern->FindEarliestMatch(View(begin, end),
+			size_t(end - begin), start, begin == 0, end == _size);
+		if (r.second) {
+			_match_pos = begin + r.first;
+			_match_len = r.second;
+			break;
+		}
+
+		if (end == _size || _cancel) {
+			break;
+		}
+
+		begin = end - look_behind;
+		_scanned = begin - _start;
+	}
+}
+
+void ViewerSearch::FindPatternBackward()
+{
+	// match that begins at start position may span up to pattern size plus right edge after it
+	const int64_t look_behind = _find_pattern->LookBehind() + VIEWER_SEARCH_EDGE_SPACE;
+	int64_t end = std::min(_start + look_behind, _size);
+	for (;;) {
+		const int64_t begin = AlignUp(std::max(end - _span, (int64_t)0), (int64_t)VIEWER_SEARCH_EDGE_SPACE);
+		const unsigned char *data = View(begin, end);
+		const size_t last = size_t(_start - begin);
+		std::pair<size_t, size_t> found((size_t)-1, 0);
+		for (size_t start = 0;;) {
+			const auto &r = _find_pattern->FindEarliestMatch(data,
+				size_t(end - begin), start, begin == 0, end == _size);
+			if (!r.second || r.first > last) {
+				break;
+			}
+			found = r;
+			start = r.first + 1;
+		}
+
+		if (found.second) {
+			_match_pos = begin + found.first;
+			_match_len = found.second;
+			break;
+		}
+
+		if (begin == 0 || _cancel) {
+			break;
+		}
+
+		end = begin + look_behind;
+		_scanned = _start - begin;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+
+// checks if code unit at data represents given ASCII char
+bool ViewerSearch::IsChar(const unsigned char *data, unsigned char ch) const
+{
+	for (size_t i = 0; i < _code_unit; ++i) {
+		const bool char_byte = _big_endian ? (i + 1 == _code_unit) : (i == 0);
+		if (data[i] != (char_byte ? ch : 0)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t ViewerSearch::FindLF(const unsigned char *data, size_t len) const
+{
+	if (_code_unit == 1) {
+		const void *lf = memchr(data, '\n', len);
+		return lf ? size_t((const unsigned char *)lf - data) : (size_t)-1;
+	}
+
+	for (size_t i = 0; i + _code_unit <= len; i+= _code_unit) {
+		if (IsChar(data + i, '\n')) {
+			return i;
+		}
+	}
+
+	return (size_t)-1;
+}
+
+size_t ViewerSearch::FindLastLF(const unsigned char *data, size_t len) const
+{
+	for (size_t i = AlignDown(len, _code_unit); i >= _code_unit;) {
+		i-= _code_unit;
+		if (IsChar(data + i, '\n')) {
+			return i;
+		}
+	}
+
+	return (size_t)-1;
+}
+
+bool ViewerSearch::IsLF(int64_t pos)
+{
+	return pos >= 0 && pos + (int64_t)_code_unit <= _size
+		&& IsChar(View(pos, pos + _code_unit), '\n');
+}
+
+/**
+	Finds end of line that starts at begin and start of next line after it.
+	Lines longer than mapping window are cut into window-sized pieces, in such case end == next.
+*/
+void ViewerSearch::LineForward(int64_t begin, int64_t &end, int64_t &next)
+{
+	const int64_t limit = std::min(begin + _span, _size);
+	int64_t mapped_end = std::min(limit, _smm_pos + (int64_t)_smm.Length());
+	if (begin < _smm_pos || mapped_end <= begin) {
+		mapped_end = begin;
+	}
+
+	size_t lf = (mapped_end > begin) ? FindLF(View(begin, mapped_end), size_t(mapped_end - begin)) : (size_t)-1;
+	if (lf == (size_t)-1 && mapped_end < limit) {
+		mapped_end = limit;
+		lf = FindLF(View(begin, mapped_end), size_t(mapped_end - begin));
+	}
+
+	if (lf != (size_t)-1) {
+		end = begin + lf;
+		next = end + _code_unit;
+
+	} else if (limit == _size) {
+		end = next = _size;
+
+	} else {
+		end = next = begin + AlignDown(limit - begin, (int64_t)_code_unit);
+	}
+}
+
+/**
+	Finds start of line that ends at given position (that is LF or piece boundary of too long line).
+*/
+int64_t ViewerSearch::LineBackward(int64_t end)
+{
+	const int64_t limit = AlignUp(std::max(end - _span, (int64_t)0), (int64_t)VIEWER_SEARCH_EDGE_SPACE);
+	int64_t begin = std::max(limit, _smm_pos);
+	if (end > _smm_pos + (int64_t)_smm.Length() || begin >= end) {
+		begin = end;
+	}
+
+	size_t lf = (begin < end) ? FindLastLF(View(begin, end), size_t(end - begin)) : (size_t)-1;
+	if (lf == (size_t)-1 && begin > limit) {
+		begin = limit;
+		lf = FindLastLF(View(begin, end), size_t(end - begin));
+	}
+
+	return (lf != (size_t)-1) ? begin + lf + _code_unit : begin;
+}
+
+void ViewerSearch::DecodeLine(const unsigned char *data, size_t len)
+{
+	_line.clear();
+	if (!len) {
+		return;
+	}
+
+	if (_codepage == CP_UTF8) {
+		_line.resize(len);
+		size_t src_len = len, dst_len = _line.size();
+		MB2Wide_Unescaped((const char *)data, src_len, &_line[0], dst_len, false);
+		_line.resize(dst_len);
+
+	} else if (_codepage == CP_WIDE_LE || _codepage == CP_WIDE_BE) {
+		_line.resize(len / sizeof(wchar_t));
+		memcpy(&_line[0], data, _line.size() * sizeof(wchar_t));
+		if (_codepage == CP_WIDE_BE) {
+			RevBytes(&_line[0], _line.size());
+		}
+
+	} else {
+		_line.resize(len);
+		int r = WINPORT(MultiByteToWideChar)(_codepage, 0, (const char *)data, (int)len, &_line[0], (int)len);
+		_line.resize(r > 0 ? r : 0);
+	}
+}
+
+/**
+	Returns count of bytes at data that were decoded into given count of leading chars of decoded line.
+*/
+size_t ViewerSearch::EncodedLength(const unsigned char *data, size_t len, size_t chars) const
+{
+	if (!chars) {
+		return 0;
+	}
+
+	if (_codepage == CP_UTF8) {
+		// walk source chars one by one: ill-formed sequences decoded to replacement char
+		// and encoding it back wouldn't give original size
+		size_t ofs = 0;
+		for (; chars && ofs < len; --chars) {
+			wchar_t wc;
+			size_t src_len = len - ofs;
+			MB2Wide_Unescaped((const char *)data + ofs, src_len, wc, false);
+			ofs+= std::max(src_len, (size_t)1);
+		}
+		return std::min(ofs, len);
+	}
+
+	if (_codepage == CP_WIDE_LE || _codepage == CP_WIDE_BE) {
+		return chars * sizeof(wchar_t);
+	}
+
+	int r = WINPORT(WideCharToMultiByte)(_codepage, 0, _line.c_str(), (int)chars, nullptr, 0, nullptr, nullptr);
+	return (r > 0) ? std::min((size_t)r, len) : chars;
+}
+
+/**
+	Looks for non-empty match of regexp in decoded line that starts at [from..last] chars range.
+	In reverse mode looks for last of such matches, otherwise - for first one.
+*/
+bool ViewerSearch::MatchLine(size_t from, size_t last, int &start, int &end)
+{
+	const ReStringView text(_line.c_str(), _line.size());
+	bool found = false;
+	for (size_t pos = from; pos <= _line.size() && pos <= last;) {
+		int n = (int)_regexp_match.size();
+		if (!_regexp->SearchEx(text, pos, _regexp_match.data(), n)) {
+			break;
+		}
+		const auto &m = _regexp_match[0];
+		if (m.start < 0 || size_t(m.start) > last) {
+			break;
+		}
+		if (m.end > m.start) {
+			start = m.start;
+			end = m.end;
+			found = true;
+			if (!_reverse) {
+				break;
+			}
+		}
+		pos = size_t(m.start) + 1;
+	}
+
+	return found;
+}
+
+/**
+	Decodes line from [begin..end) bytes range and matches regexp against it,
+	accepting only matches that start within [from..last] bytes range of file.
+	line_break tells if line is followed by LF, but not cut due to its length.
+*/
+bool ViewerSearch::MatchLineBytes(int64_t begin, int64_t end, bool line_break, int64_t from, int64_t last)
+{
+	const unsigned char *data = View(begin, end);
+	size_t len = size_t(end - begin);
+	if (line_break && len >= _code_unit && IsChar(data + len - _code_unit, '\r')) {
+		len-= _code_unit; // CR before LF is a part of line break
+	}
+
+	size_t from_chars = 0, last_chars = (size_t)-1;
+	if (from > begin) {
+		DecodeLine(data, std::min(size_t(from - begin), len));
+		from_chars = _line.size();
+	}
+	if (last >= begin && last < begin + (int64_t)len) {
+		DecodeLine(data, size_t(last - begin));
+		last_chars = _line.size();
+	}
+
+	DecodeLine(data, len);
+
+	int start = 0, stop = 0;
+	if (!MatchLine(from_chars, last_chars, start, stop)) {
+		return false;
+	}
+
+	const size_t start_bytes = EncodedLength(data, len, start);
+	_match_pos = begin + start_bytes;
+	_match_len = std::max(EncodedLength(data, len, stop), start_bytes + 1) - start_bytes;
+	return true;
+}
+
+void ViewerSearch::RegExpForward()
+{
+	for (int64_t begin = LineBackward(_start);;) {
+		int64_t end, next;
+		LineForward(begin, end, next);
+		if (MatchLineBytes(begin, end, next != end, _start, _size)) {
+			break;
+		}
+
+		if (next >= _size || _cancel) {
+			break;
+		}
+
+		begin = next;
+		_scanned = begin - _start;
+	}
+}
+
+void ViewerSearch::RegExpBackward()
+{
+	int64_t begin = LineBackward(_start), end, next;
+	LineForward(begin, end, next);
+	for (bool line_break = (next != end);;) {
+		if (MatchLineBytes(begin, end, line_break, 0, _start)) {
+			break;
+		}
+
+		if (begin == 0 || _cancel) {
+			break;
+		}
+
+		line_break = IsLF(begin - _code_unit);
+		end = line_break ? begin - _code_unit : begin;
+		begin = LineBackward(end);
+		_scanned = _start - begin;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <WinCompat.h>
+#include <Threaded.h>
+#include "SafeMMap.hpp"
+
+class FindPattern;
+class RegExp;
+struct RegExpMatch;
+
+/**
+	Searches file shown by viewer in background thread, so viewer only displays progress and lets user cancel.
+	Text and hex are looked up by FindPattern directly in memory-mapped windows of file,
+	regular expression is matched against lines of file decoded from viewer's codepage one by one.
+	All offsets here are in bytes, its up to viewer to translate them to its own positions.
+	Constructor and Set* methods throw std::exception if file or pattern can't be handled,
+	so viewer may fallback to searching by itself.
+*/
+class ViewerSearch : protected Threaded
+{
+	SafeMMap _smm;
+	int64_t _smm_pos{0};
+	int64_t _size;
+	int64_t _span;
+	const UINT _codepage;
+	size_t _code_unit{1};
+	bool _big_endian{false};
+
+	std::unique_ptr<FindPattern> _find_pattern;
+	std::unique_ptr<RegExp> _regexp;
+	std::vector<RegExpMatch> _regexp_match;
+	std::wstring _line;
+
+	int64_t _start{0};
+	bool _reverse{false};
+	std::atomic<int64_t> _scanned{0};
+	std::atomic<bool> _cancel{false};
+
+	int64_t _match_pos{-1}, _match_len{0};
+	bool _failed{false};
+
+	virtual void *ThreadProc();
+
+	const unsigned char *View(int64_t begin, int64_t end);
+	bool IsChar(const unsigned char *data, unsigned char ch) const;
+	size_t FindLF(const unsigned char *data, size_t len) const;
+	size_t FindLastLF(const unsigned char *data, size_t len) const;
+	bool IsLF(int64_t pos);
+	void LineForward(int64_t begin, int64_t &end, int64_t &next);
+	int64_t LineBackward(int64_t end);
+
+	void DecodeLine(const unsigned char *data, size_t len);
+	size_t EncodedLength(const unsigned char *data, size_t len, size_t chars) const;
+	bool MatchLine(size_t from, size_t last, int &start, int &end);
+	bool MatchLineBytes(int64_t begin, int64_t end, bool line_break, int64_t from, int64_t last);
+
+	void SetupFindPattern();
+	void FindPatternForward();
+	void FindPatternBackward();
+	void RegExpForward();
+	void RegExpBackward();
+
+public:
+	ViewerSearch(const char *path, UINT codepage);
+	virtual ~ViewerSearch();
+
+	void SetText(const wchar_t *str, bool case_sensitive, bool whole_words);
+	void SetHex(const std::vector<uint8_t> &bytes);
+	/// Returns false if expression can't be compiled
+	bool SetRegExp(const wchar_t *str, bool case_sensitive);
+
+	inline int64_t FileSize() const { return _size; }
+
+	/// Starts looking for match that begins at or after start (at or before start if reverse)
+	void Start(int64_t start, bool reverse);
+
+	/// Returns true if search finished within given time
+	bool Wait(unsigned int msec);
+
+	/// Stops search and waits for background thread to exit
+	void Cancel();
+
+	/// Count of bytes already checked since start position
+	inline int64_t Scanned() const { return _scanned; }
+
+	/// Valid after search finished: true means searching was not possible due to some error
+	inline bool Failed() const { return _failed; }
+
+	/// Valid after search finished: returns false if nothing found
+	bool GetMatch(int64_t &pos, int64_t &len) const;
+};
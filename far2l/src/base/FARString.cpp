@@ -158,9 +158,11 @@ void FARString::Content::AddRef()
 
 void FARString::Content::DecRef()
 {
-	// __atomic_load_n(relaxed) usually doesn't use any HW interlocking
-	// thus its a fast path for empty or single-owner strings
-	unsigned int n = __atomic_load_n(&m_nRefCount, __ATOMIC_RELAXED);
+	// __atomic_load_n(acquire) usually doesn't use any HW interlocking
+	// thus its a fast path for empty or single-owner strings; acquire
+	// ordering makes content accesses done by other threads that already
+	// released their references to happen before content gets destroyed
+	unsigned int n = __atomic_load_n(&m_nRefCount, __ATOMIC_ACQUIRE);
 	if (LIKELY(n == 0))
 	{  // (only) empty singletone has always-zero m_nRefCount
 		return;
@@ -168,7 +170,7 @@ void FARString::Content::DecRef()
 
 	if (LIKELY(n != 1))
 	{
-		if (LIKELY(__atomic_sub_fetch(&m_nRefCount, 1, __ATOMIC_RELEASE) != 0))
+		if (LIKELY(__atomic_sub_fetch(&m_nRefCount, 1, __ATOMIC_ACQ_REL) != 0))
 			return;
 	}
 
@@ -50,12 +50,21 @@ inline const wchar_t *NullToEmpty(const wchar_t *s) { return s ? s : L""; }
 		Use GetBuffer/ReleaseBuffer or simple plain assignment instead.
 		- Don't modify single FARString instance from different threads without serialization.
 		Create per-thread copies of FARString and modifying them from that threads is perfectly fine however.
+		Copying, passing and destroying copies of same string in different threads is safe: reference counter
+		is atomic and content is copied on modification if its shared.
 		- Avoid excessive copying. While its doesn't copy string content, it performs still slow HW-interlocked
 		reference counter manipulations, so better use passing-by-reference and std::move where possible.
+		Releasing string that has single owner doesn't use HW interlocking.
+		- There is no inline storage for short strings by design: content of string never moves in memory
+		while string is alive and not modified, even if FARString instance itself is moved (like on
+		std::vector reallocation), and lot of code relies on that keeping raw pointers returned by CPtr().
+		Use FARStringPool to avoid keeping many copies of same short strings, like file names.
 */
 
 class FARString
 {
+	friend class FARStringPool;
+
 	/*
 		<Content> represents actual content of string that may be shared across different FARStrings
 		and it must be trivial cuz there is sEmptyData singletone shared across all empty strings and
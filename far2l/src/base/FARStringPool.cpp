@@ -0,0 +1,72 @@
+#include "headers.hpp"
+#include "FARStringPool.hpp"
+
+size_t FARStringPool::KeyHash::operator()(const Key &key) const
+{
+	// FNV-1a
+	uint64_t h = 14695981039346656037ULL;
+	for (size_t i = 0; i < key.Length; ++i) {
+		h^= (uint64_t)key.Data[i];
+		h*= 1099511628211ULL;
+	}
+	return (size_t)(h ^ (h >> 32));
+}
+
+FARStringPool::Shard &FARStringPool::ShardOf(const Key &key)
+{
+	// low bits of hash are used by buckets of shard's map, so use high bits to choose shard
+	const size_t hash = KeyHash()(key);
+	return _shards[(hash >> (sizeof(hash) * 8 - 8)) % ARRAYSIZE(_shards)];
+}
+
+FARString FARStringPool::Intern(const wchar_t *Data, size_t Length)
+{
+	if (!Length) {
+		return FARString();
+	}
+
+	const Key key{Data, Length};
+	Shard &shard = ShardOf(key);
+	std::lock_guard<std::mutex> lock(shard.Mtx);
+	auto it = shard.Strings.find(key);
+	if (it == shard.Strings.end()) {
+		FARString str(Data, Length);
+		const Key own_key{str.CPtr(), str.GetLength()};
+		it = shard.Strings.emplace(own_key, std::move(str)).first;
+	}
+	return it->second;
+}
+
+FARString FARStringPool::Intern(const FARString &Str)
+{
+	if (Str.IsEmpty()) {
+		return FARString();
+	}
+
+	const Key key{Str.CPtr(), Str.GetLength()};
+	Shard &shard = ShardOf(key);
+	std::lock_guard<std::mutex> lock(shard.Mtx);
+	auto it = shard.Strings.find(key);
+	if (it == shard.Strings.end()) {
+		// Str's content shared with pool, so its copied on modification of Str and key remains valid
+		it = shard.Strings.emplace(key, Str).first;
+	}
+	return it->second;
+}
+
+size_t FARStringPool::Purge()
+{
+	size_t out = 0;
+	for (auto &shard : _shards) {
+		std::lock_guard<std::mutex> lock(shard.Mtx);
+		for (auto it = shard.Strings.begin(); it != shard.Strings.end();) {
+			if (it->second.m_pContent->GetRefs() == 1) {
+				it = shard.Strings.erase(it);
+				++out;
+			} else {
+				++it;
+			}
+		}
+	}
+	return out;
+}
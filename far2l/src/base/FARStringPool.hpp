@@ -0,0 +1,52 @@
+#pragma once
+#include <mutex>
+#include <unordered_map>
+
+/**
+Thread-safe pool that allows equal strings met many times or by different threads,
+like file names or names of files owners, to share single content instead of keeping
+own copy each. Pool keeps reference to each pooled content, so it stays alive until
+Purge() releases contents that are not referenced from anywhere else anymore.
+Pool is split into independently locked shards, so concurrent interning of different
+strings rarely contends on same lock.
+*/
+
+class FARStringPool
+{
+	struct Key
+	{
+		const wchar_t *Data;
+		size_t Length;
+
+		bool operator==(const Key &other) const
+		{
+			return Length == other.Length && wmemcmp(Data, other.Data, Length) == 0;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key &key) const;
+	};
+
+	struct Shard
+	{
+		std::mutex Mtx;
+		// Key points into content of mapped FARString that never moves while pooled
+		std::unordered_map<Key, FARString, KeyHash> Strings;
+	} _shards[16];
+
+	Shard &ShardOf(const Key &key);
+
+public:
+	FARString Intern(const wchar_t *Data, size_t Length);
+
+	inline FARString Intern(const wchar_t *Data) { return Intern(Data, wcslen(Data)); }
+
+	// Returns string that shares content with pooled string equal to Str, pooling
+	// Str's own content if there is no such string in pool yet.
+	FARString Intern(const FARString &Str);
+
+	// Releases pooled strings not referenced from outside of pool, returns count of released strings.
+	size_t Purge();
+};
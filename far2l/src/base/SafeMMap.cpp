@@ -240,7 +240,7 @@ SafeMMap::SafeMMap(const char *path, enum Mode m, size_t len_limit)
 
 	_file_size = s.st_size;
 
-	_len = (size_t)std::min(s.st_size, (off_t)len_limit);
+	_len = _len_limit = (size_t)std::min(s.st_size, (off_t)len_limit);
 	if (_len == 0) {
 		return;
 	}
@@ -278,14 +278,18 @@ void SafeMMap::Slide(off_t file_offset)
 			(unsigned long long)file_offset, (unsigned long long)_file_size);
 	}
 
-	const size_t new_len = (size_t)std::min((off_t)_len, _file_size - file_offset);
+	const size_t new_len = (size_t)std::min((off_t)_len_limit, _file_size - file_offset);
 	// In documentation only BSD and Linux clearly stating that using MAP_FIXED
 	// unmaps previous mapping(s) from affected address range.
 	// So for that systems use approach looking most optimal: remap same pages to
 	// different region of file. At least this should allow VMM to avoid searching
 	// for free pages as well as reduce syscalls count by avoiding call to munmap().
+	// But if view was shrunk by sliding to the tail of file and now slides back
+	// then need bigger region, so map it anew as pages after view may be busy.
 #if defined(__linux__) || defined(__FreeBSD__) || defined(__DragonFly__)
-	void *new_view = mmap(_view, new_len, _prot, _flags | MAP_FIXED, _fd, file_offset);
+	void *new_view = (new_len <= _len)
+		? mmap(_view, new_len, _prot, _flags | MAP_FIXED, _fd, file_offset)
+		: mmap(nullptr, new_len, _prot, _flags, _fd, file_offset);
 #else
 	void *new_view = mmap(nullptr, new_len, _prot, _flags, _fd, file_offset);
 #endif
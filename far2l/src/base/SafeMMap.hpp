@@ -22,6 +22,7 @@ class SafeMMap
 	off_t _file_size = 0;
 	void *_view = nullptr;
 	size_t _len = 0;
+	size_t _len_limit = 0;
 	size_t _pg = 0x1000;
 	int _prot;
 	int _flags;
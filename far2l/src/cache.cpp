@@ -119,13 +119,37 @@ void BufferedFileView::Close()
 	}
 }
 
-void BufferedFileView::ActualizeFileSize()
+bool BufferedFileView::ActualizeFileSize(bool Appending)
 {
 	struct stat s{};
-	if (FD != -1 && !PseudoFile && sdc_fstat(FD, &s) == 0 && FileSize != (UINT64)s.st_size) {
+	if (FD == -1 || PseudoFile || sdc_fstat(FD, &s) != 0 || FileSize == (UINT64)s.st_size) {
+		return true;
+	}
+
+	bool Out = ((UINT64)s.st_size > FileSize);
+	if (Out && Appending && BufferBounds.Ptr < BufferBounds.End) {
+		// file could be truncated and then grown past its previous size since last check,
+		// so make sure buffered content that ends where file ended still matches actual one
+		const UINT64 TailPtr = std::max(BufferBounds.Ptr,
+				(BufferBounds.End > TailCheckSize) ? BufferBounds.End - TailCheckSize : 0);
+		const DWORD TailSize = DWORD(BufferBounds.End - TailPtr);
+		BYTE Tail[TailCheckSize];
+		Out = (DirectReadAt(TailPtr, Tail, TailSize) == TailSize
+				&& memcmp(Tail, &Buffer[CheckedCast<size_t>(TailPtr - BufferBounds.Ptr)], TailSize) == 0);
+	}
+
+	if (!Out || !Appending) {
 		Clear();
-		FileSize = s.st_size;
 	}
+	FileSize = s.st_size;
+	return Out;
+}
+
+bool BufferedFileView::Replaced(const std::string &PathName) const
+{
+	struct stat s{}, ps{};
+	return FD != -1 && !PseudoFile && sdc_fstat(FD, &s) == 0 && sdc_stat(PathName.c_str(), &ps) == 0
+			&& (s.st_dev != ps.st_dev || s.st_ino != ps.st_ino);
 }
 
 void BufferedFileView::Clear()
@@ -49,7 +49,15 @@ public:
 
 	bool Opened() const { return FD != -1; }
 
-	void ActualizeFileSize();
+	/*
+		Updates file size from actual one. If Appending then already buffered content is kept
+		when file grows, so only appended data will be read. Returns false if file was truncated
+		or (if Appending) rewritten, so everything read before is not valid anymore.
+	*/
+	bool ActualizeFileSize(bool Appending = false);
+
+	// returns true if PathName refers to another file than opened one, like after log rotation
+	bool Replaced(const std::string &PathName) const;
 
 	void SetPointer(INT64 Ptr, int Whence = SEEK_SET);
 	inline void GetPointer(INT64 &Ptr) const { Ptr = CurPtr; }
@@ -73,7 +81,8 @@ private:
 		AlignSize     = 0x1000,		// must be power of 2
 		AheadCount    = 0x10,
 		BehindCount   = 0x1,
-		CapacityStock = 0x4
+		CapacityStock = 0x4,
+		TailCheckSize = 0x100		// buffered bytes compared with actual ones when file grows
 	};
 
 	struct Bounds
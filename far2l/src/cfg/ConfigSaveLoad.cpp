@@ -551,10 +551,13 @@ public:
 	{true,  NSecSystem, "SparseFiles", &Opt.CMOpt.SparseFiles, 0},
 	{true,  NSecSystem, "HowCopySymlink", &Opt.CMOpt.HowCopySymlink, 1},
 	{true,  NSecSystem, "WriteThrough", &Opt.CMOpt.WriteThrough, 0},
+	{true,  NSecSystem, "CopyReadAhead", &Opt.CMOpt.CopyReadAhead, 1},
+	{true,  NSecSystem, "CopySmallFilesInParallel", &Opt.CMOpt.CopySmallFilesInParallel, 1},
 	{true,  NSecSystem, "CopyXAttr", &Opt.CMOpt.CopyXAttr, 0},
 	{false, NSecSystem, "CopyAccessMode", &Opt.CMOpt.CopyAccessMode, 1},
 	{true,  NSecSystem, "MultiCopy", &Opt.CMOpt.MultiCopy, 0},
 	{true,  NSecSystem, "CopyTimeRule", &Opt.CMOpt.CopyTimeRule, 3},
+	{true,  NSecSystem, "DelInParallel", &Opt.DelOpt.DelInParallel, 1},
 
 	{true,  NSecSystem, "InactivityExit", &Opt.InactivityExit, 0},
 	{true,  NSecSystem, "InactivityExitTime", &Opt.InactivityExitTime, 15},
@@ -575,6 +578,7 @@ public:
 	{true,  NSecSystem, "SearchOutFormatWidth", &Opt.FindOpt.strSearchOutFormatWidth, L"14,13,0"},
 	{true,  NSecSystem, "FindFolders", &Opt.FindOpt.FindFolders, 1},
 	{true,  NSecSystem, "FindSymLinks", &Opt.FindOpt.FindSymLinks, 1},
+	{true,  NSecSystem, "FindScanThreads", &Opt.FindOpt.ScanThreads, 1},
 	{true,  NSecSystem, "UseFilterInSearch", &Opt.FindOpt.UseFilter, 0},
 	{true,  NSecSystem, "FindCodePage", &Opt.FindCodePage, CP_AUTODETECT},
 	{false, NSecSystem, "CmdHistoryRule", &Opt.CmdHistoryRule, 0},
@@ -648,6 +652,7 @@ public:
 	{false, NSecPanel, "ShellRightLeftArrowsRule", &Opt.ShellRightLeftArrowsRule, 0},
 	{true,  NSecPanel, "ShowHidden", &Opt.ShowHidden, 1},
 	{true,  NSecPanel, "Highlight", &Opt.Highlight, 1},
+	{true,  NSecPanel, "ParallelStat", &Opt.ParallelStat, 0},
 	{true,  NSecPanel, "SortFolderExt", &Opt.SortFolderExt, 0},
 	{true,  NSecPanel, "SelectFolders", &Opt.SelectFolders, 0},
 	{true,  NSecPanel, "ReverseSort", &Opt.ReverseSort, 1},
@@ -656,6 +661,7 @@ public:
 	{false, NSecPanel, "CtrlAltShiftRule", &Opt.PanelCtrlAltShiftRule, 0},
 	{false, NSecPanel, "RememberLogicalDrives", &Opt.RememberLogicalDrives, 0},
 	{true,  NSecPanel, "AutoUpdateLimit", &Opt.AutoUpdateLimit, 0},
+	{true,  NSecPanel, "AutoUpdateIncremental", &Opt.AutoUpdateIncremental, 1},
 
 	{true,  NSecPanelLeft, "Type", &Opt.LeftPanel.Type, 0},
 	{true,  NSecPanelLeft, "Visible", &Opt.LeftPanel.Visible, 1},
@@ -329,6 +329,7 @@ struct FindFileOptions
 	bool CollectFiles;
 	bool UseFilter;
 	bool FindAlternateStreams;
+	int ScanThreads;	// 1 - sequential directories walk, 0 - parallel using CPU-s count threads, N - using N threads
 	FARString strSearchInFirstSize;
 
 	FARString strSearchOutFormat;
@@ -367,11 +368,14 @@ struct CopyMoveOptions
 	int HowCopySymlink;
 	int SparseFiles;
 	int UseCOW;
+	int CopyReadAhead;		// overlap reading of next piece with writing of current one
+	int CopySmallFilesInParallel;	// copy many small files by several threads
 };
 
 struct DeleteOptions
 {
 	int DelShowTotal;	// показать общий индикатор удаления
+	int DelInParallel;	// remove directories contents by several threads
 };
 
 struct MacroOptions
@@ -397,6 +401,7 @@ struct Options
 	int InactivityExitTime;
 	int ShowHidden;
 	int Highlight;
+	int ParallelStat;	// query attributes of files using several threads when reading folder into panel
 
 	FARString strLeftFolder;
 	FARString strRightFolder;
@@ -498,6 +503,7 @@ struct Options
 
 	DWORD AutoUpdateLimit;	// выше этого количество автоматически не обновлять панели.
 	int AutoUpdateRemoteDrive;
+	int AutoUpdateIncremental;	// apply changed names reported by change notification instead of rereading whole folder
 
 	FARString strLanguage;
 	int SmallIcon;
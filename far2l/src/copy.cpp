@@ -71,8 +71,12 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "DlgGuid.hpp"
 #include "console.hpp"
 #include "wakeful.hpp"
+#include <Threaded.h>
+#include <WorkStealingPool.h>
 #include <unistd.h>
 #include <algorithm>
+#include <mutex>
+#include <condition_variable>
 
 #if defined(__APPLE__)
 #include <AvailabilityMacros.h>
@@ -96,8 +100,9 @@ static long OldCalcTime;
 
 enum
 {
-	COPY_BUFFER_SIZE   = 0x800000,
-	COPY_PIECE_MINIMAL = 0x10000
+	COPY_BUFFER_SIZE       = 0x800000,
+	COPY_PIECE_MINIMAL     = 0x10000,
+	COPY_READAHEAD_MINIMAL = 0x100000	// smaller files copied without background reading
 };
 
 enum
@@ -562,8 +567,9 @@ ShellCopyBuffer::ShellCopyBuffer()
 	Size(std::min((DWORD)COPY_PIECE_MINIMAL, Capacity)),
 	// allocate page-aligned memory: IO works faster on that, also direct-io requires buffer to be aligned sometimes
 	// OSX lacks aligned_malloc so do it manually
-	Buffer(new char[Capacity + USE_PAGE_SIZE]),
-	Ptr(AlignPageUp(Buffer))
+	Buffer(new char[Capacity * 2 + USE_PAGE_SIZE]),
+	Ptr(AlignPageUp(Buffer)),
+	AheadPtr(Ptr + Capacity)
 {}
 
 ShellCopyBuffer::~ShellCopyBuffer()
@@ -571,6 +577,258 @@ ShellCopyBuffer::~ShellCopyBuffer()
 	delete[] Buffer;
 }
 
+/*
+	Reads pieces of source file in background thread, so reading of next piece overlaps
+	with writing of current one. Only one read may be in flight, its result must be
+	fetched by Wait() before issuing next one or touching source file in any other way.
+	Read errors are not handled here but reported to caller, that retries reading in
+	main thread - so all UI interaction remains there.
+*/
+class ShellCopyReadAhead : protected Threaded
+{
+	File &_SrcFile;
+	std::mutex _Mtx;
+	std::condition_variable _Cond;
+	char *_Ptr = nullptr;
+	DWORD _Size = 0;
+	DWORD _BytesRead = 0;
+	int _Errno = 0;
+	bool _Requested = false, _Pending = false, _Exiting = false, _Result = false;
+
+	virtual void *ThreadProc()
+	{
+		std::unique_lock<std::mutex> lock(_Mtx);
+		for (;;) {
+			if (_Exiting)
+				break;
+
+			if (!_Requested) {
+				_Cond.wait(lock);
+				continue;
+			}
+
+			char *Ptr = _Ptr;
+			const DWORD Size = _Size;
+			lock.unlock();
+
+			DWORD BytesRead = 0;
+			const bool Result = _SrcFile.Read(Ptr, Size, &BytesRead);
+			const int Errno = errno;
+
+			lock.lock();
+			_BytesRead = BytesRead;
+			_Result = Result;
+			_Errno = Errno;
+			_Requested = false;
+			_Cond.notify_all();
+		}
+		return nullptr;
+	}
+
+public:
+	ShellCopyReadAhead(File &SrcFile) : _SrcFile(SrcFile)
+	{
+		if (!StartThread())
+			throw std::runtime_error("StartThread failed");
+	}
+
+	virtual ~ShellCopyReadAhead()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_Mtx);
+			_Exiting = true;
+			_Cond.notify_all();
+		}
+		WaitThread();
+	}
+
+	bool Pending() const { return _Pending; }
+
+	char *Ptr() const { return _Ptr; }
+
+	void Start(char *Ptr, DWORD Size)
+	{
+		std::lock_guard<std::mutex> lock(_Mtx);
+		ASSERT(!_Pending);
+		_Ptr = Ptr;
+		_Size = Size;
+		_Requested = _Pending = true;
+		_Cond.notify_all();
+	}
+
+	// waits for completion of pending read, on failure sets errno to error of that read
+	bool Wait(DWORD &BytesRead)
+	{
+		std::unique_lock<std::mutex> lock(_Mtx);
+		ASSERT(_Pending);
+		while (_Requested) {
+			_Cond.wait(lock);
+		}
+		_Pending = false;
+		BytesRead = _BytesRead;
+		if (!_Result)
+			errno = _Errno;
+		return _Result;
+	}
+};
+
+/*
+	Copies small files by pool of threads, so per-file open/create/close/utimens
+	latencies of different files overlap. Workers never interact with UI and never
+	touch copy progress state - main thread collects results by Fetch(), and files
+	that workers failed to copy are copied again by main thread usual way, so all
+	errors handling, prompts and elevation remain there.
+*/
+class ShellCopySmallFiles
+{
+public:
+	struct Item
+	{
+		FARString strSrcName;
+		FAR_FIND_DATA_EX SrcData;
+		FARString strDestName;
+		int Error = 0;
+	};
+
+private:
+	const bool _CopyAccessMode, _CopyXAttr;
+	const size_t _InFlightLimit;
+	std::mutex _Mtx;
+	std::condition_variable _Cond;
+	size_t _InFlight = 0;
+	uint64_t _CopiedSize = 0;
+	std::vector<Item> _Failed;
+	WorkStealingPool _Pool;
+
+	static int Discard(File &DestFile, const FARString &strDestName)
+	{
+		ErrnoSaver ErSr;
+		DestFile.Close();
+		apiDeleteFile(strDestName);
+		return ErSr.Get() ? ErSr.Get() : EIO;
+	}
+
+	// returns zero on success or errno value on failure
+	int CopyFile(const Item &It) const
+	{
+		File SrcFile, DestFile;
+		if (!SrcFile.Open(It.strSrcName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+					nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN))
+			return errno ? errno : EIO;
+
+		std::unique_ptr<ShellCopyFileExtendedAttributes> XAttrCopyPtr;
+		if (_CopyXAttr)
+			XAttrCopyPtr.reset(new ShellCopyFileExtendedAttributes(SrcFile));
+
+		const DWORD ModeToCreateWith = It.SrcData.dwUnixMode | S_IWUSR;
+		if (!DestFile.Open(It.strDestName, GENERIC_WRITE, FILE_SHARE_READ,
+					_CopyAccessMode ? &ModeToCreateWith : nullptr, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN))
+			return errno ? errno : EIO;
+
+		std::vector<char> Buffer(COPY_PIECE_MINIMAL);
+		for (;;) {
+			DWORD BytesRead = 0, BytesWritten = 0;
+			if (!SrcFile.Read(Buffer.data(), (DWORD)Buffer.size(), &BytesRead))
+				return Discard(DestFile, It.strDestName);
+
+			if (BytesRead == 0)
+				break;
+
+			if (!DestFile.Write(Buffer.data(), BytesRead, &BytesWritten) || BytesWritten != BytesRead)
+				return Discard(DestFile, It.strDestName);
+		}
+
+		if (XAttrCopyPtr)
+			XAttrCopyPtr->ApplyToCopied(DestFile);
+
+		if (_CopyAccessMode
+				&& (ModeToCreateWith != It.SrcData.dwUnixMode || (g_umask & It.SrcData.dwUnixMode) != 0))
+			DestFile.Chmod(It.SrcData.dwUnixMode);
+
+		DestFile.SetTime(nullptr, nullptr, &It.SrcData.ftLastWriteTime, nullptr);
+
+		if (!DestFile.Close()) {
+			ErrnoSaver ErSr;
+			apiDeleteFile(It.strDestName);
+			return ErSr.Get() ? ErSr.Get() : EIO;
+		}
+
+		return 0;
+	}
+
+	void Process(Item &It)
+	{
+		It.Error = CopyFile(It);
+
+		std::lock_guard<std::mutex> lock(_Mtx);
+		if (It.Error == 0) {
+			_CopiedSize+= It.SrcData.nFileSize;
+		} else {
+			_Failed.emplace_back(std::move(It));
+		}
+		ASSERT(_InFlight != 0);
+		--_InFlight;
+		_Cond.notify_all();
+	}
+
+public:
+	ShellCopySmallFiles(bool CopyAccessMode, bool CopyXAttr)
+		:
+		_CopyAccessMode(CopyAccessMode),
+		_CopyXAttr(CopyXAttr),
+		_InFlightLimit(BestThreadsCount() * 4)
+	{}
+
+	~ShellCopySmallFiles()
+	{
+		// not yet started files just not copied, but must wait for ones being copied
+		_Pool.Discard();
+		_Pool.Wait();
+	}
+
+	// returns false if too many files are being copied for a while, so caller should
+	// check cancellation and fetch results before trying to queue same file again
+	bool Queue(const wchar_t *SrcName, const FAR_FIND_DATA_EX &SrcData, const FARString &strDestName)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_Mtx);
+			if (_InFlight >= _InFlightLimit) {
+				_Cond.wait_for(lock, std::chrono::milliseconds(PROGRESS_REFRESH_THRESHOLD),
+						[this]() { return _InFlight < _InFlightLimit; });
+				if (_InFlight >= _InFlightLimit)
+					return false;
+			}
+			++_InFlight;
+		}
+
+		std::shared_ptr<Item> It = std::make_shared<Item>();
+		It->strSrcName = SrcName;
+		It->SrcData = SrcData;
+		It->strDestName = strDestName;
+		_Pool.Queue([this, It]() { Process(*It); });
+		return true;
+	}
+
+	// waits up to Msec for completion of all queued files, returns true if all completed
+	bool Wait(unsigned int Msec)
+	{
+		std::unique_lock<std::mutex> lock(_Mtx);
+		if (_InFlight != 0 && Msec != 0) {
+			_Cond.wait_for(lock, std::chrono::milliseconds(Msec), [this]() { return _InFlight == 0; });
+		}
+		return _InFlight == 0;
+	}
+
+	// gives total size of files copied since previous call and files that failed to be copied
+	void Fetch(uint64_t &CopiedSize, std::vector<Item> &Failed)
+	{
+		std::lock_guard<std::mutex> lock(_Mtx);
+		CopiedSize = _CopiedSize;
+		_CopiedSize = 0;
+		Failed.swap(_Failed);
+	}
+};
+
 ShellCopy::ShellCopy(Panel *SrcPanel,		// исходная панель (активная)
 		int Move,							// =1 - операция Move
 		int Link,							// =1 - Sym/Hard Link
@@ -1064,6 +1322,10 @@ ShellCopy::ShellCopy(Panel *SrcPanel,		// исходная панель (акт
 		Flags.SPARSEFILES = true;
 	if (Opt.CMOpt.UseCOW && Opt.CMOpt.SparseFiles == 0)
 		Flags.USECOW = true;
+	if (Opt.CMOpt.CopyReadAhead)
+		Flags.READAHEAD = true;
+	if (Opt.CMOpt.CopySmallFilesInParallel)
+		Flags.PARALLEL = true;
 
 	if (CDP.SelCount == 1)
 		AddSlash = false;	//???
@@ -1177,6 +1439,7 @@ ShellCopy::ShellCopy(Panel *SrcPanel,		// исходная панель (акт
 				preRedrawItem.Param.Param1 = CP;
 				PreRedraw.SetParam(preRedrawItem.Param);
 				int I = CopyFileTree(strNameTmp);
+				SmallFiles.reset();		// if cancelled - waits for files being copied in background
 				PreRedraw.Pop();
 				Flags.SYMLINK = OldFlagsSYMLINK;
 
@@ -1834,6 +2097,10 @@ COPY_CODES ShellCopy::CopyFileTree(const wchar_t *Dest)
 		}
 	}
 
+	// directories attributes must be applied after all files inside are written
+	if (CompleteSmallFiles(true) == COPY_CANCEL)
+		return COPY_CANCEL;
+
 	SetEnqueuedDirectoriesAttributes();
 
 	return COPY_SUCCESS;	// COPY_SUCCESS_MOVE???
@@ -2316,6 +2583,17 @@ COPY_CODES ShellCopy::ShellCopyOneFileNoRetry(const wchar_t *Src, const FAR_FIND
 				return (COPY_SUCCESS_MOVE);
 			}
 		} else {
+			if (!Append) {
+				const COPY_CODES SmallFileCode = ShellCopySmallFile(Src, SrcData, strDestPath);
+				if (SmallFileCode == COPY_SUCCESS) {
+					strCopiedName = PointToName(strDestPath);
+					TotalFiles++;
+					return COPY_SUCCESS;
+				}
+				if (SmallFileCode == COPY_CANCEL)
+					return COPY_CANCEL;
+			}
+
 			do {
 				CopyCode = ShellCopyFile(Src, SrcData, strDestPath, Append);
 			} while (CopyCode == COPY_RETRY);
@@ -2466,7 +2744,8 @@ static void ProgressUpdate(bool force, const FAR_FIND_DATA_EX &SrcData, const wc
 ShellFileTransfer::ShellFileTransfer(const wchar_t *SrcName, const FAR_FIND_DATA_EX &SrcData,
 		const FARString &strDestName, bool Append, ShellCopyBuffer &CopyBuffer, COPY_FLAGS &Flags)
 	:
-	_SrcName(SrcName), _strDestName(strDestName), _CopyBuffer(CopyBuffer), _Flags(Flags), _SrcData(SrcData)
+	_SrcName(SrcName), _strDestName(strDestName), _CopyBuffer(CopyBuffer), _Flags(Flags), _SrcData(SrcData),
+	_NextPiecePtr(CopyBuffer.Ptr)
 {
 	if (!_SrcFile.Open(SrcName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
 				OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN))
@@ -2533,6 +2812,8 @@ ShellFileTransfer::ShellFileTransfer(const wchar_t *SrcName, const FAR_FIND_DATA
 
 ShellFileTransfer::~ShellFileTransfer()
 {
+	_ReadAhead.reset();	// must stop using _SrcFile before closing it
+
 	if (!_Done)
 		try {
 			fprintf(stderr, "~ShellFileTransfer: discarding '%ls'\n", _strDestName.CPtr());
@@ -2603,6 +2884,7 @@ void ShellFileTransfer::Do()
 			TotalCopiedSize+= BytesWritten;
 	}
 
+	_ReadAhead.reset();
 	_SrcFile.Close();
 
 	if (!apiIsDevNull(_strDestName))	// avoid sudo prompt when copying to /dev/null
@@ -2694,11 +2976,9 @@ DWORD ShellFileTransfer::PieceCopy()
 		}
 #endif
 
-	DWORD BytesRead, BytesWritten;
-
-	while (!_SrcFile.Read(_CopyBuffer.Ptr, _CopyBuffer.Size, &BytesRead)) {
-		RetryCancel(Msg::CopyReadError, _SrcName);
-	}
+	char *Data;
+	DWORD BytesWritten;
+	const DWORD BytesRead = PieceRead(Data);
 
 	if (BytesRead == 0)
 		return BytesRead;
@@ -2710,10 +2990,10 @@ DWORD ShellFileTransfer::PieceCopy()
 	BytesWritten = 0;
 	if (_Flags.SPARSEFILES) {
 		while (BytesWritten < WriteSize) {
-			const unsigned char *Data = (const unsigned char *)_CopyBuffer.Ptr + BytesWritten;
+			const unsigned char *Piece = (const unsigned char *)Data + BytesWritten;
 			const std::pair<DWORD, DWORD> &NH =
-					LookupNextHole(Data, WriteSize - BytesWritten, CurCopiedSize + BytesWritten);
-			DWORD LeadingNonzeroesWritten = NH.first ? PieceWrite(Data, NH.first) : 0;
+					LookupNextHole(Piece, WriteSize - BytesWritten, CurCopiedSize + BytesWritten);
+			DWORD LeadingNonzeroesWritten = NH.first ? PieceWrite(Piece, NH.first) : 0;
 			BytesWritten+= LeadingNonzeroesWritten;
 			if (NH.second && LeadingNonzeroesWritten == NH.first) {
 				// fprintf(stderr, "!!! HOLE of size %x\n", SR.second);
@@ -2721,7 +3001,7 @@ DWORD ShellFileTransfer::PieceCopy()
 			}
 		}
 	} else
-		BytesWritten = PieceWrite(_CopyBuffer.Ptr, WriteSize);
+		BytesWritten = PieceWrite(Data, WriteSize);
 
 	if (BytesWritten > BytesRead) {
 		/*
@@ -2736,6 +3016,7 @@ DWORD ShellFileTransfer::PieceCopy()
 	}
 
 	if (BytesWritten < BytesRead) {		// if written less than read then need to rewind source file by difference
+		DiscardReadAhead();
 		if (!_SrcFile.SetPointer((INT64)BytesWritten - (INT64)BytesRead, nullptr, FILE_CURRENT))
 			throw ErrnoSaver();
 	}
@@ -2743,6 +3024,57 @@ DWORD ShellFileTransfer::PieceCopy()
 	return BytesWritten;
 }
 
+// reads next piece of source file and sets Data to buffer that contains it, if read-ahead
+// enabled then also starts reading of following piece into other buffer
+DWORD ShellFileTransfer::PieceRead(char *&Data)
+{
+	DWORD BytesRead = 0;
+	bool Done = false;
+	Data = _NextPiecePtr;
+
+	if (_ReadAhead && _ReadAhead->Pending()) {
+		Done = _ReadAhead->Wait(BytesRead);
+		if (!Done)	// retry same piece synchronously, failed read didn't move file pointer
+			RetryCancel(Msg::CopyReadError, _SrcName);
+	}
+
+	if (!Done) {
+		while (!_SrcFile.Read(Data, _CopyBuffer.Size, &BytesRead)) {
+			RetryCancel(Msg::CopyReadError, _SrcName);
+		}
+	}
+
+	if (BytesRead == 0 || !_Flags.READAHEAD)
+		return BytesRead;
+
+	if (!_ReadAhead && _SrcData.nFileSize - std::min(_SrcData.nFileSize, CurCopiedSize)
+				> (uint64_t)COPY_READAHEAD_MINIMAL) {
+		try {
+			_ReadAhead.reset(new ShellCopyReadAhead(_SrcFile));
+		} catch (std::exception &e) {
+			fprintf(stderr, "ShellCopyReadAhead: %s\n", e.what());
+			_Flags.READAHEAD = false;
+		}
+	}
+
+	if (_ReadAhead) {
+		_NextPiecePtr = (Data == _CopyBuffer.Ptr) ? _CopyBuffer.AheadPtr : _CopyBuffer.Ptr;
+		_ReadAhead->Start(_NextPiecePtr, _CopyBuffer.Size);
+	}
+
+	return BytesRead;
+}
+
+// waits for pending read-ahead and moves source file pointer back to where it was before it
+void ShellFileTransfer::DiscardReadAhead()
+{
+	DWORD BytesRead = 0;
+	if (_ReadAhead && _ReadAhead->Pending() && _ReadAhead->Wait(BytesRead) && BytesRead != 0) {
+		if (!_SrcFile.SetPointer(-(INT64)BytesRead, nullptr, FILE_CURRENT))
+			throw ErrnoSaver();
+	}
+}
+
 DWORD ShellFileTransfer::PieceWriteHole(DWORD Size)
 {
 	while (!_DestFile.SetPointer(Size, nullptr, FILE_CURRENT)) {
@@ -2813,6 +3145,95 @@ int ShellCopy::ShellCopyFile(const wchar_t *SrcName, const FAR_FIND_DATA_EX &Src
 	return CP->Cancelled() ? COPY_CANCEL : COPY_FAILURE;
 }
 
+/*
+	Queues file to be copied in background if its small and no special handling needed.
+	Returns COPY_SUCCESS if file was queued, COPY_FAILURE if it must be copied usual way
+	and COPY_CANCEL if operation was cancelled meanwhile.
+*/
+COPY_CODES ShellCopy::ShellCopySmallFile(const wchar_t *SrcName, const FAR_FIND_DATA_EX &SrcData,
+		const FARString &strDestName)
+{
+	if (!Flags.PARALLEL || SmallFilesFallback || Flags.MOVE || Flags.LINK || Flags.USECOW
+			|| Flags.SPARSEFILES || Flags.WRITETHROUGH || SrcData.nFileSize > COPY_READAHEAD_MINIMAL
+			|| (SrcData.dwFileAttributes & (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_REPARSE_POINT)) != 0
+			|| !S_ISREG(SrcData.dwUnixMode) || apiIsDevNull(strDestName))
+		return COPY_FAILURE;
+
+	if (!SmallFiles)
+		SmallFiles.reset(new ShellCopySmallFiles(Flags.COPYACCESSMODE, Flags.COPYXATTR));
+
+	while (!SmallFiles->Queue(SrcName, SrcData, strDestName)) {
+		if (CompleteSmallFiles(false) == COPY_CANCEL)
+			return COPY_CANCEL;
+	}
+
+	return CompleteSmallFiles(false);
+}
+
+/*
+	Accounts files copied in background into total progress and copies again usual way
+	ones that failed to be copied in background. If WaitAll then returns only after
+	all queued files processed. Returns COPY_SUCCESS or COPY_CANCEL.
+*/
+COPY_CODES ShellCopy::CompleteSmallFiles(bool WaitAll)
+{
+	if (!SmallFiles)
+		return COPY_SUCCESS;
+
+	std::vector<ShellCopySmallFiles::Item> Failed;
+	for (;;) {
+		const bool AllDone = SmallFiles->Wait(WaitAll ? PROGRESS_REFRESH_THRESHOLD : 0);
+		uint64_t CopiedSize = 0;
+		SmallFiles->Fetch(CopiedSize, Failed);
+
+		if (ShowTotalCopySize) {
+			TotalCopiedSize+= CopiedSize;
+			if (GetProcessUptimeMSec() - ProgressUpdateTime >= PROGRESS_REFRESH_THRESHOLD) {
+				CP->SetTotalProgressValue(TotalCopiedSize, TotalCopySize);
+				ProgressUpdateTime = GetProcessUptimeMSec();
+			}
+		}
+
+		for (auto &It : Failed) {
+			fprintf(stderr, "%s: error %d for '%ls'\n", __FUNCTION__, It.Error, It.strDestName.CPtr());
+			if (ErrnoSaver(It.Error).IsAccessDenied()) {
+				Flags.PARALLEL = false;	// likely elevation needed, that works only in main thread
+			}
+
+			TotalFiles--;
+			// overwriting of existing file already confirmed when file was queued
+			const bool SaveOverwriteNext = Flags.OVERWRITENEXT;
+			Flags.OVERWRITENEXT = true;
+			SmallFilesFallback = true;
+			const COPY_CODES CopyCode = ShellCopyOneFile(It.strSrcName, It.SrcData, It.strDestName, 0, 0);
+			SmallFilesFallback = false;
+			Flags.OVERWRITENEXT = SaveOverwriteNext;
+
+			if (CopyCode == COPY_CANCEL) {
+				SmallFiles.reset();
+				return COPY_CANCEL;
+			}
+
+			if (CopyCode != COPY_SUCCESS) {
+				TotalCopiedSize = TotalCopiedSize - CurCopiedSize + It.SrcData.nFileSize;
+				if (CopyCode == COPY_NEXT)
+					TotalSkippedSize = TotalSkippedSize + It.SrcData.nFileSize - CurCopiedSize;
+			}
+		}
+		Failed.clear();
+
+		if (CP->Cancelled()) {
+			SmallFiles.reset();
+			return COPY_CANCEL;
+		}
+
+		if (!WaitAll || AllDone)
+			break;
+	}
+
+	return COPY_SUCCESS;
+}
+
 void ShellCopy::SetDestDizPath(const wchar_t *DestPath)
 {
 	if (!Flags.DIZREAD) {
@@ -76,6 +76,8 @@ struct COPY_FLAGS
 	bool COPYXATTR      : 1;		// copy extended attributes
 	bool SPARSEFILES    : 1;		// allow producing sparse files
 	bool USECOW         : 1;		// enable COW functionality if FS supports it
+	bool READAHEAD      : 1;		// read next piece of file in background while writing current one
+	bool PARALLEL       : 1;		// copy small files by several threads
 	bool COPYLASTTIME   : 1;		// При копировании в несколько каталогов устанавливается для последнего.
 	bool UPDATEPPANEL   : 1;		// необходимо обновить пассивную панель
 	COPY_SYMLINK SYMLINK : 2;
@@ -106,8 +108,12 @@ private:
 
 public:
 	char *const Ptr;
+	char *const AheadPtr;	// same capacity as Ptr, used to read next piece while current one being written
 };
 
+class ShellCopyReadAhead;
+class ShellCopySmallFiles;
+
 class ShellFileTransfer
 {
 	const wchar_t *_SrcName;
@@ -122,6 +128,8 @@ class ShellFileTransfer
 	DWORD _ModeToCreateWith = 0;
 
 	File _SrcFile, _DestFile;
+	std::unique_ptr<ShellCopyReadAhead> _ReadAhead;
+	char *_NextPiecePtr;
 	bool _LastWriteWasHole = false;
 	bool _Done             = false;
 	std::unique_ptr<ShellCopyFileExtendedAttributes> _XAttrCopyPtr;
@@ -130,6 +138,8 @@ class ShellFileTransfer
 	void RetryCancel(const wchar_t *Text, const wchar_t *Object);
 	DWORD PieceWrite(const void *Data, DWORD Size);
 	DWORD PieceWriteHole(DWORD Size);
+	DWORD PieceRead(char *&Data);
+	void DiscardReadAhead();
 	DWORD PieceCopy();
 
 public:
@@ -162,6 +172,8 @@ class ShellCopy
 	// в остальных случаях - RP_EXACTCOPY - как у источника
 	ReparsePointTypes RPT;
 	ShellCopyBuffer CopyBuffer;
+	std::unique_ptr<ShellCopySmallFiles> SmallFiles;
+	bool SmallFilesFallback = false;
 
 	std::vector<FARString> SelectedPanelItems;
 	struct CopiedDirectory
@@ -187,6 +199,10 @@ class ShellCopy
 	int ShellCopyFile(const wchar_t *SrcName, const FAR_FIND_DATA_EX &SrcData, FARString &strDestName,
 			int Append);
 
+	COPY_CODES ShellCopySmallFile(const wchar_t *SrcName, const FAR_FIND_DATA_EX &SrcData,
+			const FARString &strDestName);
+	COPY_CODES CompleteSmallFiles(bool WaitAll);
+
 	int DeleteAfterMove(const wchar_t *Name, DWORD Attr);
 	void SetDestDizPath(const wchar_t *DestPath);
 	int AskOverwrite(const FAR_FIND_DATA_EX &SrcData, const wchar_t *SrcName, const wchar_t *DestName,
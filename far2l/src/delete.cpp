@@ -61,7 +61,11 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "execute.hpp"
 
 #include <RandomString.h>
+#include <WorkStealingPool.h>
+#include <atomic>
 #include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
 
 enum DeletionResult
 {
@@ -132,6 +136,135 @@ public:
 	}
 };
 
+/*
+	Removes contents of directories tree by several threads, sibling subdirectories
+	processed in parallel. Entries are addressed relatively to descriptors of their
+	directories (openat/unlinkat), so paths are not resolved again and again from root.
+	It never interacts with UI: anything that failed to be removed (permissions, need
+	of elevation etc) just remains in place, so usual sequential deletion processes
+	leftovers after it, with all its prompts and retries. Root directory itself is
+	never removed by it.
+	If AskReadOnly then entries that sequential deletion would ask about as read-only
+	(not writable by owner themselves or within such directory) are also left for it.
+*/
+class ParallelTreeRemover
+{
+	struct Dir
+	{
+		std::shared_ptr<Dir> Parent;
+		std::string Name;
+		int FD = -1;
+		bool Writable = true;
+		std::atomic<int> Pending{1};	// own scanning + subdirectories not yet finished
+
+		~Dir()
+		{
+			if (FD != -1)
+				close(FD);
+		}
+	};
+
+	std::atomic<unsigned long> _Removed{0};
+	std::atomic<bool> _Cancelled{false};
+	const bool _AskReadOnly;
+	WorkStealingPool _Pool;
+
+	// same check as apiMakeWritable does, that follows symlinks too
+	bool IsWritable(int DirFD, const char *Name) const
+	{
+		struct stat s{};
+		return !_AskReadOnly || fstatat(DirFD, Name, &s, 0) != 0 || (s.st_mode & S_IWUSR) != 0;
+	}
+
+	void ScanDir(const std::shared_ptr<Dir> &D)
+	{
+		if (D->FD == -1 && D->Parent) {
+			D->FD = openat(D->Parent->FD, D->Name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		}
+
+		if (D->FD != -1 && _AskReadOnly) {
+			struct stat s{};
+			D->Writable = (fstat(D->FD, &s) != 0 || (s.st_mode & S_IWUSR) != 0);
+		}
+
+		const int DirFD = (D->FD != -1 && !_Cancelled) ? dup(D->FD) : -1;
+		DIR *DirStream = (DirFD != -1) ? fdopendir(DirFD) : nullptr;
+		if (DirStream) {
+			while (!_Cancelled) {
+				const struct dirent *de = readdir(DirStream);
+				if (!de)
+					break;
+
+				if (de->d_name[0] == '.' && (!de->d_name[1] || (de->d_name[1] == '.' && !de->d_name[2])))
+					continue;
+
+				bool IsDir = (de->d_type == DT_DIR);
+				if (de->d_type == DT_UNKNOWN) {
+					struct stat s{};
+					IsDir = (fstatat(D->FD, de->d_name, &s, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(s.st_mode));
+				}
+
+				if (IsDir) {
+					std::shared_ptr<Dir> Sub = std::make_shared<Dir>();
+					Sub->Parent = D;
+					Sub->Name = de->d_name;
+					++D->Pending;
+					_Pool.Queue([this, Sub]() { ScanDir(Sub); });
+
+				} else if (D->Writable && IsWritable(D->FD, de->d_name) && unlinkat(D->FD, de->d_name, 0) == 0) {
+					++_Removed;
+				}
+			}
+			closedir(DirStream);
+
+		} else if (DirFD != -1) {
+			close(DirFD);
+		}
+
+		DirDone(D);
+	}
+
+	// removes directory once it has no more pending subdirectories, then same for its parent
+	void DirDone(std::shared_ptr<Dir> D)
+	{
+		while (D && --D->Pending == 0) {
+			std::shared_ptr<Dir> Parent = D->Parent;
+			if (Parent && !_Cancelled && Parent->Writable && D->Writable
+					&& unlinkat(Parent->FD, D->Name.c_str(), AT_REMOVEDIR) == 0) {
+				++_Removed;
+			}
+			D = Parent;
+		}
+	}
+
+public:
+	ParallelTreeRemover(const std::string &Root, bool AskReadOnly)
+		:
+		_AskReadOnly(AskReadOnly)
+	{
+		std::shared_ptr<Dir> D = std::make_shared<Dir>();
+		D->FD = open(Root.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		if (D->FD != -1) {
+			_Pool.Queue([this, D]() { ScanDir(D); });
+		}
+	}
+
+	~ParallelTreeRemover()
+	{
+		_Cancelled = true;
+		_Pool.Wait();
+	}
+
+	// waits up to Msec for completion, returns true if everything completed
+	bool Wait(unsigned int Msec) { return _Pool.Wait(Msec); }
+
+	// stops removal, not yet scanned directories remain untouched
+	void Cancel() { _Cancelled = true; }
+
+	// gives count of entries removed since previous call
+	unsigned long FetchRemovedCount() { return _Removed.exchange(0); }
+};
+
 static FARString PanelItemFullName(Panel *SrcPanel, const FARString &strSelName)
 {
 	if (IsAbsolutePath(strSelName))
@@ -169,6 +302,25 @@ static DeletionResult ShellConfirmDirectoryDeletion(const FARString &strFullName
 	return DELETE_YES;
 }
 
+static bool ShellDeleteTreeInParallel(const FARString &strFullName, ShellDeleteMsgState &SDMS, ULONG ItemsCount)
+{
+	// unless user already agreed to delete all read-only entries, leave them for prompting
+	ParallelTreeRemover PTR(strFullName.GetMB(), Opt.Confirm.RO && ReadOnlyDeleteMode != 1);
+	for (;;) {
+		const bool Done = PTR.Wait(RedrawTimeout);
+		ProcessedItems+= PTR.FetchRemovedCount();
+		if (!SDMS.Update(strFullName, false, ProcessedItems, ItemsCount)) {
+			PTR.Cancel();
+			return false;
+		}
+		if (Done)
+			break;
+	}
+
+	TreeList::DelTreeName(strFullName);
+	return true;
+}
+
 static DeletionResult ShellDeleteDirectory(int ItemsCount, bool UpdateDiz, Panel *SrcPanel,
 		FARString strSelName, DWORD FileAttr, bool Wipe, int Opt_DeleteToRecycleBin)
 {
@@ -189,6 +341,12 @@ static DeletionResult ShellDeleteDirectory(int ItemsCount, bool UpdateDiz, Panel
 		ScanTree ScTree(TRUE, TRUE, FALSE);
 		FARString strSelFullName = PanelItemFullName(SrcPanel, strSelName);
 
+		// per-directory confirmations and wiping require sequential processing,
+		// otherwise let threads remove what they can and then process leftovers
+		if (!Wipe && DeleteAllFolders && Opt.DelOpt.DelInParallel
+				&& !ShellDeleteTreeInParallel(strSelFullName, SDMS, ItemsCount))
+			return DELETE_CANCEL;
+
 		ScTree.SetFindPath(strSelFullName, L"*", 0);
 		FAR_FIND_DATA_EX FindData;
 		FARString strFullName;
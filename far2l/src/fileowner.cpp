@@ -40,6 +40,12 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <pwd.h>
 #include <grp.h>
 
+FARStringPool &OwnersNamesPool()
+{
+	static FARStringPool s_pool;
+	return s_pool;
+}
+
 const char *OwnerNameByID(uid_t id)
 {
 	struct passwd *pw = getpwuid(id);
@@ -34,6 +34,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <map>
+#include "FARStringPool.hpp"
+
+// pool that keeps names of owners and groups, so files of same owner share single content
+FARStringPool &OwnersNamesPool();
 
 template <class ID, const char *(*UNCACHED_LOOKUP)(ID)>
 class CachedFileLookupT
@@ -51,7 +55,8 @@ public:
 			if (!uncached_value) {
 				uncached_value = "";
 			}
-			cache_it = _cache.insert(cache_it, std::make_pair(id, FARString(uncached_value)));
+			cache_it = _cache.insert(cache_it,
+				std::make_pair(id, OwnersNamesPool().Intern(FARString(uncached_value))));
 		}
 
 		return cache_it->second;
@@ -515,9 +515,25 @@ void FileViewer::ShowStatus()
 	if (NameLength < 20)
 		NameLength = 20;
 
+	FARString strLine;
+	int64_t Line;
+	if (View.GetCurrentLine(Line)) {
+		if (Line >= 0)
+			strLine.Format(L" %ls %-10lld", Msg::EditStatusLine.CPtr(), Line + 1);
+		else	// still counting lines
+			strLine.Format(L" %ls %-10ls", Msg::EditStatusLine.CPtr(), L"?");
+		NameLength = Max(NameLength - (int)strLine.GetLength(), 20);
+	}
+	if (View.GetFollowMode()) {
+		FARString strFollow;
+		strFollow.Format(L" [%ls]", Msg::ViewerFollow.CPtr());
+		NameLength = Max(NameLength - (int)strFollow.GetLength(), 20);
+		strLine.Insert(0, strFollow.CPtr(), strFollow.GetLength());
+	}
+
 	TruncPathStr(strName, NameLength);
-	strStatus.Format(L"%-*ls %5u %13llu %7.7ls %-4lld %ls%3d%%", NameLength, strName.CPtr(), View.VM.CodePage,
-			View.FileSize, Msg::ViewerStatusCol.CPtr(), View.LeftPos, Opt.ViewerEditorClock ? L"" : L" ",
+	strStatus.Format(L"%-*ls%ls %5u %13llu %7.7ls %-4lld %ls%3d%%", NameLength, strName.CPtr(), strLine.CPtr(),
+			View.VM.CodePage, View.FileSize, Msg::ViewerStatusCol.CPtr(), View.LeftPos, Opt.ViewerEditorClock ? L"" : L" ",
 			(View.LastPage ? 100 : ToPercent64(View.FilePos, View.FileSize)));
 	SetColor(COL_VIEWERSTATUS);
 	GotoXY(X1, Y1);
@@ -1092,8 +1092,8 @@ struct ScanFileWorkItem : IThreadedWorkItem
 			AddMenuRecord(_hDlg, _FileToReport, _FindData, _ArcIndex);
 	}
 
-	// invoked within worker thread, so make sure no FARString copied within this function
-	// as it has not thread-safe (but fast!) reference counters implementation
+	// invoked within worker thread, so make sure that FARStrings shared with main
+	// thread are not modified here, copying them is fine however
 	virtual void FN_NOINLINE WorkProc()
 	{
 		SudoClientRegion scr;
@@ -2091,6 +2091,7 @@ static void DoScanTree(HANDLE hDlg, FARString &strRoot)
 {
 	ScanTree ScTree(FALSE, !(SearchMode == FINDAREA_CURRENT_ONLY || SearchMode == FINDAREA_INPATH),
 			Opt.FindOpt.FindSymLinks);
+	ScTree.SetParallel((unsigned int)std::max(Opt.FindOpt.ScanThreads, 0));
 	FARString strSelName;
 	DWORD FileAttr;
 
@@ -86,12 +86,6 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 extern PanelViewSettings ViewSettingsArray[];
 extern size_t SizeViewSettingsArray;
 
-static int _cdecl SortList(const void *el1, const void *el2);
-
-static int ListSortMode, ListSortOrder, ListSortGroups, ListSelectedFirst, ListDirectoriesFirst;
-static int ListPanelMode, ListNumericSort, ListCaseSensitiveSort;
-static HANDLE hSortPlugin;
-
 #define SYMLINKS_BACKLOG_LIMIT 128	// hardcoded for now, until smbd will want to change this..
 
 enum SELECT_MODES
@@ -241,293 +235,6 @@ void FileList::CorrectPosition()
 		CurTopFile = CurFile - Columns * Height + 1;
 }
 
-void FileList::SortFileList(int KeepPosition)
-{
-	if (ListData.Count() > 1) {
-		FARString strCurName;
-
-		if (SortMode == BY_DIZ)
-			ReadDiz();
-
-		ListSortMode = SortMode;
-		ListSortOrder = SortOrder;
-		ListSortGroups = SortGroups;
-		ListSelectedFirst = SelectedFirst;
-		ListDirectoriesFirst = DirectoriesFirst;
-		ListPanelMode = PanelMode;
-		ListNumericSort = NumericSort;
-		ListCaseSensitiveSort = CaseSensitiveSort;
-
-		if (KeepPosition) {
-			ASSERT(CurFile < ListData.Count());
-			strCurName = ListData[CurFile]->strName;
-		}
-
-		hSortPlugin = (PanelMode == PLUGIN_PANEL && hPlugin
-							&& reinterpret_cast<PluginHandle *>(hPlugin)->pPlugin->HasCompare())
-				? hPlugin
-				: nullptr;
-
-		for (auto &Item : ListData) {
-			const auto NamePtr = PointToName(Item->strName);
-			Item->FileNamePos =
-					(unsigned short)std::min(size_t(NamePtr - Item->strName.CPtr()), (size_t)0xffff);
-			Item->FileExtPos =
-					(unsigned short)std::min(size_t(PointToExt(NamePtr) - NamePtr), (size_t)0xffff);
-		}
-		qsort(ListData.Data(), ListData.Count(), sizeof(*ListData.Data()), SortList);
-
-		if (KeepPosition)
-			GoToFile(strCurName);
-	}
-}
-
-int _cdecl SortList(const void *el1, const void *el2)
-{
-	int RetCode;
-	int64_t RetCode64;
-	FileListItem *SPtr1 = ((FileListItem **)el1)[0];
-	FileListItem *SPtr2 = ((FileListItem **)el2)[0];
-
-	if (SPtr1->strName.GetLength() == 2 && SPtr1->strName.At(0) == L'.' && SPtr1->strName.At(1) == L'.')
-		return -1;
-
-	if (SPtr2->strName.GetLength() == 2 && SPtr2->strName.At(0) == L'.' && SPtr2->strName.At(1) == L'.')
-		return 1;
-
-	if (ListSortMode == UNSORTED) {
-		if (ListSelectedFirst && SPtr1->Selected != SPtr2->Selected)
-			return SPtr1->Selected > SPtr2->Selected ? -1 : 1;
-
-		return (SPtr1->Position > SPtr2->Position) ? ListSortOrder : -ListSortOrder;
-	}
-
-	if (ListDirectoriesFirst) {
-		if ((SPtr1->FileAttr & FILE_ATTRIBUTE_DIRECTORY) < (SPtr2->FileAttr & FILE_ATTRIBUTE_DIRECTORY))
-			return 1;
-
-		if ((SPtr1->FileAttr & FILE_ATTRIBUTE_DIRECTORY) > (SPtr2->FileAttr & FILE_ATTRIBUTE_DIRECTORY))
-			return -1;
-	}
-
-	if (ListSelectedFirst && SPtr1->Selected != SPtr2->Selected)
-		return SPtr1->Selected > SPtr2->Selected ? -1 : 1;
-
-	if (ListSortGroups && (ListSortMode == BY_NAME || ListSortMode == BY_EXT || ListSortMode == BY_FULLNAME)
-			&& SPtr1->SortGroup != SPtr2->SortGroup)
-		return SPtr1->SortGroup < SPtr2->SortGroup ? -1 : 1;
-
-	if (hSortPlugin) {
-		DWORD SaveFlags1, SaveFlags2;
-		SaveFlags1 = SPtr1->UserFlags;
-		SaveFlags2 = SPtr2->UserFlags;
-		SPtr1->UserFlags = SPtr2->UserFlags = 0;
-		PluginPanelItem pi1, pi2;
-		FileList::FileListToPluginItem(SPtr1, &pi1);
-		FileList::FileListToPluginItem(SPtr2, &pi2);
-		SPtr1->UserFlags = SaveFlags1;
-		SPtr2->UserFlags = SaveFlags2;
-		int RetCode =
-				CtrlObject->Plugins.Compare(hSortPlugin, &pi1, &pi2, ListSortMode + (SM_UNSORTED - UNSORTED));
-		FileList::FreePluginPanelItem(&pi1);
-		FileList::FreePluginPanelItem(&pi2);
-
-		if (RetCode != -2)
-			return RetCode * ListSortOrder;
-	}
-
-	const wchar_t *Name1 = UNLIKELY(SPtr1->FileNamePos == 0xffff)
-			? PointToName(SPtr1->strName.CPtr() + 0xfffe, SPtr1->strName.CEnd())
-			: SPtr1->strName.CPtr() + SPtr1->FileNamePos;
-	const wchar_t *Name2 = UNLIKELY(SPtr2->FileNamePos == 0xffff)
-			? PointToName(SPtr2->strName.CPtr() + 0xfffe, SPtr2->strName.CEnd())
-			: SPtr2->strName.CPtr() + SPtr2->FileNamePos;
-
-	const wchar_t *Ext1 =
-			UNLIKELY(SPtr1->FileExtPos == 0xffff) ? PointToExt(Name1 + 0xfffe) : Name1 + SPtr1->FileExtPos;
-	const wchar_t *Ext2 =
-			UNLIKELY(SPtr2->FileExtPos == 0xffff) ? PointToExt(Name2 + 0xfffe) : Name2 + SPtr2->FileExtPos;
-
-	// НЕ СОРТИРУЕМ КАТАЛОГИ В РЕЖИМЕ "ПО РАСШИРЕНИЮ" (Опционально!)
-	if (!(ListSortMode == BY_EXT && !Opt.SortFolderExt
-				&& ((SPtr1->FileAttr & FILE_ATTRIBUTE_DIRECTORY)
-						&& (SPtr2->FileAttr & FILE_ATTRIBUTE_DIRECTORY)))) {
-		switch (ListSortMode) {
-			case BY_NAME:
-				break;
-
-			case BY_EXT:
-				if (!*Ext1 && !*Ext2)
-					break;
-
-				if (!*Ext1)
-					return -ListSortOrder;
-
-				if (!*Ext2)
-					return ListSortOrder;
-
-				if (ListNumericSort) {
-					RetCode = (ListCaseSensitiveSort ? NumStrCmp(Ext1 + 1, Ext2 + 1)
-													: NumStrCmpI(Ext1 + 1, Ext2 + 1));
-				} else {
-					RetCode = (ListCaseSensitiveSort ? StrCmp(Ext1 + 1, Ext2 + 1)
-													: StrCmpI(Ext1 + 1, Ext2 + 1));
-				}
-
-				if (RetCode)
-					return RetCode * ListSortOrder;
-				break;
-
-			case BY_MTIME:
-				if (!(RetCode64 = FileTimeDifference(&SPtr1->WriteTime, &SPtr2->WriteTime)))
-					break;
-
-				return (RetCode64 < 0) ? ListSortOrder : -ListSortOrder;
-
-			case BY_CTIME:
-				if (!(RetCode64 = FileTimeDifference(&SPtr1->CreationTime, &SPtr2->CreationTime)))
-					break;
-
-				return (RetCode64 < 0) ? ListSortOrder : -ListSortOrder;
-
-			case BY_ATIME:
-				if (!(RetCode64 = FileTimeDifference(&SPtr1->AccessTime, &SPtr2->AccessTime)))
-					break;
-
-				return (RetCode64 < 0) ? ListSortOrder : -ListSortOrder;
-
-			case BY_CHTIME:
-				if (!(RetCode64 = FileTimeDifference(&SPtr1->ChangeTime, &SPtr2->ChangeTime)))
-					break;
-
-				return (RetCode64 < 0) ? ListSortOrder : -ListSortOrder;
-
-			case BY_SIZE:
-				if (SPtr1->FileSize == SPtr2->FileSize)
-					break;
-
-				return ((SPtr1->FileSize > SPtr2->FileSize) ? -ListSortOrder : ListSortOrder);
-
-			case BY_DIZ:
-				if (!SPtr1->DizText) {
-					if (!SPtr2->DizText)
-						break;
-					else
-						return ListSortOrder;
-				}
-
-				if (!SPtr2->DizText)
-					return -ListSortOrder;
-
-				if (ListNumericSort) {
-					RetCode = (ListCaseSensitiveSort ? NumStrCmp(SPtr1->DizText, SPtr2->DizText)
-													: NumStrCmpI(SPtr1->DizText, SPtr2->DizText));
-				} else {
-					RetCode = (ListCaseSensitiveSort ? StrCmp(SPtr1->DizText, SPtr2->DizText)
-													: StrCmpI(SPtr1->DizText, SPtr2->DizText));
-				}
-
-				if (RetCode)
-					return RetCode * ListSortOrder;
-				break;
-
-			case BY_OWNER:
-				RetCode = StrCmpI(SPtr1->strOwner, SPtr2->strOwner);
-				if (RetCode)
-					return RetCode * ListSortOrder;
-				break;
-
-			case BY_PHYSICALSIZE:
-				return (SPtr1->PhysicalSize > SPtr2->PhysicalSize) ? -ListSortOrder : ListSortOrder;
-
-			case BY_NUMLINKS:
-				if (SPtr1->NumberOfLinks == SPtr2->NumberOfLinks)
-					break;
-
-				return (SPtr1->NumberOfLinks > SPtr2->NumberOfLinks) ? -ListSortOrder : ListSortOrder;
-
-			case BY_FULLNAME: {
-				int NameCmp;
-				if (ListNumericSort) {
-					const wchar_t *Path1 = SPtr1->strName.CPtr();
-					const wchar_t *Path2 = SPtr2->strName.CPtr();
-					NameCmp = ListCaseSensitiveSort
-							? StrCmpNN(Path1, static_cast<int>(Name1 - Path1), Path2,
-									static_cast<int>(Name2 - Path2))
-							: StrCmpNNI(Path1, static_cast<int>(Name1 - Path1), Path2,
-									static_cast<int>(Name2 - Path2));
-					if (!NameCmp)
-						NameCmp = ListCaseSensitiveSort ? NumStrCmp(Name1, Name2) : NumStrCmpI(Name1, Name2);
-					else
-						NameCmp = ListCaseSensitiveSort ? StrCmp(Path1, Path2) : StrCmpI(Path1, Path2);
-				} else {
-					NameCmp = ListCaseSensitiveSort
-							? StrCmp(SPtr1->strName, SPtr2->strName)
-							: StrCmpI(SPtr1->strName, SPtr2->strName);
-				}
-
-				if (!NameCmp)
-					NameCmp = SPtr1->Position > SPtr2->Position ? 1 : -1;
-				return NameCmp * ListSortOrder;
-			}
-
-			case BY_CUSTOMDATA:
-				if (SPtr1->strCustomData.IsEmpty()) {
-					if (SPtr2->strCustomData.IsEmpty())
-						break;
-					else
-						return ListSortOrder;
-				}
-
-				if (SPtr2->strCustomData.IsEmpty())
-					return -ListSortOrder;
-
-				if (ListNumericSort) {
-					RetCode = (ListCaseSensitiveSort ? NumStrCmp(SPtr1->strCustomData, SPtr2->strCustomData)
-													: NumStrCmpI(SPtr1->strCustomData, SPtr2->strCustomData));
-				} else {
-					RetCode = (ListCaseSensitiveSort ? StrCmp(SPtr1->strCustomData, SPtr2->strCustomData)
-													: StrCmpI(SPtr1->strCustomData, SPtr2->strCustomData));
-				}
-
-				if (RetCode)
-					return ListSortOrder * RetCode;
-				break;
-		}
-	}
-
-	int NameCmp = 0;
-
-	if (!Opt.SortFolderExt && (SPtr1->FileAttr & FILE_ATTRIBUTE_DIRECTORY)) {
-		Ext1 = SPtr1->strName.CEnd();
-	}
-
-	if (!Opt.SortFolderExt && (SPtr2->FileAttr & FILE_ATTRIBUTE_DIRECTORY)) {
-		Ext2 = SPtr2->strName.CEnd();
-	}
-
-	if (ListNumericSort)
-		NameCmp = ListCaseSensitiveSort
-				? NumStrCmpN(Name1, static_cast<int>(Ext1 - Name1), Name2, static_cast<int>(Ext2 - Name2))
-				: NumStrCmpNI(Name1, static_cast<int>(Ext1 - Name1), Name2, static_cast<int>(Ext2 - Name2));
-	else
-		NameCmp = ListCaseSensitiveSort
-				? StrCmpNN(Name1, static_cast<int>(Ext1 - Name1), Name2, static_cast<int>(Ext2 - Name2))
-				: StrCmpNNI(Name1, static_cast<int>(Ext1 - Name1), Name2, static_cast<int>(Ext2 - Name2));
-
-	if (!NameCmp) {
-		if (ListNumericSort)
-			NameCmp = ListCaseSensitiveSort ? NumStrCmp(Ext1, Ext2) : NumStrCmpI(Ext1, Ext2);
-		else
-			NameCmp = ListCaseSensitiveSort ? StrCmp(Ext1, Ext2) : StrCmpI(Ext1, Ext2);
-	}
-
-	if (!NameCmp)
-		NameCmp = (SPtr1->Position > SPtr2->Position) ? 1 : -1;
-
-	return NameCmp * ListSortOrder;
-}
-
 void FileList::SetFocus()
 {
 	Panel::SetFocus();
@@ -88,11 +88,6 @@ struct FileListItem
 	bool PrevSelected{};
 	bool DeleteDiz{};
 	uint8_t ShowFolderSize{};
-
-	/// temporary values used to optimize sorting, they fit into
-	/// 8-bytes alignment gap so there is no memory waisted
-	unsigned short FileNamePos{};	// offset from beginning of StrName
-	unsigned short FileExtPos{};	// offset from FileNamePos
 };
 
 template <class T>
@@ -124,6 +119,9 @@ struct ListDataVec : StdVecWrap<FileListItem *>
 
 	FileListItem *Add();
 
+	// removes null pointers left in place of deleted items, keeping order of others
+	void Compact();
+
 	// занести предопределенные данные для каталога ".."
 	FileListItem *AddParentPoint();
 	FileListItem *AddParentPoint(const FILETIME *Times, FARString Owner, FARString Group);
@@ -241,6 +239,7 @@ private:
 		IgnoreVisible - обновить, даже если панель невидима
 	*/
 	void ReadFileNames(int KeepSelection, int IgnoreVisible, int DrawMessage, int CanBeAnnoying);
+	bool ReadChangedFileNames();
 	void UpdatePlugin(int KeepSelection, int IgnoreVisible);
 
 	void MoveSelection(ListDataVec &NewList, ListDataVec &OldList);
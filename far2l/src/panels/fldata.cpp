@@ -1,4 +1,5 @@
 #include <limits>
+#include <algorithm>
 #include "headers.hpp"
 #include "filelist.hpp"
 
@@ -41,6 +42,11 @@ FileListItem *ListDataVec::Add()
 	return item;
 }
 
+void ListDataVec::Compact()
+{
+	erase(std::remove(begin(), end(), nullptr), end());
+}
+
 FileListItem *ListDataVec::AddParentPoint()
 {
 	FileListItem *item = Add();
@@ -0,0 +1,332 @@
+#include "headers.hpp"
+
+#include "filelist.hpp"
+#include "ctrlobj.hpp"
+#include "config.hpp"
+#include "datetime.hpp"
+#include "pathmix.hpp"
+#include "ParallelSort.h"
+
+namespace
+{
+	/// Per-item data needed for comparison, extracted once before sorting so comparisons
+	/// don't need to reevaluate it and mostly operate on compact contiguous memory.
+	struct SortKey
+	{
+		FileListItem *Item;
+		const wchar_t *Name;	// name part of Item->strName
+		const wchar_t *Ext;	// extension of Name, including dot, or its end if no extension
+		const wchar_t *NameEnd;	// where Name ends for name comparison - either Ext or end of Name
+		uint64_t Value;	// sort mode specific: time, size, links count
+		unsigned int Position;
+		int SortGroup;
+		bool Parent;
+		bool Directory;
+		bool Selected;
+	};
+
+	class FileListSorter
+	{
+		int SortMode;
+		int SortOrder;
+		bool SortGroups;
+		bool SelectedFirst;
+		bool DirectoriesFirst;
+		bool NumericSort;
+		bool CaseSensitiveSort;
+		HANDLE hSortPlugin;
+
+		inline int CompareStrings(const wchar_t *Str1, const wchar_t *Str2) const
+		{
+			if (NumericSort)
+				return CaseSensitiveSort ? NumStrCmp(Str1, Str2) : NumStrCmpI(Str1, Str2);
+
+			return CaseSensitiveSort ? StrCmp(Str1, Str2) : StrCmpI(Str1, Str2);
+		}
+
+		inline int CompareValues(uint64_t Value1, uint64_t Value2) const
+		{
+			if (Value1 == Value2)
+				return 0;
+
+			return (Value1 < Value2) ? SortOrder : -SortOrder;
+		}
+
+		inline int ComparePositions(const SortKey &Key1, const SortKey &Key2) const
+		{
+			if (Key1.Position == Key2.Position)
+				return 0;
+
+			return (Key1.Position > Key2.Position) ? SortOrder : -SortOrder;
+		}
+
+		int ComparePlugin(FileListItem *SPtr1, FileListItem *SPtr2) const
+		{
+			DWORD SaveFlags1, SaveFlags2;
+			SaveFlags1 = SPtr1->UserFlags;
+			SaveFlags2 = SPtr2->UserFlags;
+			SPtr1->UserFlags = SPtr2->UserFlags = 0;
+			PluginPanelItem pi1, pi2;
+			FileList::FileListToPluginItem(SPtr1, &pi1);
+			FileList::FileListToPluginItem(SPtr2, &pi2);
+			SPtr1->UserFlags = SaveFlags1;
+			SPtr2->UserFlags = SaveFlags2;
+			int RetCode =
+					CtrlObject->Plugins.Compare(hSortPlugin, &pi1, &pi2, SortMode + (SM_UNSORTED - UNSORTED));
+			FileList::FreePluginPanelItem(&pi1);
+			FileList::FreePluginPanelItem(&pi2);
+			return RetCode;
+		}
+
+	public:
+		FileListSorter(int SortMode_, int SortOrder_, int SortGroups_, int SelectedFirst_,
+				int DirectoriesFirst_, int NumericSort_, int CaseSensitiveSort_, HANDLE hSortPlugin_)
+			:
+			SortMode(SortMode_),
+			SortOrder(SortOrder_),
+			SortGroups(SortGroups_ != 0),
+			SelectedFirst(SelectedFirst_ != 0),
+			DirectoriesFirst(DirectoriesFirst_ != 0),
+			NumericSort(NumericSort_ != 0),
+			CaseSensitiveSort(CaseSensitiveSort_ != 0),
+			hSortPlugin(hSortPlugin_)
+		{}
+
+		// plugin's compare function may not be invoked from other threads
+		bool CanSortInParallel() const { return !hSortPlugin; }
+
+		void ExtractKey(FileListItem *Item, SortKey &Key) const
+		{
+			Key.Item = Item;
+			Key.Name = PointToName(Item->strName.CPtr(), Item->strName.CEnd());
+			Key.Ext = PointToExt(Key.Name, Item->strName.CEnd());
+			Key.Position = Item->Position;
+			Key.SortGroup = Item->SortGroup;
+			Key.Parent = TestParentFolderName(Item->strName);
+			Key.Directory = (Item->FileAttr & FILE_ATTRIBUTE_DIRECTORY) != 0;
+			Key.Selected = Item->Selected;
+			Key.NameEnd = (!Opt.SortFolderExt && Key.Directory) ? Item->strName.CEnd() : Key.Ext;
+
+			switch (SortMode) {
+				case BY_MTIME:
+					Key.Value = FileTimeToUI64(&Item->WriteTime);
+					break;
+				case BY_CTIME:
+					Key.Value = FileTimeToUI64(&Item->CreationTime);
+					break;
+				case BY_ATIME:
+					Key.Value = FileTimeToUI64(&Item->AccessTime);
+					break;
+				case BY_CHTIME:
+					Key.Value = FileTimeToUI64(&Item->ChangeTime);
+					break;
+				case BY_SIZE:
+					Key.Value = Item->FileSize;
+					break;
+				case BY_PHYSICALSIZE:
+					Key.Value = Item->PhysicalSize;
+					break;
+				case BY_NUMLINKS:
+					Key.Value = Item->NumberOfLinks;
+					break;
+				default:
+					Key.Value = 0;
+			}
+		}
+
+		int Compare(const SortKey &Key1, const SortKey &Key2) const
+		{
+			int RetCode;
+
+			if (Key1.Parent != Key2.Parent)
+				return Key1.Parent ? -1 : 1;
+
+			if (SortMode == UNSORTED) {
+				if (SelectedFirst && Key1.Selected != Key2.Selected)
+					return Key1.Selected ? -1 : 1;
+
+				return ComparePositions(Key1, Key2);
+			}
+
+			if (DirectoriesFirst && Key1.Directory != Key2.Directory)
+				return Key1.Directory ? -1 : 1;
+
+			if (SelectedFirst && Key1.Selected != Key2.Selected)
+				return Key1.Selected ? -1 : 1;
+
+			if (SortGroups && (SortMode == BY_NAME || SortMode == BY_EXT || SortMode == BY_FULLNAME)
+					&& Key1.SortGroup != Key2.SortGroup)
+				return Key1.SortGroup < Key2.SortGroup ? -1 : 1;
+
+			if (hSortPlugin) {
+				RetCode = ComparePlugin(Key1.Item, Key2.Item);
+				if (RetCode != -2)
+					return RetCode * SortOrder;
+			}
+
+			const FileListItem *SPtr1 = Key1.Item;
+			const FileListItem *SPtr2 = Key2.Item;
+
+			// НЕ СОРТИРУЕМ КАТАЛОГИ В РЕЖИМЕ "ПО РАСШИРЕНИЮ" (Опционально!)
+			if (!(SortMode == BY_EXT && !Opt.SortFolderExt && Key1.Directory && Key2.Directory)) {
+				switch (SortMode) {
+					case BY_NAME:
+						break;
+
+					case BY_EXT:
+						if (!*Key1.Ext && !*Key2.Ext)
+							break;
+
+						if (!*Key1.Ext)
+							return -SortOrder;
+
+						if (!*Key2.Ext)
+							return SortOrder;
+
+						RetCode = CompareStrings(Key1.Ext + 1, Key2.Ext + 1);
+						if (RetCode)
+							return RetCode * SortOrder;
+						break;
+
+					case BY_MTIME:
+					case BY_CTIME:
+					case BY_ATIME:
+					case BY_CHTIME:
+					case BY_SIZE:
+					case BY_PHYSICALSIZE:
+					case BY_NUMLINKS:
+						RetCode = CompareValues(Key1.Value, Key2.Value);
+						if (RetCode)
+							return RetCode;
+						break;
+
+					case BY_DIZ:
+						if (!SPtr1->DizText) {
+							if (!SPtr2->DizText)
+								break;
+							else
+								return SortOrder;
+						}
+
+						if (!SPtr2->DizText)
+							return -SortOrder;
+
+						RetCode = CompareStrings(SPtr1->DizText, SPtr2->DizText);
+						if (RetCode)
+							return RetCode * SortOrder;
+						break;
+
+					case BY_OWNER:
+						RetCode = StrCmpI(SPtr1->strOwner, SPtr2->strOwner);
+						if (RetCode)
+							return RetCode * SortOrder;
+						break;
+
+					case BY_FULLNAME: {
+						int NameCmp;
+						if (NumericSort) {
+							const wchar_t *Path1 = SPtr1->strName.CPtr();
+							const wchar_t *Path2 = SPtr2->strName.CPtr();
+							NameCmp = CaseSensitiveSort
+									? StrCmpNN(Path1, static_cast<int>(Key1.Name - Path1), Path2,
+											static_cast<int>(Key2.Name - Path2))
+									: StrCmpNNI(Path1, static_cast<int>(Key1.Name - Path1), Path2,
+											static_cast<int>(Key2.Name - Path2));
+							if (!NameCmp)
+								NameCmp = CaseSensitiveSort ? NumStrCmp(Key1.Name, Key2.Name)
+															: NumStrCmpI(Key1.Name, Key2.Name);
+							else
+								NameCmp = CaseSensitiveSort ? StrCmp(Path1, Path2) : StrCmpI(Path1, Path2);
+						} else {
+							NameCmp = CaseSensitiveSort ? StrCmp(SPtr1->strName, SPtr2->strName)
+														: StrCmpI(SPtr1->strName, SPtr2->strName);
+						}
+
+						if (NameCmp)
+							return NameCmp * SortOrder;
+
+						return ComparePositions(Key1, Key2);
+					}
+
+					case BY_CUSTOMDATA:
+						if (SPtr1->strCustomData.IsEmpty()) {
+							if (SPtr2->strCustomData.IsEmpty())
+								break;
+							else
+								return SortOrder;
+						}
+
+						if (SPtr2->strCustomData.IsEmpty())
+							return -SortOrder;
+
+						RetCode = CompareStrings(SPtr1->strCustomData, SPtr2->strCustomData);
+						if (RetCode)
+							return SortOrder * RetCode;
+						break;
+				}
+			}
+
+			const wchar_t *Name1 = Key1.Name, *Name2 = Key2.Name;
+			const int Len1 = static_cast<int>(Key1.NameEnd - Name1);
+			const int Len2 = static_cast<int>(Key2.NameEnd - Name2);
+			int NameCmp;
+
+			if (NumericSort)
+				NameCmp = CaseSensitiveSort ? NumStrCmpN(Name1, Len1, Name2, Len2)
+											: NumStrCmpNI(Name1, Len1, Name2, Len2);
+			else
+				NameCmp = CaseSensitiveSort ? StrCmpNN(Name1, Len1, Name2, Len2)
+											: StrCmpNNI(Name1, Len1, Name2, Len2);
+
+			if (!NameCmp)
+				NameCmp = CompareStrings(Key1.NameEnd, Key2.NameEnd);
+
+			if (NameCmp)
+				return NameCmp * SortOrder;
+
+			return ComparePositions(Key1, Key2);
+		}
+
+		inline bool operator()(const SortKey &Key1, const SortKey &Key2) const
+		{
+			return Compare(Key1, Key2) < 0;
+		}
+	};
+}
+
+void FileList::SortFileList(int KeepPosition)
+{
+	if (ListData.Count() > 1) {
+		FARString strCurName;
+
+		if (SortMode == BY_DIZ)
+			ReadDiz();
+
+		if (KeepPosition) {
+			ASSERT(CurFile < ListData.Count());
+			strCurName = ListData[CurFile]->strName;
+		}
+
+		HANDLE hSortPlugin = (PanelMode == PLUGIN_PANEL && hPlugin
+									&& reinterpret_cast<PluginHandle *>(hPlugin)->pPlugin->HasCompare())
+				? hPlugin
+				: nullptr;
+
+		const FileListSorter Sorter(SortMode, SortOrder, SortGroups, SelectedFirst, DirectoriesFirst,
+				NumericSort, CaseSensitiveSort, hSortPlugin);
+
+		std::vector<SortKey> Keys(ListData.Count());
+		for (int i = 0; i < ListData.Count(); ++i) {
+			Sorter.ExtractKey(ListData[i], Keys[i]);
+		}
+
+		ParallelSort(Keys, Sorter, Sorter.CanSortInParallel() ? 0 : 1);
+
+		for (int i = 0; i < ListData.Count(); ++i) {
+			ListData[i] = Keys[i].Item;
+		}
+
+		if (KeepPosition)
+			GoToFile(strCurName);
+	}
+}
@@ -116,6 +116,21 @@ static void PR_ReadFileNamesMsg()
 	ReadFileNamesMsg((wchar_t *)preRedrawItem.Param.Param1);
 }
 
+static void FindDataToFileListItem(FAR_FIND_DATA_EX &fdata, FileListItem *Item)
+{
+	Item->FileAttr = fdata.dwFileAttributes;
+	Item->FileMode = fdata.dwUnixMode;
+	Item->CreationTime = fdata.ftCreationTime;
+	Item->AccessTime = fdata.ftLastAccessTime;
+	Item->WriteTime = fdata.ftLastWriteTime;
+	Item->ChangeTime = fdata.ftChangeTime;
+	Item->FileSize = fdata.nFileSize;
+	Item->PhysicalSize = fdata.nPhysicalSize;
+	Item->strName = std::move(fdata.strFileName);
+	Item->NumberOfLinks = fdata.nHardLinks;
+	Item->SortGroup = DEFAULT_SORT_GROUP;
+}
+
 // ЭТО ЕСТЬ УЗКОЕ МЕСТО ДЛЯ СКОРОСТНЫХ ХАРАКТЕРИСТИК Far Manager
 // при считывании дирректории
 
@@ -218,10 +233,14 @@ void FileList::ReadFileNames(int KeepSelection, int IgnoreVisible, int DrawMessa
 	bool bCurDirRoot = IsLocalRootPath(strCurDir) || IsLocalPrefixRootPath(strCurDir)
 			|| IsLocalVolumeRootPath(strCurDir);
 
+	DWORD FindFlags = FIND_FILE_FLAG_NO_CUR_UP;
+	if (!CanBeAnnoying)
+		FindFlags|= FIND_FILE_FLAG_NOT_ANNOYING;
+	if (Opt.ParallelStat)
+		FindFlags|= FIND_FILE_FLAG_PARALLEL_STAT;
+
 	// BUGBUG!!! // что это?
-	::FindFile Find(L"*", true,
-			CanBeAnnoying ? FIND_FILE_FLAG_NO_CUR_UP
-						: FIND_FILE_FLAG_NO_CUR_UP | FIND_FILE_FLAG_NOT_ANNOYING);
+	::FindFile Find(L"*", true, FindFlags);
 	DWORD FindErrorCode = ERROR_SUCCESS;
 	bool UseFilter = Filter->IsEnabledOnPanel();
 	bool ReadCustomData = IsColumnDisplayed(CUSTOM_COLUMN0) != 0;
@@ -240,16 +259,7 @@ void FileList::ReadFileNames(int KeepSelection, int IgnoreVisible, int DrawMessa
 			if (!NewPtr)
 				break;
 
-			NewPtr->FileAttr = fdata.dwFileAttributes;
-			NewPtr->FileMode = fdata.dwUnixMode;
-			NewPtr->CreationTime = fdata.ftCreationTime;
-			NewPtr->AccessTime = fdata.ftLastAccessTime;
-			NewPtr->WriteTime = fdata.ftLastWriteTime;
-			NewPtr->ChangeTime = fdata.ftChangeTime;
-			NewPtr->FileSize = fdata.nFileSize;
-			NewPtr->PhysicalSize = fdata.nPhysicalSize;
-			NewPtr->strName = std::move(fdata.strFileName);
-			NewPtr->NumberOfLinks = fdata.nHardLinks;
+			FindDataToFileListItem(fdata, NewPtr);
 
 			if (!(fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
 				if ((fdata.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0 || Opt.ScanJunction) {
@@ -257,8 +267,6 @@ void FileList::ReadFileNames(int KeepSelection, int IgnoreVisible, int DrawMessa
 				}
 			}
 
-			NewPtr->SortGroup = DEFAULT_SORT_GROUP;
-
 			if (ReadOwners || ReadGroups) {
 				SudoSilentQueryRegion ssqr(!CanBeAnnoying);
 
@@ -419,6 +427,160 @@ void FileList::ReadFileNames(int KeepSelection, int IgnoreVisible, int DrawMessa
 	FarChDir(strSaveDir);	//???
 }
 
+// Applies to list only changes of entries reported by change notification, so
+// huge folders don't need to be reread entirely on each change of single file.
+// Returns false if this is not possible and whole folder must be reread instead.
+bool FileList::ReadChangedFileNames()
+{
+	if (!Opt.AutoUpdateIncremental || PanelMode != NORMAL_PANEL || !ListChange || !IsVisible()
+			|| IsColumnDisplayed(DIZ_COLUMN) || SortMode == BY_DIZ
+			|| CtrlObject->Cp()->GetAnotherPanel(this)->GetMode() == PLUGIN_PANEL)
+		return false;
+
+	std::set<std::string> ChangedNamesMB;
+	if (!ListChange->FetchChangedNames(ChangedNamesMB))
+		return false;
+
+	// changed name -> index of its item in list or -1 if there is no such item yet
+	std::map<FARString, int> ChangedNames;
+	for (const auto &NameMB : ChangedNamesMB)
+		ChangedNames.emplace(NameMB, -1);
+
+	unsigned int NextPosition = 0;
+	for (int i = 0; i < ListData.Count(); ++i) {
+		auto It = ChangedNames.find(ListData[i]->strName);
+		if (It != ChangedNames.end())
+			It->second = i;
+		NextPosition = std::max(NextPosition, ListData[i]->Position + 1);
+	}
+
+	FARString strCurName;
+	if (CurFile < ListData.Count())
+		strCurName = ListData[CurFile]->strName;
+
+	SudoClientRegion sdc_rgn;
+
+	if (Opt.ShowPanelFree) {
+		uint64_t TotalSize, TotalFree;
+
+		if (!apiGetDiskSize(strCurDir, &TotalSize, &TotalFree, &FreeDiskSize))
+			FreeDiskSize = 0;
+	}
+
+	if (Filter)
+		Filter->UpdateCurrentTime();
+	CtrlObject->HiFiles->UpdateCurrentTime();
+
+	const bool UseFilter = Filter && Filter->IsEnabledOnPanel();
+	const bool ReadOwners = IsColumnDisplayed(OWNER_COLUMN) != 0;
+	const bool ReadGroups = IsColumnDisplayed(GROUP_COLUMN) != 0;
+	const bool ReadCustomData = IsColumnDisplayed(CUSTOM_COLUMN0) != 0;
+	CachedFileOwnerLookup cached_owners;
+	CachedFileGroupLookup cached_groups;
+	FAR_FIND_DATA_EX fdata;
+	FARString strFullName;
+
+	for (const auto &It : ChangedNames) {
+		FileListItem *OldPtr = (It.second != -1) ? ListData[It.second] : nullptr;
+		bool Present = false;
+		strFullName = strCurDir;
+		AddEndSlash(strFullName);
+		strFullName+= It.first;
+
+		if (apiGetFindDataForExactPathName(strFullName, fdata)) {
+			// unlike folder enumeration it doesn't evaluate attributes that depend on name
+			fdata.dwFileAttributes|=
+					WINPORT(EvaluateAttributes)(fdata.dwUnixMode, It.first) & FILE_ATTRIBUTE_HIDDEN;
+			Present = (Opt.ShowHidden
+							|| !(fdata.dwFileAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM)))
+					&& (!UseFilter || Filter->FileInFilter(fdata));
+		}
+
+		if (!Present) {
+			if (OldPtr) {
+				delete OldPtr;
+				ListData[It.second] = nullptr;
+			}
+			continue;
+		}
+
+		FileListItem *NewPtr;
+		if (OldPtr) {
+			NewPtr = new FileListItem;
+			NewPtr->Position = OldPtr->Position;
+			NewPtr->Selected = OldPtr->Selected;
+			NewPtr->PrevSelected = OldPtr->PrevSelected;
+			if (OldPtr->ShowFolderSize && (fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+				NewPtr->ShowFolderSize = 2;
+				fdata.nFileSize = OldPtr->FileSize;
+				fdata.nPhysicalSize = OldPtr->PhysicalSize;
+			}
+			delete OldPtr;
+			ListData[It.second] = NewPtr;
+
+		} else {
+			NewPtr = ListData.Add();
+			if (!NewPtr)
+				break;
+			NewPtr->Position = NextPosition++;
+		}
+
+		FindDataToFileListItem(fdata, NewPtr);
+
+		if (ReadOwners || ReadGroups) {
+			if (ReadOwners)
+				NewPtr->strOwner = cached_owners.Lookup(fdata.UnixOwner);
+
+			if (ReadGroups)
+				NewPtr->strGroup = cached_groups.Lookup(fdata.UnixGroup);
+		}
+
+		if (ReadCustomData)
+			CtrlObject->Plugins.GetCustomData(NewPtr);
+
+		if (SortGroupsRead)
+			NewPtr->SortGroup = CtrlObject->HiFiles->GetGroup(NewPtr);
+
+		if (Opt.Highlight)
+			CtrlObject->HiFiles->GetHiColor(&NewPtr, 1);
+	}
+
+	ListData.Compact();
+
+	LastCurFile = -1;
+	SelFileCount = 0;
+	SelFileSize = 0;
+	TotalFileCount = 0;
+	TotalFileSize = 0;
+	CacheSelIndex = -1;
+	CacheSelClearIndex = -1;
+	DizRead = FALSE;
+
+	for (const auto &Item : ListData) {
+		if (TestParentFolderName(Item->strName))
+			continue;
+
+		if (!(Item->FileAttr & FILE_ATTRIBUTE_DIRECTORY)) {
+			TotalFileCount++;
+			if ((Item->FileAttr & FILE_ATTRIBUTE_REPARSE_POINT) == 0 || Opt.ScanJunction)
+				TotalFileSize+= Item->FileSize;
+		}
+
+		if (Item->Selected) {
+			SelFileCount++;
+			SelFileSize+= Item->FileSize;
+		}
+	}
+
+	SortFileList(FALSE);
+
+	if (CurFile >= ListData.Count() || StrCmp(ListData[CurFile]->strName, strCurName))
+		GoToFile(strCurName);
+
+	CorrectPosition();
+	return true;
+}
+
 /*
 	$ 22.06.2001 SKV
 	Добавлен параметр для вызова после исполнения команды.
@@ -455,7 +617,10 @@ int FileList::UpdateIfChanged(int UpdateMode)
 						AnotherPanel->Redraw();
 				}
 
-				Update(UPDATE_KEEP_SELECTION);
+				if (ReadChangedFileNames())
+					LastUpdateTime = GetProcessUptimeMSec();
+				else
+					Update(UPDATE_KEEP_SELECTION);
 
 				if (UpdateMode == UIC_UPDATE_NORMAL)
 					Show();
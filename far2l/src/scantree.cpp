@@ -39,6 +39,202 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "config.hpp"
 #include "pathmix.hpp"
 #include "processname.hpp"
+#include <WorkStealingPool.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+
+/*
+	Parallel mode machinery.
+	Each directory that ScanTree going to enter gets ScanTreePrefetchedDir instance whose listing is
+	read by some worker of ScanTreePrefetcher's pool. While reading listing worker also creates and
+	queues ScanTreePrefetchedDir-s for subdirectories that likely will be entered, so whole tree gets
+	read ahead by several threads. GetNextName walks tree in usual depth-first order but takes entries
+	from prefetched listings, so its output order is same as in sequential mode.
+	Prefetched instances are owned by ScanDir-s and by their parent instances, so leaving or skipping
+	directory releases whole its read ahead subtree. Queued jobs refer instances by weak pointers and
+	worker abandons reading of listing that nobody needs anymore.
+*/
+
+// how many entries may be read ahead but not yet consumed by GetNextName
+static constexpr long ScanTreeReadAheadLimit = 0x40000;
+
+// how many entries worker accumulates before making them available to GetNextName
+static constexpr size_t ScanTreePrefetchChunk = 0x100;
+
+struct ScanTreePrefetchedDir
+{
+	ScanTreePrefetcher *Owner;
+	const std::wstring Path;	// with trailing slash
+
+	std::mutex Mtx;
+	std::condition_variable Cond;
+	std::vector<FAR_FIND_DATA_EX> Entries;
+	std::map<FARString, std::shared_ptr<ScanTreePrefetchedDir>> Subdirs;
+	size_t Accounted = 0;		// count of entries still accounted in Owner's read ahead budget
+	bool Done = false;
+
+	ScanTreePrefetchedDir(ScanTreePrefetcher *owner, const std::wstring &path);
+	~ScanTreePrefetchedDir();
+
+	bool Get(size_t Index, FAR_FIND_DATA_EX &fdata);
+	std::shared_ptr<ScanTreePrefetchedDir> TakeSubdir(const FARString &Name);
+};
+
+class ScanTreePrefetcher
+{
+	friend struct ScanTreePrefetchedDir;
+
+	std::atomic<long> ReadAheadBudget{ScanTreeReadAheadLimit};
+	const DWORD WinPortFindFlags;
+	const bool ScanSymlinks;
+	const bool Recurse;
+	std::mutex INodesMtx;
+	ScannedINodes INodes;
+	WorkStealingPool Pool;		// keep it last to be destroyed first
+
+	bool MayEnter(const FAR_FIND_DATA_EX &fdata);
+	void ReadDir(const std::weak_ptr<ScanTreePrefetchedDir> &wpd);
+	void QueueReadDir(const std::shared_ptr<ScanTreePrefetchedDir> &pd);
+
+public:
+	ScanTreePrefetcher(unsigned int ThreadsCount, DWORD WinPortFindFlags_, bool ScanSymlinks_, bool Recurse_)
+		:
+		WinPortFindFlags(WinPortFindFlags_),
+		ScanSymlinks(ScanSymlinks_),
+		Recurse(Recurse_),
+		Pool(ThreadsCount)
+	{}
+
+	std::shared_ptr<ScanTreePrefetchedDir> Start(const std::wstring &Path);
+};
+
+ScanTreePrefetchedDir::ScanTreePrefetchedDir(ScanTreePrefetcher *owner, const std::wstring &path)
+	:
+	Owner(owner), Path(path)
+{}
+
+ScanTreePrefetchedDir::~ScanTreePrefetchedDir()
+{
+	Owner->ReadAheadBudget+= (long)Accounted;
+}
+
+bool ScanTreePrefetchedDir::Get(size_t Index, FAR_FIND_DATA_EX &fdata)
+{
+	std::unique_lock<std::mutex> lock(Mtx);
+	while (Index >= Entries.size()) {
+		if (Done)
+			return false;
+		Cond.wait(lock);
+	}
+
+	fdata = std::move(Entries[Index]);
+	if (Accounted) {
+		--Accounted;
+		++Owner->ReadAheadBudget;
+	}
+	return true;
+}
+
+std::shared_ptr<ScanTreePrefetchedDir> ScanTreePrefetchedDir::TakeSubdir(const FARString &Name)
+{
+	std::shared_ptr<ScanTreePrefetchedDir> out;
+	std::lock_guard<std::mutex> lock(Mtx);
+	auto it = Subdirs.find(Name);
+	if (it != Subdirs.end()) {
+		out = std::move(it->second);
+		Subdirs.erase(it);
+	}
+	return out;
+}
+
+// must be kept in sync with ScanTree::CheckForEnterSubdir, except of recursion check that is done
+// there by paths of directories being scanned, here its enough to avoid reading same inode twice
+bool ScanTreePrefetcher::MayEnter(const FAR_FIND_DATA_EX &fdata)
+{
+	if ((fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0 || !Recurse)
+		return false;
+
+	if ((fdata.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0 && !ScanSymlinks)
+		return false;
+
+	if (ReadAheadBudget.load(std::memory_order_relaxed) <= 0)
+		return false;
+
+	std::lock_guard<std::mutex> lock(INodesMtx);
+	return INodes.Put(fdata.UnixDevice, fdata.UnixNode);
+}
+
+void ScanTreePrefetcher::QueueReadDir(const std::shared_ptr<ScanTreePrefetchedDir> &pd)
+{
+	std::weak_ptr<ScanTreePrefetchedDir> wpd(pd);
+	Pool.Queue([this, wpd]() { ReadDir(wpd); });
+}
+
+std::shared_ptr<ScanTreePrefetchedDir> ScanTreePrefetcher::Start(const std::wstring &Path)
+{
+	auto pd = std::make_shared<ScanTreePrefetchedDir>(this, Path);
+	QueueReadDir(pd);
+	return pd;
+}
+
+void ScanTreePrefetcher::ReadDir(const std::weak_ptr<ScanTreePrefetchedDir> &wpd)
+{
+	auto pd = wpd.lock();
+	if (!pd)
+		return;
+
+	std::wstring Mask = pd->Path;
+	Mask+= L'*';
+	FindFile Enumer(Mask.c_str(), ScanSymlinks, WinPortFindFlags);
+
+	std::vector<FAR_FIND_DATA_EX> Chunk;
+	std::vector<std::shared_ptr<ScanTreePrefetchedDir>> ChunkSubdirs;
+	for (bool More = true; More;) {
+		FAR_FIND_DATA_EX fdata;
+		More = Enumer.Get(fdata);
+		if (More) {
+			if (MayEnter(fdata)) {
+				ChunkSubdirs.emplace_back(std::make_shared<ScanTreePrefetchedDir>(this,
+						pd->Path + fdata.strFileName.GetWide() + LGOOD_SLASH));
+			}
+			Chunk.emplace_back(std::move(fdata));
+			if (Chunk.size() < ScanTreePrefetchChunk)
+				continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(pd->Mtx);
+			for (auto &Entry : Chunk) {
+				pd->Entries.emplace_back(std::move(Entry));
+			}
+			for (const auto &Subdir : ChunkSubdirs) {
+				const size_t NameOffset = pd->Path.size();
+				pd->Subdirs.emplace(FARString(Subdir->Path.c_str() + NameOffset,
+						Subdir->Path.size() - NameOffset - 1), Subdir);
+			}
+			pd->Accounted+= Chunk.size();
+			pd->Done = !More;
+			pd->Cond.notify_all();
+		}
+		ReadAheadBudget-= (long)Chunk.size();
+		Chunk.clear();
+
+		// queue in reverse order, so this worker will pick first subdirectory first
+		// while other workers will steal from the opposite side of its deque
+		for (auto it = ChunkSubdirs.rbegin(); it != ChunkSubdirs.rend(); ++it) {
+			QueueReadDir(*it);
+		}
+		ChunkSubdirs.clear();
+
+		if (pd.use_count() == 1) {	// nobody needs this listing anymore
+			break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
 
 ScanTree::ScanTree(int RetUpDir, int Recurse, int ScanJunction)
 {
@@ -47,12 +243,30 @@ ScanTree::ScanTree(int RetUpDir, int Recurse, int ScanJunction)
 	Flags.Change(FSCANTREE_SCANSYMLINK, (ScanJunction == -1 ? Opt.ScanJunction : ScanJunction));
 }
 
+ScanTree::~ScanTree()
+{
+	// prefetched listings refer prefetcher, so release them first
+	ScanDirStack.clear();
+	Prefetcher.reset();
+}
+
+void ScanTree::SetParallel(unsigned int ThreadsCount)
+{
+	ParallelThreads = ThreadsCount;
+}
+
 void ScanTree::SetFindPath(const wchar_t *Path, const wchar_t *Mask, const DWORD NewScanFlags)
 {
 	Flags.Flags = (Flags.Flags & 0x0000FFFF) | (NewScanFlags & 0xFFFF0000);
 	strFindPath = *Path ? Path : L".";
 	strFindMask = wcscmp(Mask, L"*") ? Mask : L"";
 	ScanDirStack.clear();
+	Prefetcher.reset();
+
+	if (ParallelThreads != 1) {
+		Prefetcher.reset(new ScanTreePrefetcher(ParallelThreads, WinPortFindFlags(),
+				Flags.Check(FSCANTREE_SCANSYMLINK), Flags.Check(FSCANTREE_RECUR)));
+	}
 
 	if (strFindPath != WGOOD_SLASH) {
 		DeleteEndSlash(strFindPath);
@@ -111,14 +325,11 @@ void ScanTree::CheckForEnterSubdir(const FAR_FIND_DATA_EX *fdata)
 	ScanDirStack.back().UnixNode = fdata->UnixNode;
 	ScanDirStack.back().InsideSymlink = InsideSymlink;
 
-	StartEnumSubdir();
+	StartEnumSubdir(&fdata->strFileName);
 }
 
-void ScanTree::StartEnumSubdir()
+DWORD ScanTree::WinPortFindFlags() const
 {
-	if (!strFindPath.empty() && strFindPath.back() != LGOOD_SLASH)
-		strFindPath+= LGOOD_SLASH;
-
 	DWORD WinPortFindFlags = 0;
 	if (Flags.Check(FSCANTREE_NOLINKS))
 		WinPortFindFlags|= FIND_FILE_FLAG_NO_LINKS;
@@ -129,10 +340,32 @@ void ScanTree::StartEnumSubdir()
 	if (Flags.Check(FSCANTREE_CASE_INSENSITIVE))
 		WinPortFindFlags|= FIND_FILE_FLAG_CASE_INSENSITIVE;
 
+	return WinPortFindFlags;
+}
+
+void ScanTree::StartEnumSubdir(const FARString *SubdirName)
+{
+	if (!strFindPath.empty() && strFindPath.back() != LGOOD_SLASH)
+		strFindPath+= LGOOD_SLASH;
+
+	if (Prefetcher) {
+		std::shared_ptr<ScanTreePrefetchedDir> Prefetched;
+		if (SubdirName && ScanDirStack.size() > 1) {
+			const auto &Parent = *(++ScanDirStack.rbegin());
+			if (Parent.Prefetched) {
+				Prefetched = Parent.Prefetched->TakeSubdir(*SubdirName);
+			}
+		}
+		// if this directory wasn't read ahead then start reading it right now, anyway
+		// its subdirectories will be read ahead by other workers while we're waiting
+		ScanDirStack.back().Prefetched = Prefetched ? Prefetched : Prefetcher->Start(strFindPath);
+		return;
+	}
+
 	strFindPath+= L'*';		// append temporary asterisk
 
 	ScanDirStack.back().Enumer.reset(
-			new FindFile(strFindPath.c_str(), Flags.Check(FSCANTREE_SCANSYMLINK), WinPortFindFlags));
+			new FindFile(strFindPath.c_str(), Flags.Check(FSCANTREE_SCANSYMLINK), WinPortFindFlags()));
 
 	strFindPath.pop_back();		// strip asterisk
 }
@@ -152,17 +385,28 @@ void ScanTree::LeaveSubdir()
 
 bool ScanTree::ScanDir::GetNext(FAR_FIND_DATA_EX *fdata, bool FilesFirst)
 {
-	if (Enumer)
-		for (;;) {
+	for (;;) {
+		if (Enumer) {
 			if (!Enumer->Get(*fdata)) {
 				Enumer.reset();
 				break;
 			}
-			if (!FilesFirst || (fdata->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
-				return true;
 
-			Postponed.emplace_back(std::move(*fdata));
-		}
+		} else if (Prefetched) {
+			// dont release Prefetched when its exhausted: it holds subdirectories
+			// that still may be entered due to FilesFirst postponing
+			if (!Prefetched->Get(PrefetchedIndex, *fdata))
+				break;
+			++PrefetchedIndex;
+
+		} else
+			break;
+
+		if (!FilesFirst || (fdata->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+			return true;
+
+		Postponed.emplace_back(std::move(*fdata));
+	}
 
 	if (!Postponed.empty()) {
 		*fdata = std::move(Postponed.front());
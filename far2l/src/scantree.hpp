@@ -41,6 +41,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 #include <set>
 #include <list>
+#include <memory>
 #include <WinCompat.h>
 #include "FARString.hpp"
 
@@ -71,15 +72,22 @@ public:
 	inline bool Put(uint64_t d, uint64_t ino) { return _s.emplace(ino, d).second; }
 };
 
+struct ScanTreePrefetchedDir;
+class ScanTreePrefetcher;
+
 class ScanTree
 {
 	BitFlags Flags;
 	std::wstring strFindPath;
 	std::wstring strFindMask;
+	unsigned int ParallelThreads = 1;
+	std::unique_ptr<ScanTreePrefetcher> Prefetcher;
 
 	struct ScanDir
 	{
 		std::unique_ptr<FindFile> Enumer;
+		std::shared_ptr<ScanTreePrefetchedDir> Prefetched;	// used instead of Enumer in parallel mode
+		size_t PrefetchedIndex = 0;
 		std::list<FAR_FIND_DATA_EX> Postponed;
 		FARString RealPath;
 		uint64_t UnixDevice{};
@@ -90,12 +98,19 @@ class ScanTree
 	};
 	std::list<ScanDir> ScanDirStack;
 
+	DWORD WinPortFindFlags() const;
 	void CheckForEnterSubdir(const FAR_FIND_DATA_EX *fdata);
-	void StartEnumSubdir();
+	void StartEnumSubdir(const FARString *SubdirName = nullptr);
 	void LeaveSubdir();
 
 public:
 	ScanTree(int RetUpDir, int Recurse = 1, int ScanJunction = -1);
+	~ScanTree();
+
+	// Enables parallel mode if ThreadsCount != 1: subdirectories listings are read ahead by
+	// worker threads, while GetNextName still returns entries in exactly same order as in
+	// sequential mode. ThreadsCount == 0 means use CPU-s count. Must be invoked before SetFindPath.
+	void SetParallel(unsigned int ThreadsCount);
 
 	// 3-й параметр - флаги из старшего слова
 	void
@@ -34,6 +34,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "headers.hpp"
 
 #include <ctype.h>
+#include <fcntl.h>
 #include "viewer.hpp"
 #include "codepage.hpp"
 #include "macroopcode.hpp"
@@ -67,6 +68,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "wakeful.hpp"
 #include "WideMB.h"
 #include "UtfConvert.hpp"
+#include "ViewerSearch.hpp"
+#include "ViewerLineIndex.hpp"
 
 #define MAX_VIEWLINE 0x2000
 
@@ -135,6 +138,20 @@ static int CalcCodeUnitsDistance(UINT CodePage, const wchar_t *begin, const wcha
 	return distance;
 }
 
+// size in bytes of unit of viewer's positions
+static int CodeUnitBytes(UINT CodePage)
+{
+	switch (CodePage) {
+		case CP_UTF32LE:
+		case CP_UTF32BE:
+			return 4;
+		case CP_UTF16LE:
+		case CP_UTF16BE:
+			return 2;
+	}
+	return 1;
+}
+
 Viewer::Viewer(bool bQuickView, UINT aCodePage)
 	:
 	ViOpt(Opt.ViOpt), m_bQuickView(bQuickView)
@@ -342,6 +359,10 @@ int Viewer::OpenFile(FileHolderPtr NewFileHolder, int warning)
 	}
 
 	FHP = NewFileHolder;
+	strOpenedPathName = OpenPathName;
+	LineIndex.reset();
+	LineIndexFileSize = (UINT64)-1;
+	FollowNotify.reset();
 	CodePageChangedByUser = FALSE;
 
 	ConvertNameToFull(GotPathName, strFullFileName);
@@ -1229,8 +1250,16 @@ int Viewer::ProcessKey(int Key)
 			Show();
 			return (TRUE);
 		}
+		// следить за дописыванием файла, как tail -f
+		case KEY_CTRLF: {
+			SetFollowMode(!FollowNotify);
+			return TRUE;
+		}
 		case KEY_IDLE: {
-			if (ViewFile.Opened()) {
+			if (FollowNotify) {
+				FollowFile(false);
+
+			} else if (ViewFile.Opened()) {
 				// TODO: strFullFileName -> if (DriveType!=DRIVE_REMOVABLE && !IsDriveTypeCDROM(DriveType))
 				{
 					FAR_FIND_DATA_EX NewViewFindData;
@@ -1265,6 +1294,9 @@ int Viewer::ProcessKey(int Key)
 				}
 			}
 
+			if (LineIndexPending)
+				ShowStatus();
+
 			if (Opt.ViewerEditorClock && HostFileViewer && HostFileViewer->IsFullScreen()
 					&& Opt.ViOpt.ShowTitleBar)
 				ShowTime(FALSE);
@@ -2007,6 +2039,18 @@ void Viewer::Up()
 
 	LastPage = 0;
 
+	if (!VM.Hex && !VM.Wrap) {
+		// line index knows where previous line begins unless its still on the way to there
+		if (ViewerLineIndex *LI = GetLineIndex()) {
+			const int UnitBytes = CodeUnitBytes(VM.CodePage);
+			const int64_t LinePos = LI->PosOfLine(LI->LineOfPos((FilePos - 1) * UnitBytes));
+			if (LinePos >= 0 && FilePos - LinePos / UnitBytes <= BufSize) {
+				FilePos = LinePos / UnitBytes;
+				return;
+			}
+		}
+	}
+
 	if (VM.Hex) {
 		// Alter-1: here we use BYTE COUNT, while in Down handler we use ::vread which may
 		// accept either CHARACTER COUNT or w_char count.
@@ -2240,7 +2284,7 @@ LONG_PTR WINAPI ViewerSearchDlgProc(HANDLE hDlg, int Msg, int Param1, LONG_PTR P
 			SendDlgMessage(hDlg, DM_SHOWITEM, SD_EDIT_HEX, Param1);
 			SendDlgMessage(hDlg, DM_ENABLE, SD_CHECKBOX_CASE, !Param1);
 			SendDlgMessage(hDlg, DM_ENABLE, SD_CHECKBOX_WORDS, !Param1);
-			// SendDlgMessage(hDlg,DM_ENABLE,SD_CHECKBOX_REGEXP,!Param1);
+			SendDlgMessage(hDlg, DM_ENABLE, SD_CHECKBOX_REGEXP, !Param1);
 			return TRUE;
 		}
 		case DN_BTNCLICK: {
@@ -2358,7 +2402,7 @@ void Viewer::Search(int Next, int FirstChar)
 		{DI_CHECKBOX,    40, 5,  0,  5,  {0}, 0, Msg::ViewSearchCase},
 		{DI_CHECKBOX,    40, 6,  0,  6,  {0}, 0, Msg::ViewSearchWholeWords},
 		{DI_CHECKBOX,    40, 7,  0,  7,  {0}, 0, Msg::ViewSearchReverse},
-		{DI_CHECKBOX,    40, 8,  0,  8,  {0}, DIF_DISABLE, Msg::ViewSearchRegexp},
+		{DI_CHECKBOX,    40, 8,  0,  8,  {0}, 0, Msg::ViewSearchRegexp},
 		{DI_TEXT,        3,  9,  0,  9,  {0}, DIF_SEPARATOR, L""},
 		{DI_BUTTON,      0,  10, 0,  10, {0}, DIF_DEFAULT | DIF_CENTERGROUP, Msg::ViewSearchSearch},
 		{DI_BUTTON,      0,  10, 0,  10, {0}, DIF_CENTERGROUP, Msg::ViewSearchCancel}
@@ -2458,6 +2502,7 @@ void Viewer::Search(int Next, int FirstChar)
 
 			Transform(strSearchStr, strSearchStr, L'S');
 			WholeWords = 0;
+			SearchRegexp = 0;
 		}
 
 		SearchWChars = (int)strSearchStr.GetLength();
@@ -2466,6 +2511,35 @@ void Viewer::Search(int Next, int FirstChar)
 
 		SearchCodeUnits =
 				CalcCodeUnitsDistance(VM.CodePage, strSearchStr.CPtr(), strSearchStr.CPtr() + SearchWChars);
+
+		// File content is scanned in background thread directly in mapped memory,
+		// own slow search by reading through vread used only if file can't be mapped
+		// (like some pseudo-file) or search string can't be represented in its codepage.
+		std::unique_ptr<ViewerSearch> BgSearch;
+		bool BgSearchReady = false;
+		try {
+			BgSearch.reset(new ViewerSearch(strOpenedPathName.GetMB().c_str(), VM.CodePage));
+			if (SearchHex) {
+				std::vector<uint8_t> Bytes(SearchWChars);
+				for (int I = 0; I < SearchWChars; ++I) {
+					Bytes[I] = (uint8_t)strSearchStr.At(I);
+				}
+				BgSearch->SetHex(Bytes);
+				BgSearchReady = true;
+
+			} else if (SearchRegexp) {
+				BgSearchReady = BgSearch->SetRegExp(strSearchStr, Case != 0);
+
+			} else {
+				BgSearch->SetText(strSearchStr, Case != 0, WholeWords != 0);
+				BgSearchReady = true;
+			}
+
+		} catch (std::exception &e) {
+			fprintf(stderr, "Viewer::Search: %s\n", e.what());
+			BgSearch.reset();
+		}
+
 		FARString strSearchStrLowerCase;
 
 		if (!Case && !SearchHex) {
@@ -2496,10 +2570,42 @@ void Viewer::Search(int Next, int FirstChar)
 			}
 		}
 
-		vseek(LastSelPos, SEEK_SET);
 		Match = false;
 
-		if (SearchWChars > 0 && (!ReverseSearch || LastSelPos >= 0)) {
+		if (BgSearch && BgSearchReady) {
+			const int UnitBytes = CodeUnitBytes(VM.CodePage);
+			const int64_t StartPos = LastSelPos * UnitBytes;
+			wakeful W;
+			BgSearch->Start(StartPos, ReverseSearch != 0);
+			const int64_t Total = ReverseSearch ? StartPos : BgSearch->FileSize() - StartPos;
+			while (!BgSearch->Wait(RedrawTimeout)) {
+				if (CheckForEscSilent()) {
+					if (ConfirmAbortOp()) {
+						BgSearch->Cancel();
+						Redraw();
+						return;
+					}
+				}
+
+				int Percent = Total > 0 ? static_cast<int>(BgSearch->Scanned() * 100 / Total) : -1;
+				ViewerSearchMsg(strMsgStr, Min(Percent, 100));
+			}
+
+			int64_t FoundPos = 0, FoundLen = 0;
+			if (BgSearch->Failed()) {
+				BgSearch.reset();
+
+			} else if (BgSearch->GetMatch(FoundPos, FoundLen)) {
+				Match = true;
+				MatchPos = FoundPos / UnitBytes;
+				SearchCodeUnits = static_cast<int>((FoundPos + FoundLen + UnitBytes - 1) / UnitBytes - MatchPos);
+			}
+		}
+
+		vseek(LastSelPos, SEEK_SET);
+
+		// viewer itself can't match regular expressions, so it's not found if background search unusable
+		if (!BgSearch && !SearchRegexp && SearchWChars > 0 && (!ReverseSearch || LastSelPos >= 0)) {
 			wchar_t Buf[16384];
 
 			int ReadSize;
@@ -2920,35 +3026,134 @@ bool Viewer::vgetc(WCHAR &C)
 	return Result;
 }
 
+// line index follows viewer's codepage, line separator and file size, its not used in hex mode
+ViewerLineIndex *Viewer::GetLineIndex()
+{
+	if (VM.Hex || m_bQuickView || !ViewFile.Opened())
+		return nullptr;
+
+	UINT64 CurFileSize = 0;
+	ViewFile.GetSize(CurFileSize);
+	if (LineIndexCodePage != VM.CodePage || LineIndexCRSym != CRSym || LineIndexFileSize != CurFileSize) {
+		// followed file only grows by appending, or its index gets reset, so previous index can be continued
+		std::unique_ptr<ViewerLineIndex> GrownFrom;
+		if (FollowNotify && LineIndexCodePage == VM.CodePage && LineIndexCRSym == CRSym
+				&& LineIndexFileSize < CurFileSize) {
+			GrownFrom = std::move(LineIndex);
+		}
+		LineIndex.reset();
+		LineIndexCodePage = VM.CodePage;
+		LineIndexCRSym = CRSym;
+		LineIndexFileSize = CurFileSize;
+		try {
+			LineIndex.reset(new ViewerLineIndex(strOpenedPathName.GetMB().c_str(), VM.CodePage, CRSym,
+					Opt.ViOpt.SavePos != 0, GrownFrom.get()));
+		} catch (std::exception &e) {
+			fprintf(stderr, "Viewer: no line index for '%ls' - %s\n", strOpenedPathName.CPtr(), e.what());
+		}
+	}
+
+	return LineIndex.get();
+}
+
+// returns false if lines are not counted, otherwise Line is zero-based number of line
+// at top of screen or -1 if line index didn't reach it yet
+bool Viewer::GetCurrentLine(int64_t &Line)
+{
+	ViewerLineIndex *LI = GetLineIndex();
+	if (!LI) {
+		LineIndexPending = false;
+		return false;
+	}
+
+	Line = LI->LineOfPos(FilePos * CodeUnitBytes(VM.CodePage));
+	LineIndexPending = (Line < 0);
+	return true;
+}
+
+// waits for line index to reach given position (if its not negative) or line,
+// returns line of that position or offset of that line, or -1 if there is no such or user cancelled
+int64_t Viewer::WaitLineIndex(ViewerLineIndex *LI, int64_t Line, int64_t Pos)
+{
+	wakeful W;
+	for (DWORD ShowTime = WINPORT(GetTickCount)();;) {
+		const bool Done = (LI->Indexed() == LI->FileSize());
+		const int64_t Out = (Pos >= 0) ? LI->LineOfPos(Pos) : LI->PosOfLine(Line);
+		if (Out >= 0 || Done)
+			return Out;
+
+		if (CheckForEscSilent() && ConfirmAbortOp())
+			return -1;
+
+		const DWORD CurTime = WINPORT(GetTickCount)();
+		if (CurTime - ShowTime > RedrawTimeout) {
+			ShowTime = CurTime;
+			FormatString strPercent;
+			strPercent << ToPercent64(LI->Indexed(), LI->FileSize()) << L"%";
+			Message(0, 0, Msg::ViewerGoTo, Msg::ViewerCountingLines, strPercent.strValue());
+		}
+		WINPORT(Sleep)(10);
+	}
+}
+
+// returns offset in bytes where line begins given its one-based number or distance from current line,
+// too big number means last line, returns -1 if lines are not counted or user cancelled counting
+int64_t Viewer::GoToLineOffset(int64_t Line, int64_t Relative)
+{
+	ViewerLineIndex *LI = GetLineIndex();
+	if (!LI)
+		return -1;
+
+	if (Relative) {
+		const int64_t CurLine = WaitLineIndex(LI, -1, FilePos * CodeUnitBytes(VM.CodePage));
+		if (CurLine < 0)
+			return -1;
+
+		Line = CurLine + Line * Relative;
+	} else
+		Line--;
+
+	int64_t Pos = WaitLineIndex(LI, Max(Line, (int64_t)0), -1);
+	if (Pos < 0 && LI->Indexed() == LI->FileSize())
+		Pos = LI->PosOfLine(LI->Lines() - 1);
+
+	return Pos;
+}
+
 #define RB_PRC 3
 #define RB_HEX 4
 #define RB_DEC 5
+#define RB_LIN 6
 
 void Viewer::GoTo(int ShowDlg, int64_t Offset, DWORD Flags)
 {
 	int64_t Relative = 0;
+	bool LineJump = false;
 	const wchar_t *LineHistoryName = L"ViewerOffset";
 	DialogDataEx GoToDlgData[] = {
-		{DI_DOUBLEBOX,   3, 1, 31, 7, {0}, 0,Msg::ViewerGoTo },
+		{DI_DOUBLEBOX,   3, 1, 31, 8, {0}, 0,Msg::ViewerGoTo },
 		{DI_EDIT,        5, 2, 29, 2, {(DWORD_PTR)LineHistoryName}, DIF_FOCUS | DIF_DEFAULT | DIF_HISTORY | DIF_USELASTHISTORY, L""},
 		{DI_TEXT,        3, 3, 0,  3, {0}, DIF_SEPARATOR, L""},
 		{DI_RADIOBUTTON, 5, 4, 0,  4, {0}, DIF_GROUP,     Msg::GoToPercent},
 		{DI_RADIOBUTTON, 5, 5, 0,  5, {0}, 0, Msg::GoToHex    },
-		{DI_RADIOBUTTON, 5, 6, 0,  6, {0}, 0, Msg::GoToDecimal}
+		{DI_RADIOBUTTON, 5, 6, 0,  6, {0}, 0, Msg::GoToDecimal},
+		{DI_RADIOBUTTON, 5, 7, 0,  7, {0}, 0, Msg::GoToLine   }
 	};
 	MakeDialogItemsEx(GoToDlgData, GoToDlg);
 	static int PrevMode = 0;
-	GoToDlg[3].Selected = GoToDlg[4].Selected = GoToDlg[5].Selected = 0;
+	GoToDlg[3].Selected = GoToDlg[4].Selected = GoToDlg[5].Selected = GoToDlg[6].Selected = 0;
 
-	if (VM.Hex)
+	if (VM.Hex) {
 		PrevMode = 1;
+		GoToDlg[RB_LIN].Flags|= DIF_DISABLE;
+	}
 
 	GoToDlg[PrevMode + 3].Selected = TRUE;
 	{
 		if (ShowDlg) {
 			Dialog Dlg(GoToDlg, ARRAYSIZE(GoToDlg));
 			Dlg.SetHelp(L"ViewerGotoPos");
-			Dlg.SetPosition(-1, -1, 35, 9);
+			Dlg.SetPosition(-1, -1, 35, 10);
 			Dlg.Process();
 
 			if (Dlg.GetExitCode() <= 0)
@@ -2966,12 +3171,12 @@ void Viewer::GoTo(int ShowDlg, int64_t Offset, DWORD Flags)
 
 			if (GoToDlg[1].strData.Contains(L'%'))		// он хочет процентов
 			{
-				GoToDlg[RB_HEX].Selected = GoToDlg[RB_DEC].Selected = 0;
+				GoToDlg[RB_HEX].Selected = GoToDlg[RB_DEC].Selected = GoToDlg[RB_LIN].Selected = 0;
 				GoToDlg[RB_PRC].Selected = 1;
 			} else if (!StrCmpNI(GoToDlg[1].strData, L"0x", 2) || GoToDlg[1].strData.At(0) == L'$' || GoToDlg[1].strData.Contains(L'h')
 					|| GoToDlg[1].strData.Contains(L'H'))		// он умный - hex код ввел!
 			{
-				GoToDlg[RB_PRC].Selected = GoToDlg[RB_DEC].Selected = 0;
+				GoToDlg[RB_PRC].Selected = GoToDlg[RB_DEC].Selected = GoToDlg[RB_LIN].Selected = 0;
 				GoToDlg[RB_HEX].Selected = 1;
 
 				if (!StrCmpNI(GoToDlg[1].strData, L"0x", 2))
@@ -3020,6 +3225,17 @@ void Viewer::GoTo(int ShowDlg, int64_t Offset, DWORD Flags)
 				PrevMode = 2;
 				Offset = wcstoull(GoToDlg[1].strData, nullptr, 10);
 			}
+
+			if (GoToDlg[RB_LIN].Selected) {
+				PrevMode = 3;
+				Offset = GoToLineOffset(wcstoll(GoToDlg[1].strData, nullptr, 10), Relative);
+				if (Offset < 0) {
+					Show();
+					return;
+				}
+				Relative = 0;
+				LineJump = true;
+			}
 		}		// ShowDlg
 		else {
 			Relative = Flags & VSP_RELATIVE;
@@ -3091,7 +3307,8 @@ void Viewer::GoTo(int ShowDlg, int64_t Offset, DWORD Flags)
 			FilePos = FileSize;					// там все равно ничего нету
 	}
 	// коррекция
-	AdjustFilePos();
+	if (!LineJump)	// line start is already exact
+		AdjustFilePos();
 
 	//	LastSelPos=FilePos;
 	if (!(Flags & VSP_NOREDRAW))
@@ -3101,6 +3318,17 @@ void Viewer::GoTo(int ShowDlg, int64_t Offset, DWORD Flags)
 void Viewer::AdjustFilePos()
 {
 	if (!VM.Hex) {
+		// line index knows where line begins unless its still on the way to there
+		ViewerLineIndex *LI = VM.Wrap ? nullptr : GetLineIndex();
+		if (LI) {
+			const int UnitBytes = CodeUnitBytes(VM.CodePage);
+			const int64_t LinePos = LI->PosOfLine(LI->LineOfPos(FilePos * UnitBytes));
+			if (LinePos >= 0 && FilePos - LinePos / UnitBytes < MAX_VIEWLINE) {
+				FilePos = LinePos / UnitBytes;
+				return;
+			}
+		}
+
 		wchar_t Buf[4096];
 		int64_t StartLinePos = -1, GotoLinePos = FilePos - (int64_t)sizeof(Buf) / sizeof(wchar_t);
 
@@ -3168,6 +3396,99 @@ void Viewer::SetFileSize()
 	}
 }
 
+void Viewer::SetFollowMode(bool Follow)
+{
+	FollowNotify.reset();
+
+	// processed file is a copy that doesnt change
+	if (Follow && ViewFile.Opened() && !VM.Processed && !m_bQuickView) {
+		FARString strDir = strFullFileName;
+		CutToSlash(strDir);
+		FollowNotify.reset(IFSNotify_Create(strDir.GetMB(), false, FSNW_NAMES_AND_STATS));
+		FollowFile(true);
+	}
+
+	ShowStatus();
+}
+
+/*
+	Called on idle in follow mode.
+	If file name now refers to another file, like after log rotation, then reopens it.
+	If file was truncated then rereads it, otherwise reads only what was appended.
+	View that shows end of file keeps showing it.
+	Size and identity of file are polled on each call, as notifications can't be relied on
+	for that: kqueue watches only directory entries, not appends to files, and watch may fail
+	to be set at all. Notification about file itself only tells to look if it was rewritten
+	in place keeping same size.
+*/
+void Viewer::FollowFile(bool Force)
+{
+	const std::string &PathName = strFullFileName.GetMB();
+	bool Notified = false;
+	if (FollowNotify->Check()) {
+		std::set<std::string> ChangedNames;
+		if (!FollowNotify->FetchChangedNames(ChangedNames)) {
+			// unknown what changed and watching may be over (kqueue notifies once), so start over
+			FARString strDir = strFullFileName;
+			CutToSlash(strDir);
+			FollowNotify.reset(IFSNotify_Create(strDir.GetMB(), false, FSNW_NAMES_AND_STATS));
+			Notified = true;
+
+		} else {
+			Notified = ChangedNames.find(PathName.substr(PathName.rfind(GOOD_SLASH) + 1)) != ChangedNames.end();
+		}
+	}
+
+	bool Reset = false;
+	if (ViewFile.Replaced(PathName)) {
+		// reopen only if new file can be opened, otherwise keep following old one
+		int fd = sdc_open(PathName.c_str(), O_RDONLY);
+		if (fd != -1) {
+			sdc_close(fd);
+			ViewFile.Open(PathName);
+			Reset = true;
+		}
+	}
+
+	if (!Reset && !ViewFile.ActualizeFileSize(true))
+		Reset = true;
+
+	const int64_t PrevFileSize = FileSize;
+	SetFileSize();
+
+	if (!Reset && FileSize == PrevFileSize && Notified) {
+		FAR_FIND_DATA_EX NewViewFindData;
+		if (apiGetFindDataForExactPathName(strFullFileName, NewViewFindData)
+				&& (ViewFindData.ftLastWriteTime.dwLowDateTime != NewViewFindData.ftLastWriteTime.dwLowDateTime
+						|| ViewFindData.ftLastWriteTime.dwHighDateTime
+								!= NewViewFindData.ftLastWriteTime.dwHighDateTime)) {
+			// rewritten in place, so whatever was buffered or indexed is stale
+			ViewFindData = NewViewFindData;
+			ViewFile.Clear();
+			LineIndex.reset();
+			LineIndexFileSize = (UINT64)-1;
+			Show();
+			return;
+		}
+	}
+
+	if (Reset) {
+		LineIndex.reset();
+		LineIndexFileSize = (UINT64)-1;
+		SelectSize = 0;
+
+	} else if (!Force && FileSize == PrevFileSize)
+		return;
+
+	// keep time of last seen change to tell in-place rewrite from append later
+	apiGetFindDataForExactPathName(strFullFileName, ViewFindData);
+
+	if (Force || Reset || LastPage || FilePos > FileSize)
+		ProcessKey(KEY_CTRLEND);
+	else
+		Show();
+}
+
 void Viewer::GetSelectedParam(int64_t &Pos, int64_t &Length, DWORD &Flags)
 {
 	Pos = SelectPos;
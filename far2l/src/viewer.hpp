@@ -41,6 +41,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "cache.hpp"
 #include "fileholder.hpp"
 #include "ViewerStrings.hpp"
+#include "FSNotify.h"
+#include <memory>
 
 #define VIEWER_UNDO_COUNT 64
 
@@ -53,6 +55,7 @@ enum
 
 class FileViewer;
 class KeyBar;
+class ViewerLineIndex;
 
 struct InternalViewerBookMark
 {
@@ -102,6 +105,7 @@ private:
 	FAR_FIND_DATA_EX ViewFindData;
 
 	FARString strProcessedViewName;
+	FARString strOpenedPathName;	// what ViewFile opened: strFullFileName or its processed copy
 
 	FARString strLastSearchStr;
 	int LastSearchCase, LastSearchWholeWords, LastSearchReverse, LastSearchHex, LastSearchRegexp;
@@ -144,6 +148,14 @@ private:
 
 	FileHolderPtr FHP;
 
+	std::unique_ptr<ViewerLineIndex> LineIndex;
+	UINT LineIndexCodePage = 0;
+	int LineIndexCRSym = 0;
+	UINT64 LineIndexFileSize = (UINT64)-1;	// also forces index (re)creation when doesnt match actual size
+	bool LineIndexPending = false;			// status shows line that is not indexed yet
+
+	std::unique_ptr<IFSNotify> FollowNotify;	// watches directory of file while following it
+
 private:
 	virtual void DisplayObject();
 
@@ -179,6 +191,12 @@ private:
 	void SetFileSize();
 	int GetStrBytesNum(const wchar_t *Str, int Length);
 
+	ViewerLineIndex *GetLineIndex();
+	int64_t WaitLineIndex(ViewerLineIndex *LI, int64_t Line, int64_t Pos);
+	int64_t GoToLineOffset(int64_t Line, int64_t Relative);
+
+	void FollowFile(bool Force);
+
 	FARString ComposeCacheName();
 	void SavePosCache();
 
@@ -215,6 +233,7 @@ public:
 	int64_t GetFilePos() const { return FilePos; };
 	int64_t GetViewFilePos() const { return FilePos; };
 	int64_t GetViewFileSize() const { return FileSize; };
+	bool GetCurrentLine(int64_t &Line);
 
 	void SetPluginData(const wchar_t *PluginData);
 	void SetNamesList(NamesList *List);
@@ -244,6 +263,9 @@ public:
 
 	int GetHexMode() const { return VM.Hex; }
 
+	void SetFollowMode(bool Follow);
+	bool GetFollowMode() const { return !!FollowNotify; }
+
 	UINT GetCodePage() const { return VM.CodePage; }
 
 	NamesList *GetNamesList() { return &ViewNamesList; }
@@ -158,6 +158,8 @@ private:
 	bool FarLangChanged();
 	bool EnsureFindDataUpToDate(int OpMode);
 	int ReadArchive(const char *Name, int OpMode);
+	bool LoadListingCache(const char *Name);
+	void SaveListingCache(const char *Name, DWORD ReadMSec);
 
 public:
 	PluginClass(int ArcPluginNumber);
@@ -338,6 +340,7 @@ int GetScrX(void);
 void NormalizePath(const char *SrcName, char *DestName);
 std::string &ExpandEnv(std::string &str);
 std::string &NormalizePath(std::string &path);
+bool IsSameFileStat(const struct stat &a, const struct stat &b);
 
 int WINAPI GetPassword(char *Password, const char *FileName);
 void WINAPI UnixTimeToFileTime(DWORD UnixTime, FILETIME *FileTime);
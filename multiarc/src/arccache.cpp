@@ -0,0 +1,343 @@
+#include <set>
+#include <stdexcept>
+#include <unistd.h>
+#include <crc64.h>
+#include "MultiArc.hpp"
+#include "marclng.hpp"
+
+/*
+  Persistent cache of archives listings, so reopening of huge archive that was
+  already read doesn't need to decompress it whole again. Each archive has own
+  file in cache directory named by hash of archive path. File starts from path,
+  device, inode, size and modification time of archive, so cached listing used
+  only if archive wasn't changed since it was read.
+*/
+
+#define LISTING_CACHE_MAGIC       0x4d414c02
+#define LISTING_CACHE_EXPIRATION  (60 * 60 * 24 * 30)
+
+// dont bother caching archives that were read fast enough
+#define LISTING_CACHE_MIN_READ_MSEC 500
+
+class CacheWriter
+{
+	std::string &Buf;
+
+public:
+	CacheWriter(std::string &Buf_) : Buf(Buf_) {}
+
+	void Put(const void *Data, size_t Len) { Buf.append((const char *)Data, Len); }
+
+	template <class POD>
+	void PutPOD(const POD &v) { Put(&v, sizeof(v)); }
+
+	void PutString(const std::string &s)
+	{
+		PutPOD((uint32_t)s.size());
+		Buf.append(s);
+	}
+};
+
+class CacheReader
+{
+	const std::string &Buf;
+	size_t Pos = 0;
+
+public:
+	CacheReader(const std::string &Buf_) : Buf(Buf_) {}
+
+	void Get(void *Data, size_t Len)
+	{
+		if (Len > Buf.size() - Pos)
+			throw std::runtime_error("unexpected end of data");
+		memcpy(Data, Buf.data() + Pos, Len);
+		Pos+= Len;
+	}
+
+	template <class POD>
+	void GetPOD(POD &v) { Get(&v, sizeof(v)); }
+
+	void GetString(std::string &s)
+	{
+		uint32_t Len;
+		GetPOD(Len);
+		if (Len > Buf.size() - Pos)
+			throw std::runtime_error("bad string length");
+		s.assign(Buf.data() + Pos, Len);
+		Pos+= Len;
+	}
+
+	bool AtEnd() const { return Pos == Buf.size(); }
+};
+
+struct AttributeField
+{
+	void *Ptr;
+	size_t Len;
+};
+
+// fields of ArcItemAttributes saved to cache, each only if nonzero, so mask of saved fields precedes them
+static size_t GetAttributeFields(ArcItemAttributes &Attrs, AttributeField *Fields)
+{
+	size_t n = 0;
+	Fields[n++] = {&Attrs.Solid, sizeof(Attrs.Solid)};
+	Fields[n++] = {&Attrs.Comment, sizeof(Attrs.Comment)};
+	Fields[n++] = {&Attrs.Encrypted, sizeof(Attrs.Encrypted)};
+	Fields[n++] = {&Attrs.DictSize, sizeof(Attrs.DictSize)};
+	Fields[n++] = {&Attrs.UnpVer, sizeof(Attrs.UnpVer)};
+	Fields[n++] = {&Attrs.Chapter, sizeof(Attrs.Chapter)};
+	Fields[n++] = {&Attrs.Codepage, sizeof(Attrs.Codepage)};
+	Fields[n++] = {&Attrs.dwFileAttributes, sizeof(Attrs.dwFileAttributes)};
+	Fields[n++] = {&Attrs.dwUnixMode, sizeof(Attrs.dwUnixMode)};
+	Fields[n++] = {&Attrs.Flags, sizeof(Attrs.Flags)};
+	Fields[n++] = {&Attrs.NumberOfLinks, sizeof(Attrs.NumberOfLinks)};
+	Fields[n++] = {&Attrs.CRC32, sizeof(Attrs.CRC32)};
+	Fields[n++] = {&Attrs.ftCreationTime, sizeof(Attrs.ftCreationTime)};
+	Fields[n++] = {&Attrs.ftLastAccessTime, sizeof(Attrs.ftLastAccessTime)};
+	Fields[n++] = {&Attrs.ftLastWriteTime, sizeof(Attrs.ftLastWriteTime)};
+	Fields[n++] = {&Attrs.nPhysicalSize, sizeof(Attrs.nPhysicalSize)};
+	Fields[n++] = {&Attrs.nFileSize, sizeof(Attrs.nFileSize)};
+	return n;
+}
+
+enum
+{
+	MAX_ATTRIBUTE_FIELDS = 24,
+	HAS_DESCRIPTION      = 0x01000000,
+	HAS_LINKNAME         = 0x02000000,
+	HAS_PREFIX           = 0x04000000,
+};
+
+static bool IsZeroData(const void *Ptr, size_t Len)
+{
+	for (size_t i = 0; i < Len; ++i) {
+		if (((const unsigned char *)Ptr)[i])
+			return false;
+	}
+	return true;
+}
+
+static void SaveNode(CacheWriter &w, const ArcItemNode &Node)
+{
+	AttributeField Fields[MAX_ATTRIBUTE_FIELDS];
+	const size_t FieldsCount = GetAttributeFields(const_cast<ArcItemNode &>(Node), Fields);
+
+	uint32_t Mask = 0;
+	for (size_t i = 0; i < FieldsCount; ++i) {
+		if (!IsZeroData(Fields[i].Ptr, Fields[i].Len))
+			Mask|= (1 << i);
+	}
+	if (Node.Description)
+		Mask|= HAS_DESCRIPTION;
+	if (Node.LinkName)
+		Mask|= HAS_LINKNAME;
+	if (Node.Prefix)
+		Mask|= HAS_PREFIX;
+
+	w.PutPOD(Mask);
+	for (size_t i = 0; i < FieldsCount; ++i) {
+		if (Mask & (1 << i))
+			w.Put(Fields[i].Ptr, Fields[i].Len);
+	}
+	if (Node.Description)
+		w.PutString(*Node.Description);
+	if (Node.LinkName)
+		w.PutString(*Node.LinkName);
+	if (Node.Prefix)
+		w.PutString(*Node.Prefix);
+
+	w.PutPOD((uint32_t)Node.size());
+	for (const auto &it : Node) {
+		w.PutString(it.first);
+		SaveNode(w, it.second);
+	}
+}
+
+static void LoadNode(CacheReader &r, ArcItemNode &Node)
+{
+	AttributeField Fields[MAX_ATTRIBUTE_FIELDS];
+	const size_t FieldsCount = GetAttributeFields(Node, Fields);
+
+	uint32_t Mask;
+	r.GetPOD(Mask);
+	for (size_t i = 0; i < FieldsCount; ++i) {
+		if (Mask & (1 << i))
+			r.Get(Fields[i].Ptr, Fields[i].Len);
+	}
+	if (Mask & HAS_DESCRIPTION) {
+		Node.Description.reset(new std::string);
+		r.GetString(*Node.Description);
+	}
+	if (Mask & HAS_LINKNAME) {
+		Node.LinkName.reset(new std::string);
+		r.GetString(*Node.LinkName);
+	}
+	if (Mask & HAS_PREFIX) {
+		Node.Prefix.reset(new std::string);
+		r.GetString(*Node.Prefix);
+	}
+
+	uint32_t Count;
+	r.GetPOD(Count);
+	std::string Name;
+	for (uint32_t i = 0; i < Count; ++i) {
+		r.GetString(Name);
+		// names saved in map's order, so each next one goes to the end
+		auto it = Node.emplace_hint(Node.end(), std::piecewise_construct, std::forward_as_tuple(Name),
+				std::forward_as_tuple());
+		LoadNode(r, it->second);
+	}
+}
+
+static void PutArcStat(CacheWriter &w, const struct stat &s)
+{
+	w.PutPOD((uint64_t)s.st_dev);
+	w.PutPOD((uint64_t)s.st_ino);
+	w.PutPOD((uint64_t)s.st_size);
+	w.PutPOD((int64_t)s.st_mtim.tv_sec);
+	w.PutPOD((int64_t)s.st_mtim.tv_nsec);
+}
+
+// ItemsInfo.HostOS must point to static string, so keep ones loaded from cache forever
+static const char *PooledHostOS(const std::string &HostOS)
+{
+	static std::set<std::string> s_pool;
+	return s_pool.insert(HostOS).first->c_str();
+}
+
+static std::string CacheFilePath(const char *Name, bool CreatePath)
+{
+	const std::string &SubPath = StrPrintf("multiarc/listings/%llx",
+			(unsigned long long)crc64(0, (const unsigned char *)Name, strlen(Name)));
+	return InMyCache(SubPath.c_str(), CreatePath);
+}
+
+bool IsSameFileStat(const struct stat &a, const struct stat &b)
+{
+	return a.st_dev == b.st_dev && a.st_ino == b.st_ino && a.st_size == b.st_size
+		&& a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+bool PluginClass::LoadListingCache(const char *Name)
+{
+	const std::string &Path = CacheFilePath(Name, false);
+	std::string Content;
+	if (!CachedFileLoad(Path, Content))
+		return false;
+
+	try {
+		CacheReader r(Content);
+		uint32_t Magic;
+		r.GetPOD(Magic);
+		if (Magic != LISTING_CACHE_MAGIC)
+			return false;
+
+		std::string Str;
+		r.GetString(Str);
+		if (Str != Name)
+			return false;
+
+		// compare saved stat with actual one same way it was saved
+		std::string SavedStat, ActualStat;
+		CacheWriter sw(ActualStat);
+		PutArcStat(sw, ArcStat);
+		SavedStat.resize(ActualStat.size());
+		r.Get(&SavedStat[0], SavedStat.size());
+		if (SavedStat != ActualStat)
+			return false;
+
+		int32_t PluginNumber, PluginType;
+		r.GetPOD(PluginNumber);
+		r.GetPOD(PluginType);
+		if (PluginNumber != ArcPluginNumber)
+			return false;
+
+		ArcPluginType = PluginType;
+		r.GetPOD(CurArcInfo);
+
+		ItemsInfo = ArcItemInfo{};
+		r.GetPOD(ItemsInfo.Solid);
+		r.GetPOD(ItemsInfo.Comment);
+		r.GetPOD(ItemsInfo.Encrypted);
+		r.GetPOD(ItemsInfo.DictSize);
+		r.GetPOD(ItemsInfo.UnpVer);
+		r.GetPOD(ItemsInfo.Codepage);
+		uint8_t HostOSKind;
+		r.GetPOD(HostOSKind);
+		if (HostOSKind == 1) {
+			ItemsInfo.HostOS = GetMsg(MSeveralOS);
+		} else if (HostOSKind == 2) {
+			r.GetString(Str);
+			ItemsInfo.HostOS = PooledHostOS(Str);
+		}
+
+		int32_t Diz;
+		uint64_t Count;
+		r.GetPOD(TotalSize);
+		r.GetPOD(PackedSize);
+		r.GetPOD(Diz);
+		r.GetPOD(Count);
+		DizPresent = Diz;
+		ArcDataCount = (size_t)Count;
+
+		LoadNode(r, ArcData);
+		if (!r.AtEnd())
+			throw std::runtime_error("excessive data");
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "MA::LoadListingCache('%s'): %s\n", Name, e.what());
+		FreeArcData();
+		ItemsInfo = ArcItemInfo{};
+		ZeroFill(CurArcInfo);
+		TotalSize = PackedSize = 0;
+		DizPresent = FALSE;
+		return false;
+	}
+
+	return true;
+}
+
+void PluginClass::SaveListingCache(const char *Name, DWORD ReadMSec)
+{
+	if (ReadMSec < LISTING_CACHE_MIN_READ_MSEC)
+		return;
+
+	// names in archive with encrypted headers are secret, so don't leave them in plaintext
+	if (CurArcInfo.Flags & AF_HDRENCRYPTED)
+		return;
+
+	CachedFilesPrune("multiarc/listings", LISTING_CACHE_EXPIRATION);
+
+	std::string Content;
+	CacheWriter w(Content);
+	w.PutPOD((uint32_t)LISTING_CACHE_MAGIC);
+	w.PutString(Name);
+	PutArcStat(w, ArcStat);
+	w.PutPOD((int32_t)ArcPluginNumber);
+	w.PutPOD((int32_t)ArcPluginType);
+	w.PutPOD(CurArcInfo);
+
+	w.PutPOD(ItemsInfo.Solid);
+	w.PutPOD(ItemsInfo.Comment);
+	w.PutPOD(ItemsInfo.Encrypted);
+	w.PutPOD(ItemsInfo.DictSize);
+	w.PutPOD(ItemsInfo.UnpVer);
+	w.PutPOD(ItemsInfo.Codepage);
+	if (!ItemsInfo.HostOS) {
+		w.PutPOD((uint8_t)0);
+	} else if (ItemsInfo.HostOS == GetMsg(MSeveralOS)) {
+		w.PutPOD((uint8_t)1);
+	} else {
+		w.PutPOD((uint8_t)2);
+		w.PutString(ItemsInfo.HostOS);
+	}
+
+	w.PutPOD(TotalSize);
+	w.PutPOD(PackedSize);
+	w.PutPOD((int32_t)DizPresent);
+	w.PutPOD((uint64_t)ArcDataCount);
+
+	SaveNode(w, ArcData);
+
+	CachedFileSave(CacheFilePath(Name, true), Content.data(), Content.size());
+}
@@ -54,17 +54,21 @@ int PluginClass::ReadArchive(const char *Name, int OpMode)
 	if (sdc_stat(Name, &ArcStat) == -1)
 		return FALSE;
 
-	if (!ArcPlugin->OpenArchive(ArcPluginNumber, Name, &ArcPluginType, (OpMode & OPM_SILENT) != 0))
-		return FALSE;
-
 	ItemsInfo = ArcItemInfo{};
 	ZeroFill(CurArcInfo);
 	TotalSize = PackedSize = 0;
 	ArcDataCount = 0;
 
+	if (LoadListingCache(Name))
+		return TRUE;
+
+	if (!ArcPlugin->OpenArchive(ArcPluginNumber, Name, &ArcPluginType, (OpMode & OPM_SILENT) != 0))
+		return FALSE;
+
 	HANDLE hScreen = Info.SaveScreen(0, 0, -1, -1);
 
-	DWORD UpdateTime = GetProcessUptimeMSec() + 1000;
+	const DWORD StartTime = GetProcessUptimeMSec();
+	DWORD UpdateTime = StartTime + 1000;
 	bool MessageShown = false;
 	int GetItemCode;
 
@@ -183,6 +187,8 @@ int PluginClass::ReadArchive(const char *Name, int OpMode)
 		return FALSE;	// Mantis#0001241
 	}
 
+	SaveListingCache(Name, GetProcessUptimeMSec() - StartTime);
+
 	// Info.RestoreScreen(NULL);
 	// Info.RestoreScreen(hScreen);
 	return TRUE;
@@ -196,7 +202,7 @@ bool PluginClass::EnsureFindDataUpToDate(int OpMode)
 		if (sdc_stat(ArcName, &NewArcStat) == -1)
 			return false;
 
-		if (ArcStat.st_mtime == NewArcStat.st_mtime && ArcStat.st_size == NewArcStat.st_size)
+		if (IsSameFileStat(ArcStat, NewArcStat))
 			return true;
 	}
 
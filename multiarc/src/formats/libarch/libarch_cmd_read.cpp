@@ -1,7 +1,10 @@
 #include <unistd.h>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <algorithm>
 #include <set>
+#include <unordered_map>
 #include <fcntl.h>
 #include <string.h>
 #include <ftw.h>
@@ -9,6 +12,7 @@
 #include <utils.h>
 #include <os_call.hpp>
 #include <ScopeHelpers.h>
+#include <WorkStealingPool.h>
 
 #include "libarch_utils.h"
 #include "libarch_cmd.h"
@@ -34,14 +38,207 @@ static bool PartsMatchesAnyOfWanteds(const std::vector<PathParts > &wanteds, con
 	return false;
 }
 
-static bool LIBARCH_CommandReadWanteds(const char *cmd, LibArchOpenRead &arc,
-	const size_t root_count, const std::vector<PathParts > &wanteds)
+static bool LIBARCH_ExtractEntry(LibArchOpenRead &arc, struct archive_entry *entry,
+	const std::string &src_path, const std::string &extract_path)
+{
+	archive_entry_set_pathname(entry, extract_path.c_str() );
+	int r = archive_read_extract(arc.Get(), entry, ARCHIVE_EXTRACT_TIME); // ARCHIVE_EXTRACT_PERM???
+	if (r != ARCHIVE_OK && r != ARCHIVE_WARN) {
+		fprintf(stderr, "Error %d (%s): '%s' -> '%s'\n",
+			r, archive_error_string(arc.Get()),
+			src_path.c_str(), extract_path.c_str());
+		return false;
+	}
+
+	fprintf(stderr, "Extracted: '%s' -> '%s'\n",
+		src_path.c_str(), extract_path.c_str());
+	return true;
+}
+
+///////// Parallel extraction: in zip and not compressed as whole tar archives entries are
+// stored independently, so while reading headers regular files are only remembered,
+// and then extracted concurrently by several readers, each handling own contiguous range
+// of entries and seeking over entries before it. Directories, symlinks etc are still
+// extracted in order by main reader, except of hard links that may refer to remembered
+// files, so they're created after all remembered files extracted.
+
+// dont bother threads for small amount of data
+#define PARALLEL_EXTRACT_MIN_SIZE   0x400000
+
+struct DeferredEntry
+{
+	size_t index; // ordinal number of entry's header in archive
+	int64_t size; // negative if superseded by later entry with same path
+	std::string src_path, extract_path;
+};
+
+struct DeferredLink
+{
+	std::shared_ptr<struct archive_entry> entry;
+	std::string src_path, extract_path;
+};
+
+static bool LIBARCH_CanExtractInParallel(const char *cmd, LibArchOpenRead &arc)
+{
+	if (*cmd != 'x' && *cmd != 'X' && *cmd != 't') {
+		return false;
+	}
+
+	// skipping entries must be a seek, not decompression, otherwise each reader
+	// would decompress everything before its range again
+	for (int i = 0, ii = archive_filter_count(arc.Get()); i < ii; ++i) {
+		if (archive_filter_code(arc.Get(), i) != ARCHIVE_FILTER_NONE) {
+			return false;
+		}
+	}
+
+	// 7z is not here as libarchive doesn't tell if its solid, and most are
+	return ((arc.Format() & ARCHIVE_FORMAT_BASE_MASK) == ARCHIVE_FORMAT_ZIP
+		|| (arc.Format() & ARCHIVE_FORMAT_BASE_MASK) == ARCHIVE_FORMAT_TAR);
+}
+
+static bool LIBARCH_CanDeferEntry(struct archive_entry *entry)
+{
+	if (archive_entry_filetype(entry) != AE_IFREG || archive_entry_hardlink(entry) != nullptr
+	  || archive_entry_size(entry) <= 0) {
+		return false;
+	}
+
+#if (ARCHIVE_VERSION_NUMBER >= 3002000)
+	// concurrent readers must not ask password interactively
+	if (archive_entry_is_encrypted(entry) && !LibArch_HasPassprhase()) {
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+static bool LIBARCH_ExtractDeferredRange(const char *cmd, const char *arc_path,
+	const LibarchCommandOptions &arc_opts, unsigned int fmt,
+	const std::vector<DeferredEntry> &deferred, size_t begin, size_t end)
+{
+	try {
+		LibArchOpenRead arc(arc_path, cmd, arc_opts.charset.c_str());
+		if (arc.Format() != fmt) {
+			throw std::runtime_error(StrPrintf("format mismatch 0x%x != 0x%x", arc.Format(), fmt));
+		}
+
+		bool out = true;
+		for (size_t index = 0; begin != end; ++index) {
+			struct archive_entry *entry = arc.NextHeader();
+			if (!entry) {
+				throw std::runtime_error("unexpected end of archive");
+			}
+
+			if (index != deferred[begin].index) {
+				arc.SkipData();
+				continue;
+			}
+
+			if (!LIBARCH_ExtractEntry(arc, entry, deferred[begin].src_path, deferred[begin].extract_path)) {
+				out = false;
+			}
+			++begin;
+		}
+
+		return out;
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "Exception: %s - while extracting '%s'\n",
+			e.what(), deferred[begin].src_path.c_str());
+	}
+
+	return false;
+}
+
+static bool LIBARCH_ExtractDeferred(const char *cmd, const char *arc_path,
+	const LibarchCommandOptions &arc_opts, unsigned int fmt, const std::vector<DeferredEntry> &deferred)
+{
+	int64_t total_size = 0;
+	for (const auto &de : deferred) {
+		total_size+= de.size;
+	}
+
+	WorkStealingPool pool(total_size < PARALLEL_EXTRACT_MIN_SIZE ? 1 : 0);
+	const size_t ranges = std::min(pool.ThreadsCount(), deferred.size());
+
+	// split entries into ranges of roughly same total size
+	std::atomic<bool> out{true};
+	size_t begin = 0;
+	int64_t passed_size = 0;
+	for (size_t r = 1; r <= ranges; ++r) {
+		const int64_t range_edge = (total_size * (int64_t)r) / (int64_t)ranges;
+		size_t end = begin;
+		while (end < deferred.size() && (r == ranges || end == begin || passed_size < range_edge)) {
+			passed_size+= deferred[end].size;
+			++end;
+		}
+
+		if (begin != end) {
+			pool.Queue([cmd, arc_path, &arc_opts, fmt, &deferred, begin, end, &out]() {
+				if (!LIBARCH_ExtractDeferredRange(cmd, arc_path, arc_opts, fmt, deferred, begin, end)) {
+					out = false;
+				}
+			});
+		}
+		begin = end;
+	}
+
+	pool.Wait();
+	return out;
+}
+
+static bool LIBARCH_ExtractDeferredLinks(const std::vector<DeferredLink> &links)
+{
+	struct archive *ext = archive_write_disk_new();
+	if (!ext) {
+		fprintf(stderr, "Failed to create disk writer for %lu hard links\n", (unsigned long)links.size());
+		return false;
+	}
+
+	// same as archive_read_extract does for entries without data
+	archive_write_disk_set_options(ext, ARCHIVE_EXTRACT_TIME);
+	archive_write_disk_set_standard_lookup(ext);
+
+	bool out = true;
+	for (const auto &dl : links) {
+		archive_entry_set_pathname(dl.entry.get(), dl.extract_path.c_str());
+		int r = archive_write_header(ext, dl.entry.get());
+		if (r == ARCHIVE_OK || r == ARCHIVE_WARN) {
+			r = archive_write_finish_entry(ext);
+		}
+		if (r != ARCHIVE_OK && r != ARCHIVE_WARN) {
+			fprintf(stderr, "Error %d (%s): '%s' -> '%s'\n",
+				r, archive_error_string(ext), dl.src_path.c_str(), dl.extract_path.c_str());
+			out = false;
+
+		} else {
+			fprintf(stderr, "Extracted: '%s' -> '%s'\n",
+				dl.src_path.c_str(), dl.extract_path.c_str());
+		}
+	}
+
+	archive_write_free(ext);
+	return out;
+}
+
+/////////
+
+static bool LIBARCH_CommandReadWanteds(const char *cmd, LibArchOpenRead &arc, const char *arc_path,
+	const LibarchCommandOptions &arc_opts, const size_t root_count, const std::vector<PathParts > &wanteds)
 {
 	std::string src_path, extract_path;
 	PathParts parts;
+	std::vector<DeferredEntry> deferred;
+	std::vector<DeferredLink> deferred_links;
+	const bool parallel = LIBARCH_CanExtractInParallel(cmd, arc);
+	// if archive has several entries with same path - last one must win, like on sequential extraction
+	std::unordered_map<std::string, size_t> deferred_paths;
+	bool deferred_superseded = false;
 
 	bool out = true;
-	for (;;) {
+	for (size_t index = 0;; ++index) {
 		struct archive_entry *entry = arc.NextHeader();
 		if (!entry) {
 			break;
@@ -91,26 +288,59 @@ static bool LIBARCH_CommandReadWanteds(const char *cmd, LibArchOpenRead &arc,
 				extract_path = "/dev/null";
 		}
 
-		archive_entry_set_pathname(entry, extract_path.c_str() );
-		int r = archive_read_extract(arc.Get(), entry, ARCHIVE_EXTRACT_TIME); // ARCHIVE_EXTRACT_PERM???
-		if (r != ARCHIVE_OK && r != ARCHIVE_WARN) {
-			fprintf(stderr, "Error %d (%s): '%s' -> '%s'\n",
-				r, archive_error_string(arc.Get()),
-				src_path.c_str(), extract_path.c_str());
+		if (!deferred.empty() && *cmd != 't') {
+			auto it = deferred_paths.find(extract_path);
+			if (it != deferred_paths.end()) {
+				deferred[it->second].size = -1;
+				deferred_superseded = true;
+				deferred_paths.erase(it);
+			}
+			deferred_links.erase(std::remove_if(deferred_links.begin(), deferred_links.end(),
+				[&](const DeferredLink &dl) { return dl.extract_path == extract_path; }), deferred_links.end());
+		}
+
+		const bool single_wanted = (wanteds.size() == 1 && wanteds[0] == parts);
+		if (parallel && !single_wanted && LIBARCH_CanDeferEntry(entry)) {
+			if (*cmd != 't') {
+				deferred_paths[extract_path] = deferred.size();
+			}
+			deferred.emplace_back(DeferredEntry{index, archive_entry_size(entry), src_path, extract_path});
+			arc.SkipData();
+
+		} else if (!deferred.empty() && *cmd != 't' && archive_entry_hardlink(entry) != nullptr
+				&& archive_entry_size(entry) <= 0) {
+			// its target may be not extracted yet
+			std::shared_ptr<struct archive_entry> link(archive_entry_clone(entry), archive_entry_free);
+			if (!link) {
+				throw std::runtime_error("failed to clone archive entry");
+			}
+			deferred_links.emplace_back(DeferredLink{link, src_path, extract_path});
+			arc.SkipData();
+
+		} else if (!LIBARCH_ExtractEntry(arc, entry, src_path, extract_path)) {
 			out = false;
 
 		} else {
-			fprintf(stderr, "Extracted: '%s' -> '%s'\n",
-				src_path.c_str(), extract_path.c_str());
-
 		    struct stat s;
-			if (wanteds.size() == 1 && wanteds[0] == parts
-			  && stat(extract_path.c_str(), &s) == 0 && !S_ISDIR(s.st_mode)) {
+			if (single_wanted && stat(extract_path.c_str(), &s) == 0 && !S_ISDIR(s.st_mode)) {
 				break; // nothing to search more here
 			}
 		}
 	}
 
+	if (deferred_superseded) {
+		deferred.erase(std::remove_if(deferred.begin(), deferred.end(),
+			[](const DeferredEntry &de) { return de.size < 0; }), deferred.end());
+	}
+
+	if (!deferred.empty() && !LIBARCH_ExtractDeferred(cmd, arc_path, arc_opts, arc.Format(), deferred)) {
+		out = false;
+	}
+
+	if (!deferred_links.empty() && !LIBARCH_ExtractDeferredLinks(deferred_links)) {
+		out = false;
+	}
+
 	return out;
 }
 
@@ -147,5 +377,5 @@ bool LIBARCH_CommandRead(const char *cmd, const char *arc_path, const LibarchCom
 	}
 
 	LibArchOpenRead arc(arc_path, cmd, arc_opts.charset.c_str());
-	return LIBARCH_CommandReadWanteds(cmd, arc, root.size(), wanteds);
+	return LIBARCH_CommandReadWanteds(cmd, arc, arc_path, arc_opts, root.size(), wanteds);
 }
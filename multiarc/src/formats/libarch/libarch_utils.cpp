@@ -23,6 +23,11 @@ void LibArch_SetPassprhase(const char *passprhase)
 	s_passprhase_is_set = true;
 }
 
+bool LibArch_HasPassprhase()
+{
+	return s_passprhase_is_set;
+}
+
 static const char *LibArch_PassprhaseCallback(struct archive *, void *_client_data)
 {
 	return s_passprhase_is_set ? s_passprhase.c_str() : getpass("Password please:");
@@ -34,6 +39,11 @@ void LibArch_SetPassprhase(const char *passprhase)
 	fprintf(stderr, "Used libarchive doesn't support passworded archives, please rebuild with libarchive version 3.2.0 or higher.\n");
 }
 
+bool LibArch_HasPassprhase()
+{
+	return false;
+}
+
 #endif
 
 ///
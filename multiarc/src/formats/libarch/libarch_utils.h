@@ -33,6 +33,9 @@ public:
 
 void LibArch_SetPassprhase(const char *passprhase);
 
+// true if passphrase was given in advance, so it will not be asked interactively
+bool LibArch_HasPassprhase();
+
 const char *LibArch_EntryPathname(struct archive_entry *e);
 
 bool LibArch_DetectedFormatHasCompression(struct archive *a);
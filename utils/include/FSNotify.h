@@ -1,10 +1,19 @@
 #pragma once
 #include <string>
+#include <set>
 
 struct IFSNotify
 {
 	virtual ~IFSNotify() {};
 	virtual bool Check() const noexcept = 0;
+
+	/// Moves into names set names of watched directory's entries that changed since
+	/// creation or previous fetch and resets notification state so Check() returns
+	/// false until next change. Returns false if changes can't be represented as
+	/// names list - due to notifications queue overflow, too many changes, changes
+	/// of directory itself or inside of watched subtree or if backend can't report
+	/// names at all. In such case caller should reread whole directory.
+	virtual bool FetchChangedNames(std::set<std::string> &names) noexcept = 0;
 };
 
 enum FSNotifyWhat
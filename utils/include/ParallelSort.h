@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "WorkStealingPool.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+/// Sorts vector using several threads: first its chunks sorted independently,
+/// then sorted chunks merged pairwise, each merge split into several independent
+/// parts so all threads remain busy till the very last merge.
+/// Its merge sort all the way down, so elements that compare equal keep their
+/// relative order only within same chunk and comparator that is not strictly
+/// consistent (like user supplied one) may give weird order but never causes
+/// out of bounds access, unlike std::sort.
+/// Small vectors or threads_count == 1 sorted in caller thread.
+template <class T, class LessT>
+	void ParallelSort(std::vector<T> &v, const LessT &less, size_t threads_count = 0)
+{
+	enum { MIN_CHUNK_SIZE = 0x4000 };
+
+	if (!threads_count) {
+		threads_count = BestThreadsCount();
+	}
+
+	size_t chunks = 1;
+	while (chunks < threads_count && v.size() / (chunks * 2) >= MIN_CHUNK_SIZE) {
+		chunks*= 2;
+	}
+
+	if (chunks < 2) {
+		std::stable_sort(v.begin(), v.end(), less);
+		return;
+	}
+
+	std::vector<size_t> bounds(chunks + 1);
+	for (size_t i = 0; i <= chunks; ++i) {
+		bounds[i] = (v.size() * i) / chunks;
+	}
+
+	WorkStealingPool pool(std::min(threads_count, chunks));
+	for (size_t i = 0; i < chunks; ++i) {
+		pool.Queue([&v, &less, &bounds, i]() {
+			std::stable_sort(v.begin() + bounds[i], v.begin() + bounds[i + 1], less);
+		});
+	}
+	pool.Wait();
+
+	std::vector<T> tmp(v.size());
+	std::vector<T> *src = &v, *dst = &tmp;
+	for (size_t width = 1; width < chunks; width*= 2) {
+		const size_t parts = width * 2; // each merge split into this count of parts
+		for (size_t i = 0; i < chunks; i+= width * 2) {
+			const size_t lo = bounds[i], mid = bounds[i + width], hi = bounds[i + width * 2];
+			for (size_t part = 0; part < parts; ++part) {
+				pool.Queue([src, dst, &less, lo, mid, hi, part, parts]() {
+					// part takes its share of left run and all elements of right
+					// run that are not less than start of that share and less than
+					// start of next share, so parts' outputs are adjacent and ordered
+					const size_t a_begin = lo + ((mid - lo) * part) / parts;
+					const size_t a_end = lo + ((mid - lo) * (part + 1)) / parts;
+					const auto b_first = src->begin() + mid, b_last = src->begin() + hi;
+					const auto b_begin = (part == 0) ? b_first
+						: std::lower_bound(b_first, b_last, (*src)[a_begin], less);
+					const auto b_end = (part + 1 == parts) ? b_last
+						: std::lower_bound(b_first, b_last, (*src)[a_end], less);
+					std::merge(src->begin() + a_begin, src->begin() + a_end, b_begin, b_end,
+						dst->begin() + a_begin + (b_begin - b_first), less);
+				});
+			}
+		}
+		pool.Wait();
+		std::swap(src, dst);
+	}
+
+	if (src != &v) {
+		v.swap(tmp);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include "Threaded.h"
+
+class WorkStealingWorker;
+
+////////////////////////////////////////////////////////////////////////////////////
+/// Following class implements thread pool with per-worker jobs deques.
+/// Job queued from inside of some worker's job goes to the back of that worker's
+/// deque and processed by that worker in LIFO order, so recursive depth-first
+/// workloads (like directory tree walking) keep their locality. Idle workers steal
+/// oldest jobs from front of other workers' deques. Jobs queued from non-worker
+/// threads distributed across workers in round-robin manner.
+/// Unlike ThreadedWorkQueue there is no ordering of jobs completion - if caller
+/// needs results in some particular order - it must arrange that by itself.
+class WorkStealingPool
+{
+	friend class WorkStealingWorker;
+
+	std::mutex _mtx;
+	std::condition_variable _cond;
+	std::condition_variable _idle_cond;
+	std::vector<std::unique_ptr<WorkStealingWorker>> _workers;
+	size_t _queued = 0;  // count of jobs residing in workers deques
+	size_t _pending = 0; // count of jobs queued but not yet completed
+	size_t _round_robin = 0;
+	size_t _steals = 0;
+	bool _stopping = false;
+
+	void WorkerThreadProc(size_t self);
+	bool PopJob(size_t self, std::function<void()> &job, bool &stolen);
+	void JobDone();
+
+public:
+	/// If threads_count is positive then it specifies count of threads that will process jobs
+	/// If threads_count is == 0 then this count set to online CPU-s count
+	WorkStealingPool(size_t threads_count = 0);
+
+	/// Discards all not yet started jobs and waits for completion of currently running ones.
+	virtual ~WorkStealingPool();
+
+	/// Queues job for asynchronous processing, may be invoked from any thread, including
+	/// pool's own workers - in such case job goes to deque of worker that queued it.
+	void Queue(std::function<void()> &&job);
+
+	/// Waits until all queued jobs completed, including jobs queued by jobs themselves.
+	void Wait();
+
+	/// Same as Wait() but gives up after msec milliseconds, returns true if all jobs completed.
+	bool Wait(unsigned int msec);
+
+	/// Discards all jobs that are queued but not yet started.
+	void Discard();
+
+	inline size_t ThreadsCount() const { return _workers.size(); }
+};
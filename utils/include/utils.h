@@ -134,6 +134,14 @@ std::string InMyConfig(const char *subpath = NULL, bool create_path = true);
 std::string InMyCache(const char *subpath = NULL, bool create_path = true);
 std::string InMyTemp(const char *subpath = NULL);
 
+// Persistent cache files helpers, path is expected to be obtained from InMyCache.
+// Loading touches file, so its modification time is time of last use, and saving is done via
+// temporary file renamed into path, so concurrent readers never see partially written content.
+bool CachedFileLoad(const std::string &path, std::string &content);
+bool CachedFileSave(const std::string &path, const void *data, size_t len);
+// removes files not used for more than max_age seconds from InMyCache(subpath), once per subpath per process lifetime
+void CachedFilesPrune(const char *subpath, time_t max_age);
+
 bool IsPathIn(const wchar_t *path, const wchar_t *root);
 
 bool TranslateInstallPath_Bin2Share(std::wstring &path);
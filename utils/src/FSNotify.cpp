@@ -1,6 +1,7 @@
 #include <set>
 #include <vector>
 #include <atomic>
+#include <mutex>
 #if defined(__APPLE__) || defined(__FreeBSD__) || defined(__DragonFly__)
 # include <sys/types.h>
 # include <sys/event.h>
@@ -29,6 +30,7 @@ class FSNotify : public IFSNotify
 	public:
 		FSNotify(const std::string &pathname, bool watch_subtree, FSNotifyWhat what) {}
 		virtual bool Check() const noexcept { return false; }
+		virtual bool FetchChangedNames(std::set<std::string> &names) noexcept { return false; }
 };
 
 #else
@@ -46,6 +48,38 @@ class FSNotify : public IFSNotify
 	std::atomic<bool> _change_notified{false};
 	int _pipe[2];
 
+	// if count of changed names exceeds this limit then its cheaper to reread whole directory
+	enum { CHANGED_NAMES_LIMIT = 0x1000 };
+
+	std::mutex _names_mtx;
+	std::set<std::string> _changed_names;
+	bool _changed_names_overflow{false};
+#if !defined(__APPLE__) && !defined(__FreeBSD__) && !defined(__DragonFly__)
+	int _root_watch{-1};
+
+	void OnEvent(const struct inotify_event *ie)
+	{
+		//fprintf(stderr, "WatcherProc: triggered by %s\n", ie->name);
+		std::lock_guard<std::mutex> lock(_names_mtx);
+		if (!_changed_names_overflow) {
+			if ((ie->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED | IN_UNMOUNT)) != 0
+					|| ie->wd != _root_watch || ie->len == 0 || !ie->name[0]) {
+				_changed_names_overflow = true;
+
+			} else {
+				_changed_names.emplace(ie->name);
+				if (_changed_names.size() > CHANGED_NAMES_LIMIT) {
+					_changed_names_overflow = true;
+				}
+			}
+			if (_changed_names_overflow) {
+				_changed_names.clear();
+			}
+		}
+		_change_notified = true;
+	}
+#endif
+
 
 	void AddWatch(const char *path)
 	{
@@ -125,9 +159,10 @@ class FSNotify : public IFSNotify
 			}
 		}
 #else
+		// read as many events as possible at once, single event never exceeds NAME_MAX
 		union {
 			struct inotify_event ie;
-			char space[ sizeof(struct inotify_event) + NAME_MAX + 10 ];
+			char space[ 0x10 * (sizeof(struct inotify_event) + NAME_MAX + 1) ];
 		} buf = {};
 
 		fd_set rfds;
@@ -140,10 +175,16 @@ class FSNotify : public IFSNotify
 				break;
 
 			if (FD_ISSET(_fd, &rfds)) {
-				r = read(_fd, &buf, sizeof(buf) - 1);
+				r = read(_fd, &buf, sizeof(buf));
 				if (r > 0) {
-					//fprintf(stderr, "WatcherProc: triggered by %s\n", buf.ie.name);
-					_change_notified = true;
+					for (size_t ofs = 0; ofs + sizeof(struct inotify_event) <= (size_t)r; ) {
+						const struct inotify_event *ie = (const struct inotify_event *)&buf.space[ofs];
+						ofs+= sizeof(struct inotify_event) + ie->len;
+						if (ofs > (size_t)r) {
+							break;
+						}
+						OnEvent(ie);
+					}
 
 				} else if (errno != EAGAIN && errno != EINTR) {
 					fprintf(stderr, "WatcherProc: event read error %u\n", errno);
@@ -178,6 +219,11 @@ public:
 #endif
 
 		AddWatch(pathname.c_str());
+#if !defined(__APPLE__) && !defined(__FreeBSD__) && !defined(__DragonFly__)
+		if (!_watches.empty()) {
+			_root_watch = _watches.front();
+		}
+#endif
 		if (watch_subtree) {
 			AddWatchRecursive(pathname, 0);
 		}
@@ -242,6 +288,25 @@ public:
 	{
 		return _change_notified;
 	}
+
+	virtual bool FetchChangedNames(std::set<std::string> &names) noexcept
+	{
+		std::lock_guard<std::mutex> lock(_names_mtx);
+		_change_notified = false;
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__DragonFly__)
+		// kqueue tells only that something changed, but not what exactly
+		return false;
+#else
+		if (_changed_names_overflow || !_watching) {
+			_changed_names_overflow = false;
+			_changed_names.clear();
+			return false;
+		}
+		names.clear();
+		names.swap(_changed_names);
+		return true;
+#endif
+	}
 };
 
 #endif
@@ -1,6 +1,10 @@
 #include "utils.h"
+#include <set>
+#include <mutex>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
 #include <time.h>
 #include <unistd.h>
 #include <pwd.h>
@@ -8,6 +12,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include "EnsureDir.h"
+#include "ScopeHelpers.h"
 
 static std::string GetTempSubdirUncached(const char *what)
 {
@@ -230,3 +235,74 @@ std::string InMyTemp(const char *subpath)
 
 	return path;
 }
+
+bool CachedFileLoad(const std::string &path, std::string &content)
+{
+	if (!ReadWholeFile(path.c_str(), content)) {
+		return false;
+	}
+
+	utimes(path.c_str(), NULL);
+	return true;
+}
+
+bool CachedFileSave(const std::string &path, const void *data, size_t len)
+{
+	std::string tmp_path = path;
+	tmp_path+= ".XXXXXX";
+	FDScope fd(mkstemp(&tmp_path[0]));
+	if (!fd.Valid()) {
+		fprintf(stderr, "%s: can't create '%s' errno=%d\n", __FUNCTION__, tmp_path.c_str(), errno);
+		return false;
+	}
+
+	if (WriteAll(fd, data, len) != len) {
+		fprintf(stderr, "%s: can't write '%s' errno=%d\n", __FUNCTION__, tmp_path.c_str(), errno);
+		fd.CheckedClose();
+		unlink(tmp_path.c_str());
+		return false;
+	}
+
+	fd.CheckedClose();
+	if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+		fprintf(stderr, "%s: can't rename '%s' errno=%d\n", __FUNCTION__, tmp_path.c_str(), errno);
+		unlink(tmp_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void CachedFilesPrune(const char *subpath, time_t max_age)
+{
+	static std::set<std::string> s_pruned;
+	static std::mutex s_pruned_mutex;
+	{
+		std::lock_guard<std::mutex> locker(s_pruned_mutex);
+		if (!s_pruned.insert(subpath).second) {
+			return;
+		}
+	}
+
+	const std::string &dir = InMyCache(subpath, false);
+	DIR *d = opendir(dir.c_str());
+	if (!d) {
+		return;
+	}
+
+	const time_t now = time(NULL);
+	std::string path;
+	while (struct dirent *de = readdir(d)) {
+		if (de->d_name[0] == '.') {
+			continue;
+		}
+		path = dir;
+		path+= GOOD_SLASH;
+		path+= de->d_name;
+		struct stat s{};
+		if (stat(path.c_str(), &s) == 0 && S_ISREG(s.st_mode) && now - s.st_mtime > max_age) {
+			unlink(path.c_str());
+		}
+	}
+	closedir(d);
+}
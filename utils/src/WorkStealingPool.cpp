@@ -0,0 +1,241 @@
+#include "WorkStealingPool.h"
+#include "debug.h"
+#include <stdio.h>
+#include <stdexcept>
+#include <chrono>
+
+class WorkStealingWorker : public Threaded
+{
+	WorkStealingPool *_pool;
+	size_t _index;
+
+	virtual void *ThreadProc()
+	{
+		_pool->WorkerThreadProc(_index);
+		return nullptr;
+	}
+
+public:
+	std::mutex Mtx;
+	std::deque<std::function<void()>> Jobs;
+
+	WorkStealingWorker(WorkStealingPool *pool, size_t index) : _pool(pool), _index(index)
+	{
+	}
+
+	void Start()
+	{
+		if (!StartThread()) {
+			throw std::runtime_error("StartThread failed");
+		}
+	}
+
+	virtual ~WorkStealingWorker()
+	{
+		WaitThread();
+	}
+
+	void Join()
+	{
+		WaitThread();
+	}
+
+	bool BelongsTo(const WorkStealingPool *pool) const { return _pool == pool; }
+	size_t Index() const { return _index; }
+};
+
+static thread_local WorkStealingWorker *s_current_worker = nullptr;
+
+WorkStealingPool::WorkStealingPool(size_t threads_count)
+{
+	if (!threads_count) {
+		threads_count = BestThreadsCount();
+	}
+
+	_workers.reserve(threads_count);
+	for (size_t i = 0; i < threads_count; ++i) {
+		_workers.emplace_back(new WorkStealingWorker(this, i));
+	}
+
+	// start threads only after all workers are constructed cuz they may
+	// immediately start accessing other workers deques trying to steal jobs
+	for (size_t i = 0; i < _workers.size(); ++i) try {
+		_workers[i]->Start();
+
+	} catch (std::exception &e) {
+		fprintf(stderr, "%s: %s\n", __FUNCTION__, e.what());
+		_workers.resize(i);
+		break;
+	}
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	Discard();
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		_stopping = true;
+		_cond.notify_all();
+	}
+	// join all workers before destroying any of them cuz
+	// till exit they may try to steal from each other
+	for (auto &w : _workers) {
+		w->Join();
+	}
+	// jobs being processed at the moment of first Discard() could queue more jobs
+	Discard();
+	const size_t workers_count = _workers.size();
+	_workers.clear();
+	ASSERT(_pending == 0);
+
+	fprintf(stderr, "%s: threads=%lu steals=%lu\n",
+		__FUNCTION__, (unsigned long)workers_count, (unsigned long)_steals);
+}
+
+void WorkStealingPool::Queue(std::function<void()> &&job)
+{
+	if (_workers.empty()) {
+		// no workers? fallback to synchronous processing
+		try {
+			job();
+		} catch (std::exception &e) {
+			fprintf(stderr, "%s/job: %s\n", __FUNCTION__, e.what());
+		}
+		return;
+	}
+
+	size_t target;
+	WorkStealingWorker *cw = s_current_worker;
+	std::unique_lock<std::mutex> lock(_mtx);
+	if (cw && cw->BelongsTo(this)) {
+		target = cw->Index();
+	} else {
+		target = (_round_robin++) % _workers.size();
+	}
+	++_queued;
+	++_pending;
+	{
+		std::lock_guard<std::mutex> worker_lock(_workers[target]->Mtx);
+		_workers[target]->Jobs.emplace_back(std::move(job));
+	}
+	_cond.notify_one();
+}
+
+void WorkStealingPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	while (_pending != 0) {
+		_idle_cond.wait(lock);
+	}
+}
+
+bool WorkStealingPool::Wait(unsigned int msec)
+{
+	std::unique_lock<std::mutex> lock(_mtx);
+	if (_pending != 0) {
+		_idle_cond.wait_for(lock, std::chrono::milliseconds(msec), [this]() { return _pending == 0; });
+	}
+	return _pending == 0;
+}
+
+void WorkStealingPool::Discard()
+{
+	size_t discarded = 0;
+	for (auto &w : _workers) {
+		std::deque<std::function<void()>> jobs;
+		{
+			std::lock_guard<std::mutex> worker_lock(w->Mtx);
+			jobs.swap(w->Jobs);
+		}
+		discarded+= jobs.size();
+	}
+
+	if (discarded) {
+		std::unique_lock<std::mutex> lock(_mtx);
+		ASSERT(_queued >= discarded && _pending >= discarded);
+		_queued-= discarded;
+		_pending-= discarded;
+		if (_pending == 0) {
+			_idle_cond.notify_all();
+		}
+	}
+}
+
+// invoked from worker thread without _mtx held, note that _mtx must never be
+// acquired while holding worker's Mtx cuz Queue() acquires them in opposite order
+bool WorkStealingPool::PopJob(size_t self, std::function<void()> &job, bool &stolen)
+{
+	stolen = false;
+	{
+		auto &w = *_workers[self];
+		std::lock_guard<std::mutex> worker_lock(w.Mtx);
+		if (!w.Jobs.empty()) {
+			job = std::move(w.Jobs.back());
+			w.Jobs.pop_back();
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < _workers.size(); ++i) {
+		auto &w = *_workers[(self + i) % _workers.size()];
+		std::lock_guard<std::mutex> worker_lock(w.Mtx);
+		if (!w.Jobs.empty()) {
+			job = std::move(w.Jobs.front());
+			w.Jobs.pop_front();
+			stolen = true;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void WorkStealingPool::JobDone()
+{
+	std::lock_guard<std::mutex> lock(_mtx);
+	ASSERT(_pending != 0);
+	if (--_pending == 0) {
+		_idle_cond.notify_all();
+	}
+}
+
+void WorkStealingPool::WorkerThreadProc(size_t self)
+{
+	s_current_worker = _workers[self].get();
+
+	for (;;) {
+		std::function<void()> job;
+		bool stolen;
+		if (PopJob(self, job, stolen)) {
+			bool stopping;
+			{
+				std::lock_guard<std::mutex> lock(_mtx);
+				--_queued;
+				if (stolen) {
+					++_steals;
+				}
+				stopping = _stopping;
+			}
+			if (!stopping) try {
+				job();
+			} catch (std::exception &e) {
+				fprintf(stderr, "%s/job: %s\n", __FUNCTION__, e.what());
+			}
+			job = nullptr; // release captured state before reporting completion
+			JobDone();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_mtx);
+		if (_stopping) {
+			break;
+		}
+		// _queued may remain nonzero for a short while after some other worker
+		// already popped last job but didn't decrement counter yet, so just retry
+		if (_queued == 0) {
+			_cond.wait(lock);
+		}
+	}
+
+	s_current_worker = nullptr;
+}